@@ -0,0 +1,201 @@
+/* acai_backend.cpp
+ *
+ * This file is part of the ACAI library.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#include <acai_backend.h>
+
+#include <epicsAtomic.h>
+
+#include <buffered_callbacks.h>
+#include <acai_handle_table.h>
+
+// The channel access backend functions. These are wrapped, as opposed to
+// referencing the ca_xxx functions directly, as on some platforms the channel
+// access functions have a non default calling convention.
+//
+//------------------------------------------------------------------------------
+//
+static int caCreateChannel (const char* pvName, caCh* connectionHandler,
+                            void* puser, capri priority, chid* pChannelId)
+{
+   return ca_create_channel (pvName, connectionHandler, puser, priority, pChannelId);
+}
+
+//------------------------------------------------------------------------------
+//
+static int caClearChannel (chid channelId)
+{
+   return ca_clear_channel (channelId);
+}
+
+//------------------------------------------------------------------------------
+//
+static short caFieldType (chid channelId)
+{
+   return ca_field_type (channelId);
+}
+
+//------------------------------------------------------------------------------
+//
+static unsigned long caElementCount (chid channelId)
+{
+   return ca_element_count (channelId);
+}
+
+//------------------------------------------------------------------------------
+//
+static enum channel_state caState (chid channelId)
+{
+   return ca_state (channelId);
+}
+
+//------------------------------------------------------------------------------
+//
+static unsigned caReadAccess (chid channelId)
+{
+   return ca_read_access (channelId);
+}
+
+//------------------------------------------------------------------------------
+//
+static unsigned caWriteAccess (chid channelId)
+{
+   return ca_write_access (channelId);
+}
+
+//------------------------------------------------------------------------------
+//
+static void caGetHostName (chid channelId, char* buffer, unsigned length)
+{
+   ca_get_host_name (channelId, buffer, length);
+}
+
+//------------------------------------------------------------------------------
+//
+static void* caPuser (chid channelId)
+{
+   return ca_puser (channelId);
+}
+
+//------------------------------------------------------------------------------
+//
+static int caArrayGetCallback (chtype type, unsigned long count, chid channelId,
+                               caEventCallBackFunc* handler, void* arg)
+{
+   return ca_array_get_callback (type, count, channelId, handler, arg);
+}
+
+//------------------------------------------------------------------------------
+//
+static int caCreateSubscription (chtype type, unsigned long count, chid channelId,
+                                 long mask, caEventCallBackFunc* handler, void* arg,
+                                 evid* pEventId)
+{
+   return ca_create_subscription (type, count, channelId, mask, handler, arg, pEventId);
+}
+
+//------------------------------------------------------------------------------
+//
+static int caClearSubscription (evid eventId)
+{
+   return ca_clear_subscription (eventId);
+}
+
+//------------------------------------------------------------------------------
+//
+static int caArrayPut (chtype type, unsigned long count, chid channelId,
+                       const void* pValue)
+{
+   return ca_array_put (type, count, channelId, pValue);
+}
+
+//------------------------------------------------------------------------------
+//
+static int caArrayPutCallback (chtype type, unsigned long count, chid channelId,
+                               const void* pValue, caEventCallBackFunc* handler,
+                               void* arg)
+{
+   return ca_array_put_callback (type, count, channelId, pValue, handler, arg);
+}
+
+//------------------------------------------------------------------------------
+//
+static int caFlushIo ()
+{
+   return ca_flush_io ();
+}
+
+static const ACAI::Backend caBackend = {
+   "channel access",
+   caCreateChannel,
+   caClearChannel,
+   caFieldType,
+   caElementCount,
+   caState,
+   caReadAccess,
+   caWriteAccess,
+   caGetHostName,
+   caPuser,
+   caArrayGetCallback,
+   caCreateSubscription,
+   caClearSubscription,
+   caArrayPut,
+   caArrayPutCallback,
+   caFlushIo
+};
+
+static EpicsAtomicPtrT selectedBackend = (EpicsAtomicPtrT) &caBackend;
+
+//------------------------------------------------------------------------------
+//
+const ACAI::Backend* ACAI::channelAccessBackend ()
+{
+   return &caBackend;
+}
+
+//------------------------------------------------------------------------------
+//
+const ACAI::Backend* ACAI::currentBackend ()
+{
+   return (const ACAI::Backend*) epicsAtomicGetPtrT (&selectedBackend);
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::selectBackend (const ACAI::Backend* backend)
+{
+   if (!backend) backend = &caBackend;
+
+   if (ACAI::Handle_Table::allocatedCount () > 0) return false;
+
+   epicsAtomicSetPtrT (&selectedBackend, (EpicsAtomicPtrT) backend);
+
+   // The buffered callback module needs the channel's user data when
+   // buffering each callback.
+   //
+   set_buffered_puser_function (backend == &caBackend ? NULL : backend->puser);
+   return true;
+}
+
+// end
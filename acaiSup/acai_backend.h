@@ -0,0 +1,87 @@
+/* acai_backend.h
+ *
+ * This file is part of the ACAI library. It provides the backend
+ * abstraction, i.e. the table of channel functions used by ACAI::Client, so
+ * that the channel access library may be replaced by a simulated backend.
+ * This is private to the library and is not installed.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#ifndef ACAI_BACKEND_H_
+#define ACAI_BACKEND_H_
+
+#include <cadef.h>
+
+namespace ACAI {
+
+// The channel functions used by ACAI::Client. The default, channel access,
+// backend functions simply call the corresponding ca_xxx functions, and the
+// signatures and semantics, including the status values returned, mirror
+// those functions. In particular, all callbacks are delivered via the
+// functions passed, i.e. the buffered callback handlers.
+//
+struct Backend {
+   const char* name;
+
+   int (*create_channel) (const char* pvName, caCh* connectionHandler,
+                          void* puser, capri priority, chid* pChannelId);
+   int (*clear_channel) (chid channelId);
+
+   short (*field_type) (chid channelId);
+   unsigned long (*element_count) (chid channelId);
+   enum channel_state (*state) (chid channelId);
+   unsigned (*read_access) (chid channelId);
+   unsigned (*write_access) (chid channelId);
+   void (*get_host_name) (chid channelId, char* buffer, unsigned length);
+   void* (*puser) (chid channelId);
+
+   int (*array_get_callback) (chtype type, unsigned long count, chid channelId,
+                              caEventCallBackFunc* handler, void* arg);
+   int (*create_subscription) (chtype type, unsigned long count, chid channelId,
+                               long mask, caEventCallBackFunc* handler, void* arg,
+                               evid* pEventId);
+   int (*clear_subscription) (evid eventId);
+   int (*array_put) (chtype type, unsigned long count, chid channelId,
+                     const void* pValue);
+   int (*array_put_callback) (chtype type, unsigned long count, chid channelId,
+                              const void* pValue, caEventCallBackFunc* handler,
+                              void* arg);
+   int (*flush_io) ();
+};
+
+// Returns the channel access backend.
+//
+const Backend* channelAccessBackend ();
+
+// Returns the backend currently in use - never NULL.
+//
+const Backend* currentBackend ();
+
+// Selects the backend for all clients, or channel access if backend is NULL.
+// The backend may only be changed while no channels are open, and this
+// returns false otherwise.
+//
+bool selectBackend (const Backend* backend);
+
+}
+
+#endif   // ACAI_BACKEND_H_
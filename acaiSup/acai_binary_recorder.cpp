@@ -0,0 +1,628 @@
+/* acai_binary_recorder.cpp
+ *
+ * This file is part of the ACAI library.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#include <acai_binary_recorder.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <vector>
+
+#if defined (_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <epicsEvent.h>
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+
+#include <acai_client.h>
+#include <acai_private_common.h>
+
+// Required for C++98 as the constants are used by reference.
+//
+const epicsUInt32 ACAI::Binary_Recorder::FileMagic;
+const epicsUInt32 ACAI::Binary_Recorder::SegmentMagic;
+const epicsUInt16 ACAI::Binary_Recorder::FormatVersion;
+
+static const size_t segmentHeaderSize = sizeof (ACAI::Binary_Recorder::Segment_Header);
+static const size_t recordHeaderSize = sizeof (ACAI::Binary_Recorder::Record_Header);
+static const size_t minimumPruneLimit = 64;
+
+//------------------------------------------------------------------------------
+// Flushes the file's data to disk.
+//
+static bool syncFile (FILE* file)
+{
+   if (fflush (file) != 0) return false;
+#if defined (_WIN32)
+   return _commit (_fileno (file)) == 0;
+#elif defined (__APPLE__)
+   return fsync (fileno (file)) == 0;
+#else
+   return fdatasync (fileno (file)) == 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Truncates the file to the specified size, e.g. to remove a partially written
+// segment.
+//
+static bool truncateFile (FILE* file, const long size)
+{
+   fflush (file);
+#if defined (_WIN32)
+   return _chsize (_fileno (file), size) == 0;
+#else
+   return ftruncate (fileno (file), off_t (size)) == 0;
+#endif
+}
+
+
+//==============================================================================
+// PrivateData
+//==============================================================================
+//
+class ACAI::Binary_Recorder::PrivateData {
+public:
+   explicit PrivateData (const ACAI::Binary_Recorder* owner, const size_t bufferSize);
+   ~PrivateData ();
+
+   typedef epicsGuard<epicsMutex> Guard;
+
+   // The following functions must be called with the mutex held.
+   //
+   bool isRecording () const { return this->file && !this->stopping && !this->failed; }
+   epicsUInt32 channelIndex (ACAI::Client* client, Guard& guard);
+   void pruneChannels ();
+   void appendRecord (const Record_Header& header, const void* payload, Guard& guard);
+   void swapBuffers ();
+
+   void writerThread ();
+   static void threadFunction (void* arg);
+
+   struct Channel_Info {
+      epicsUInt32 index;
+      ACAI::ClientString pvName;
+   };
+
+   typedef std::map<ACAI::Client*, Channel_Info> Channel_Maps;
+
+   const ACAI::Binary_Recorder* owner;
+   epicsMutex mutex;
+   epicsEventId workEvent;         // signals the writer thread
+   epicsEventId doneEvent;         // signalled by writer when a segment written
+   epicsEventId exitEvent;         // signalled by writer on exit
+
+   FILE* file;
+   long goodSize;                  // file size after the last complete segment
+   bool stopping;
+   bool failed;                    // a write failed - recording has stopped
+   bool writePending;              // the writing buffer is owned by the writer
+
+   size_t bufferSize;
+   std::vector<char> active;       // being filled, starts with a segment header
+   std::vector<char> writing;      // being written
+   epicsUInt32 activeRecords;
+   epicsUInt32 segmentSequence;
+   epicsUInt32 nextChannel;
+   Channel_Maps channels;
+   size_t pruneLimit;              // channels size that triggers a prune
+
+   ACAI::Binary_Recorder::SyncPolicies syncPolicy;
+   double flushInterval;
+
+   size_t records;
+   size_t bytes;
+   size_t segments;
+   size_t failures;
+   size_t waits;
+};
+
+//------------------------------------------------------------------------------
+//
+ACAI::Binary_Recorder::PrivateData::PrivateData (const ACAI::Binary_Recorder* ownerIn,
+                                                  const size_t bufferSizeIn)
+{
+   this->owner = ownerIn;
+   this->workEvent = epicsEventCreate (epicsEventEmpty);
+   this->doneEvent = epicsEventCreate (epicsEventEmpty);
+   this->exitEvent = epicsEventCreate (epicsEventEmpty);
+
+   this->file = NULL;
+   this->goodSize = 0;
+   this->stopping = false;
+   this->failed = false;
+   this->writePending = false;
+
+   this->bufferSize = MAX (bufferSizeIn, 4096);
+   this->active.reserve (this->bufferSize);
+   this->writing.reserve (this->bufferSize);
+   this->active.resize (segmentHeaderSize);
+   this->writing.resize (segmentHeaderSize);
+   this->activeRecords = 0;
+   this->segmentSequence = 0;
+   this->nextChannel = 0;
+   this->pruneLimit = minimumPruneLimit;
+
+   this->syncPolicy = ACAI::Binary_Recorder::SyncNever;
+   this->flushInterval = 1.0;
+
+   this->records = 0;
+   this->bytes = 0;
+   this->segments = 0;
+   this->failures = 0;
+   this->waits = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Binary_Recorder::PrivateData::~PrivateData ()
+{
+   epicsEventDestroy (this->workEvent);
+   epicsEventDestroy (this->doneEvent);
+   epicsEventDestroy (this->exitEvent);
+}
+
+//------------------------------------------------------------------------------
+// Returns the client's channel index, allocating the index and recording the
+// channel definition if needs be. The PV name is always checked, as a deleted
+// client's address may have been re-used by a new client, which may well have
+// been registered after its first update, and a client's PV name may change.
+//
+epicsUInt32 ACAI::Binary_Recorder::PrivateData::channelIndex (ACAI::Client* client,
+                                                              Guard& guard)
+{
+   Channel_Maps::iterator it = this->channels.find (client);
+   if (it != this->channels.end ()) {
+      if (it->second.pvName == client->cPvName ()) {
+         return it->second.index;
+      }
+   }
+
+   // Forget deleted and deregistered clients. This is only done when the number
+   // of channels has doubled since the last prune, so the cost is amortised.
+   //
+   if (this->channels.size () >= this->pruneLimit) {
+      this->pruneChannels ();
+      this->pruneLimit = MAX (2 * this->channels.size (), minimumPruneLimit);
+   }
+
+   Channel_Info info;
+   info.index = this->nextChannel++;
+   info.pvName = client->pvName ();
+   this->channels [client] = info;
+
+   epicsTimeStamp now;
+   epicsTimeGetCurrent (&now);
+
+   Record_Header header;
+   memset (&header, 0, sizeof (header));
+   header.kind = RecordDefineChannel;
+   header.channel = info.index;
+   header.secPastEpoch = now.secPastEpoch;
+   header.nsec = now.nsec;
+   header.size = epicsUInt32 (info.pvName.size ());
+   this->appendRecord (header, info.pvName.c_str (), guard);
+
+   return info.index;
+}
+
+//------------------------------------------------------------------------------
+// Removes the channels whose clients are no longer registered, e.g. because
+// deleted. The client pointers are only compared, never dereferenced.
+//
+void ACAI::Binary_Recorder::PrivateData::pruneChannels ()
+{
+   Channel_Maps::iterator it = this->channels.begin ();
+   while (it != this->channels.end ()) {
+      if (this->owner->clientIsRegistered (it->first)) {
+         ++it;
+      } else {
+         this->channels.erase (it++);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// Appends a record to the active buffer. If the buffer is full, it is first
+// handed to the writer thread, waiting for the writer if need be.
+//
+void ACAI::Binary_Recorder::PrivateData::appendRecord (const Record_Header& header,
+                                                       const void* payload,
+                                                       Guard& guard)
+{
+   const size_t padded = (recordHeaderSize + header.size + 7) & ~size_t (7);
+
+   if ((this->active.size () + padded > this->bufferSize) && (this->activeRecords > 0)) {
+      while (this->writePending) {
+         this->waits++;
+         epicsGuardRelease<epicsMutex> unguard (guard);
+         epicsEventWait (this->doneEvent);
+      }
+      this->swapBuffers ();
+      epicsEventSignal (this->workEvent);
+   }
+
+   // Note: resize zeros the padding.
+   //
+   const size_t offset = this->active.size ();
+   this->active.resize (offset + padded);
+   memcpy (&this->active [offset], &header, recordHeaderSize);
+   if (header.size > 0) {
+      memcpy (&this->active [offset + recordHeaderSize], payload, header.size);
+   }
+   this->activeRecords++;
+}
+
+//------------------------------------------------------------------------------
+// Completes the active buffer's segment header and hands it to the writer.
+// Pre-condition: there is no write pending.
+//
+void ACAI::Binary_Recorder::PrivateData::swapBuffers ()
+{
+   Segment_Header header;
+   header.magic = SegmentMagic;
+   header.sequence = this->segmentSequence++;
+   header.records = this->activeRecords;
+   header.size = epicsUInt32 (this->active.size () - segmentHeaderSize);
+   memcpy (&this->active [0], &header, segmentHeaderSize);
+
+   this->active.swap (this->writing);
+   this->active.resize (segmentHeaderSize);
+   this->activeRecords = 0;
+   this->writePending = true;
+}
+
+//------------------------------------------------------------------------------
+// Writes each segment as it is handed over, and any partially filled buffer
+// after the flush interval. When stopping, writes all remaining records.
+//
+void ACAI::Binary_Recorder::PrivateData::writerThread ()
+{
+   bool wait = true;
+   for (;;) {
+      if (wait) epicsEventWaitWithTimeout (this->workEvent, this->flushInterval);
+
+      bool write;
+      bool stop;
+      bool sync;
+      {
+         Guard guard (this->mutex);
+         if (this->failed) {
+            this->active.resize (segmentHeaderSize);    // discard
+            this->activeRecords = 0;
+         } else if (!this->writePending && (this->activeRecords > 0)) {
+            this->swapBuffers ();
+         }
+         write = this->writePending;
+         stop = this->stopping;
+         sync = (this->syncPolicy == ACAI::Binary_Recorder::SyncEachSegment);
+      }
+
+      if (write) {
+         // The writing buffer is not accessed by other threads while pending.
+         //
+         Segment_Header header;
+         memcpy (&header, &this->writing [0], segmentHeaderSize);
+
+         // On failure, remove any partially written segment, so that only
+         // a final segment may ever be incomplete, and stop recording.
+         //
+         const size_t size = this->writing.size ();
+         bool ok = fwrite (&this->writing [0], 1, size, this->file) == size;
+         if (ok && sync) ok = syncFile (this->file);
+         if (ok) {
+            this->goodSize += long (size);
+         } else {
+            truncateFile (this->file, this->goodSize);
+         }
+
+         Guard guard (this->mutex);
+         if (ok) {
+            this->records += header.records;
+            this->bytes += size;
+            this->segments++;
+         } else {
+            this->failures++;
+            this->failed = true;
+         }
+         this->writing.resize (segmentHeaderSize);
+         this->writePending = false;
+      }
+      if (write) epicsEventSignal (this->doneEvent);
+
+      if (stop && !write) break;
+      wait = !stop;
+   }
+
+   epicsEventSignal (this->exitEvent);
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Binary_Recorder::PrivateData::threadFunction (void* arg)
+{
+   ((PrivateData*) arg)->writerThread ();
+}
+
+
+//==============================================================================
+// Binary_Recorder
+//==============================================================================
+//
+ACAI::Binary_Recorder::Binary_Recorder (const size_t bufferSize) :
+   ACAI::Abstract_Client_User ()
+{
+   this->pd = new PrivateData (this, bufferSize);
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Binary_Recorder::~Binary_Recorder ()
+{
+   this->close ();
+   delete this->pd;
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Binary_Recorder::open (const char* filename)
+{
+   if (!filename || this->isOpen ()) return false;
+
+   FILE* file = fopen (filename, "ab");
+   if (!file) return false;
+
+   // Segments are already buffered - write them directly.
+   //
+   setvbuf (file, NULL, _IONBF, 0);
+
+   epicsTimeStamp now;
+   epicsTimeGetCurrent (&now);
+
+   File_Header header;
+   header.magic = FileMagic;
+   header.version = FormatVersion;
+   header.byteOrder = 0x0102;
+   header.secPastEpoch = now.secPastEpoch;
+   header.nsec = now.nsec;
+
+   if (fwrite (&header, sizeof (header), 1, file) != 1) {
+      fclose (file);
+      return false;
+   }
+
+   {
+      epicsGuard<epicsMutex> guard (this->pd->mutex);
+      this->pd->file = file;
+      this->pd->goodSize = ftell (file);
+      this->pd->stopping = false;
+      this->pd->failed = false;
+      this->pd->writePending = false;
+      this->pd->active.resize (segmentHeaderSize);
+      this->pd->activeRecords = 0;
+      this->pd->segmentSequence = 0;
+      this->pd->nextChannel = 0;
+      this->pd->channels.clear ();
+      this->pd->pruneLimit = minimumPruneLimit;
+   }
+
+   epicsThreadId id = epicsThreadCreate ("acai_recorder", epicsThreadPriorityMedium,
+                                         epicsThreadGetStackSize (epicsThreadStackMedium),
+                                         PrivateData::threadFunction, this->pd);
+   if (!id) {
+      epicsGuard<epicsMutex> guard (this->pd->mutex);
+      this->pd->file = NULL;
+      fclose (file);
+      return false;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Binary_Recorder::close ()
+{
+   {
+      epicsGuard<epicsMutex> guard (this->pd->mutex);
+      if (!this->pd->file || this->pd->stopping) return;   // including after a failure
+      this->pd->stopping = true;
+   }
+
+   epicsEventSignal (this->pd->workEvent);
+   epicsEventWait (this->pd->exitEvent);
+
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   if (this->pd->syncPolicy != SyncNever) {
+      if (!syncFile (this->pd->file)) this->pd->failures++;
+   }
+   fclose (this->pd->file);
+   this->pd->file = NULL;
+   this->pd->stopping = false;
+   this->pd->channels.clear ();
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Binary_Recorder::isOpen () const
+{
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   return this->pd->file != NULL;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Binary_Recorder::flush ()
+{
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   if (!this->pd->isRecording ()) return;
+
+   if (!this->pd->writePending && (this->pd->activeRecords > 0)) {
+      this->pd->swapBuffers ();
+   }
+   epicsEventSignal (this->pd->workEvent);
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Binary_Recorder::setSyncPolicy (const SyncPolicies syncPolicy)
+{
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   this->pd->syncPolicy = syncPolicy;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Binary_Recorder::SyncPolicies ACAI::Binary_Recorder::syncPolicy () const
+{
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   return this->pd->syncPolicy;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Binary_Recorder::setFlushInterval (const double flushInterval)
+{
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   if (this->pd->file) return;   // the writer thread reads this unguarded
+   this->pd->flushInterval = MAX (flushInterval, 0.01);
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Binary_Recorder::flushInterval () const
+{
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   return this->pd->flushInterval;
+}
+
+//------------------------------------------------------------------------------
+//
+size_t ACAI::Binary_Recorder::recordsWritten () const
+{
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   return this->pd->records;
+}
+
+//------------------------------------------------------------------------------
+//
+size_t ACAI::Binary_Recorder::bytesWritten () const
+{
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   return this->pd->bytes;
+}
+
+//------------------------------------------------------------------------------
+//
+size_t ACAI::Binary_Recorder::segmentsWritten () const
+{
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   return this->pd->segments;
+}
+
+//------------------------------------------------------------------------------
+//
+size_t ACAI::Binary_Recorder::writeFailures () const
+{
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   return this->pd->failures;
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Binary_Recorder::writeFailed () const
+{
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   return this->pd->failed;
+}
+
+//------------------------------------------------------------------------------
+//
+size_t ACAI::Binary_Recorder::writerWaits () const
+{
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   return this->pd->waits;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Binary_Recorder::connectionUpdate (ACAI::Client* sender,
+                                              const bool isConnected)
+{
+   if (!sender) return;
+
+   epicsTimeStamp now;
+   epicsTimeGetCurrent (&now);
+
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   if (!this->pd->isRecording ()) return;
+
+   Record_Header header;
+   memset (&header, 0, sizeof (header));
+   header.kind = RecordConnection;
+   header.channel = this->pd->channelIndex (sender, guard);
+   header.secPastEpoch = now.secPastEpoch;
+   header.nsec = now.nsec;
+   header.status = isConnected ? 1 : 0;
+   this->pd->appendRecord (header, NULL, guard);
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Binary_Recorder::dataUpdate (ACAI::Client* sender, const bool)
+{
+   if (!sender) return;
+
+   size_t size = 0;
+   const void* data = sender->rawDataPointer (size);
+   if (!data) return;
+
+   const ACAI::ClientTimeStamp stamp = sender->timeStamp ();
+
+   Record_Header header;
+   header.kind = RecordUpdate;
+   header.fieldType = epicsUInt16 (sender->dataFieldType ());
+   header.channel = 0;
+   header.secPastEpoch = stamp.secPastEpoch;
+   header.nsec = stamp.nsec;
+   header.status = epicsUInt16 (sender->alarmStatus ());
+   header.severity = epicsUInt16 (sender->alarmSeverity ());
+   header.count = sender->dataElementCount ();
+   header.size = epicsUInt32 (size);
+   header.reserved = 0;
+
+   epicsGuard<epicsMutex> guard (this->pd->mutex);
+   if (!this->pd->isRecording ()) return;
+
+   header.channel = this->pd->channelIndex (sender, guard);
+   this->pd->appendRecord (header, data, guard);
+}
+
+// end
@@ -0,0 +1,185 @@
+/* acai_binary_recorder.h
+ *
+ * This file is part of the ACAI library. It provides a recorder that writes raw
+ * channel updates to an append-only binary file.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#ifndef ACAI_BINARY_RECORDER_H_
+#define ACAI_BINARY_RECORDER_H_
+
+#include <stddef.h>
+#include <epicsTypes.h>
+#include <acai_client_types.h>
+#include <acai_abstract_client_user.h>
+#include <acai_shared.h>
+
+namespace ACAI {
+
+/// \brief The ACAI::Binary_Recorder class records the updates of all registered
+/// clients to an append-only binary file.
+///
+/// Each update is recorded as the raw channel access payload, i.e. as per
+/// ACAI::Client::rawDataPointer, together with the field type, element count,
+/// time stamp and alarm state. No formatting or conversion takes place.
+/// Records are appended to an in-memory buffer, and each full buffer is written
+/// as a single segment by a dedicated writer thread, so that file I/O does not
+/// delay ACAI::Client::poll. Partially filled buffers are written after the
+/// flush interval. If the writer falls a full buffer behind, recording waits
+/// for it, i.e. no updates are dropped.
+///
+/// File format. All values are in host byte order, see File_Header::byteOrder.
+/// Each call to open appends a File_Header, which starts a session. This is
+/// followed by any number of segments, each being a Segment_Header followed by
+/// Segment_Header::size bytes of records. Each record is a Record_Header
+/// followed by Record_Header::size bytes of payload, padded to a multiple of
+/// 8 bytes. A reader distinguishes file and segment headers by their magic
+/// number. A final segment that extends beyond the end of the file is the
+/// result of an interrupted write, and should be ignored. If a segment write
+/// fails, the file is truncated to the end of the last complete segment and
+/// recording stops, i.e. subsequent updates are discarded, until re-opened.
+///
+/// Channels are identified by an index, defined by a RecordDefineChannel record
+/// whose payload is the PV name, and which precedes the channel's first
+/// update or connection record within the session. Channel indices are only
+/// meaningful within a session. The channels of deleted or deregistered clients
+/// are forgotten from time to time, so a client that is re-registered may be
+/// allocated a new index.
+///
+/// Note: O_DIRECT is not used, as it would require block aligned records and
+/// writes. The page cache is only flushed as per the sync policy.
+///
+class ACAI_SHARED_CLASS Binary_Recorder : public ACAI::Abstract_Client_User {
+public:
+   static const epicsUInt32 FileMagic    = 0x46524341;   // "ACRF" little endian
+   static const epicsUInt32 SegmentMagic = 0x53524341;   // "ACRS" little endian
+   static const epicsUInt16 FormatVersion = 1;
+
+   /// Record kinds.
+   ///
+   enum RecordKinds {
+      RecordDefineChannel = 1,   ///< payload is the PV name
+      RecordConnection,          ///< status is 1 for connect, 0 for disconnect
+      RecordUpdate               ///< payload is the raw data
+   };
+
+   /// Data written to disk - layouts are fixed, 8 byte aligned.
+   ///
+   struct File_Header {
+      epicsUInt32 magic;          ///< FileMagic
+      epicsUInt16 version;        ///< FormatVersion
+      epicsUInt16 byteOrder;      ///< 0x0102 as written by the host
+      epicsUInt32 secPastEpoch;   ///< session start time, EPICS epoch
+      epicsUInt32 nsec;
+   };
+
+   struct Segment_Header {
+      epicsUInt32 magic;          ///< SegmentMagic
+      epicsUInt32 sequence;       ///< segment number within the session
+      epicsUInt32 records;        ///< number of records in the segment
+      epicsUInt32 size;           ///< size of the records, in bytes
+   };
+
+   struct Record_Header {
+      epicsUInt16 kind;           ///< RecordKinds
+      epicsUInt16 fieldType;      ///< ACAI::ClientFieldType of the payload
+      epicsUInt32 channel;        ///< channel index within the session
+      epicsUInt32 secPastEpoch;   ///< data time stamp, or local time for connections
+      epicsUInt32 nsec;
+      epicsUInt16 status;         ///< alarm status
+      epicsUInt16 severity;       ///< alarm severity
+      epicsUInt32 count;          ///< number of elements
+      epicsUInt32 size;           ///< payload size, in bytes, excluding padding
+      epicsUInt32 reserved;
+   };
+
+   /// When the file's data is flushed to disk using fdatasync (or equivalent).
+   ///
+   enum SyncPolicies {
+      SyncNever = 0,             ///< left to the operating system (default)
+      SyncEachSegment,           ///< after each segment write
+      SyncOnClose                ///< when the file is closed
+   };
+
+   /// Constructs a recorder. The buffer size, i.e. the nominal segment size,
+   /// is constrained to >= 4096 bytes. Two buffers of this size are used.
+   ///
+   explicit Binary_Recorder (const size_t bufferSize = 4 * 1024 * 1024);
+
+   /// Closes the file, if open, writing all buffered records.
+   ///
+   virtual ~Binary_Recorder ();
+
+   /// Opens the file for appending, creating it if needs be, writes a
+   /// File_Header and starts the writer thread. Returns false on failure,
+   /// or if already open.
+   ///
+   bool open (const char* filename);
+
+   /// Writes all buffered records, syncs as per the sync policy, stops the
+   /// writer thread and closes the file.
+   ///
+   void close ();
+
+   bool isOpen () const;
+
+   /// Hands any buffered records to the writer thread, i.e. does not wait.
+   ///
+   void flush ();
+
+   /// Sets the sync policy. Takes effect immediately.
+   ///
+   void setSyncPolicy (const SyncPolicies syncPolicy);
+   SyncPolicies syncPolicy () const;
+
+   /// Sets the maximum time, in seconds, that records may remain buffered,
+   /// default 1.0. Constrained to >= 0.01. Applies from the next open.
+   ///
+   void setFlushInterval (const double flushInterval);
+   double flushInterval () const;
+
+   /// Statistics, cumulative since construction.
+   ///
+   size_t recordsWritten () const;
+   size_t bytesWritten () const;
+   size_t segmentsWritten () const;
+   size_t writeFailures () const;
+   bool writeFailed () const;         ///< recording has stopped due to a write failure
+   size_t writerWaits () const;       ///< number of times recording waited for the writer
+
+protected:
+   void connectionUpdate (ACAI::Client* sender, const bool isConnected);
+   void dataUpdate (ACAI::Client* sender, const bool firstUpdate);
+
+private:
+   // Make objects of this class non-copyable.
+   //
+   Binary_Recorder (const Binary_Recorder&) : ACAI::Abstract_Client_User () {}
+   Binary_Recorder& operator= (const Binary_Recorder&) { return *this; }
+
+   class PrivateData;
+   PrivateData* pd;
+};
+
+}
+
+#endif   // ACAI_BINARY_RECORDER_H_
@@ -33,6 +33,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits>
+#include <list>
+#include <map>
+#include <new>
 
 #include <alarm.h>
 #include <cadef.h>
@@ -40,6 +43,10 @@
 #include <cantProceed.h>
 #include <db_access.h>
 #include <dbDefs.h>
+#include <epicsAtomic.h>
+#include <epicsExit.h>
+#include <epicsGuard.h>
+#include <epicsMutex.h>
 #include <epicsTime.h>
 #include <epicsTypes.h>
 #include <epicsString.h>
@@ -48,6 +55,12 @@
 
 #include <buffered_callbacks.h>
 #include <acai_abstract_client_user.h>
+#include <acai_backend.h>
+#include <acai_client_completion.h>
+#include <acai_meta_data.h>
+#include <acai_handle_table.h>
+#include <acai_statistics.h>
+#include <acai_trace.h>
 #include <acai_private_common.h>
 
 // Magic numbers embedded within each ACAI::Client and ACAI::Client::PrivateData object.
@@ -65,9 +78,159 @@ static int debugLevel = 0;
 //
 #define MINIMUM_BUFFER_SIZE   (sizeof (dbr_string_t))
 
+// Assumed cache line size - used to align the private data.
+//
+#define CACHE_LINE_SIZE       64
+
 // static
 ACAI::Client::NotificationHandlers ACAI::Client::notificationHandler = NULL;
 
+// Clients holding a put deferred by the minimum put interval. Puts may be
+// requested from any attached thread, so this is mutex protected.
+//
+typedef std::set<ACAI::Client*> Throttled_Client_Sets;
+static Throttled_Client_Sets throttledClients;
+static epicsMutex throttledClientsMutex;
+
+// Clients whose connection up processing has been deferred by the connection
+// budget, in arrival order. Clients may be closed from any attached thread,
+// so this is mutex protected. The counter is only accessed by the poll thread.
+//
+typedef std::list<ACAI::Client*> Deferred_Connection_Lists;
+static Deferred_Connection_Lists deferredConnections;
+static epicsMutex deferredConnectionsMutex;
+static int connectionBudgetLimit = 0;       // 0 means unlimited
+static int connectionsThisPoll = 0;
+
+// Incremented by each poll - used to determine per client update bursts.
+//
+static unsigned int pollGeneration = 0;
+
+// Returns the channel backend, normally channel access - see acai_backend.h.
+//
+static inline const ACAI::Backend* backend ()
+{
+   return ACAI::currentBackend ();
+}
+
+// Returns the monotonic time in seconds.
+//
+static double monotonicTime ()
+{
+   return double (epicsMonotonicGet ()) * 1.0e-9;
+}
+
+// Per thread scratch storage used for put data conversions. Once a thread's
+// storage has grown to the required size, puts from that thread need not
+// allocate memory. The storage is freed when the thread exits, which applies
+// to threads created via epicsThreadCreate. Conversions larger than the
+// retention limit are not retained, and allocate and free memory per put.
+//
+struct Thread_Scratch {
+   void* data;
+   size_t capacity;
+   bool inUse;
+};
+
+static const size_t maximumRetainedScratch = 65536;    // 64 Kbytes
+static const size_t minimumRetainedScratch = 4096;
+
+static epicsThreadOnceId scratchOnce = EPICS_THREAD_ONCE_INIT;
+static epicsThreadPrivateId scratchId = NULL;
+
+//------------------------------------------------------------------------------
+//
+static void scratchInitialise (void*)
+{
+   scratchId = epicsThreadPrivateCreate ();
+}
+
+//------------------------------------------------------------------------------
+// Called on thread exit.
+//
+static void scratchRelease (void* arg)
+{
+   Thread_Scratch* thread = (Thread_Scratch*) arg;
+   epicsThreadPrivateSet (scratchId, NULL);
+   free (thread->data);
+   free (thread);
+}
+
+//------------------------------------------------------------------------------
+// Returns the calling thread's scratch storage, or NULL if unable to allocate.
+//
+static Thread_Scratch* threadScratch ()
+{
+   epicsThreadOnce (&scratchOnce, scratchInitialise, NULL);
+
+   Thread_Scratch* thread = (Thread_Scratch*) epicsThreadPrivateGet (scratchId);
+   if (!thread) {
+      thread = (Thread_Scratch*) calloc (1, sizeof (Thread_Scratch));
+      if (!thread) return NULL;
+      epicsThreadPrivateSet (scratchId, thread);
+      epicsAtThreadExit (scratchRelease, thread);
+   }
+   return thread;
+}
+
+// Scratch buffer used for put data conversions. Uses the thread's scratch
+// storage when available, otherwise allocates memory which is freed when the
+// object goes out of scope.
+//
+class Scratch_Buffer {
+public:
+   explicit Scratch_Buffer (const size_t size)
+   {
+      this->thread = (size <= maximumRetainedScratch) ? threadScratch () : NULL;
+
+      // The storage may already be in use if a conversion is nested.
+      //
+      if (this->thread && !this->thread->inUse) {
+         if (size > this->thread->capacity) {
+            // Round up to a power of 2 to avoid frequent re-allocations.
+            //
+            size_t capacity = minimumRetainedScratch;
+            while (capacity < size) capacity *= 2;
+
+            void* data = realloc (this->thread->data, capacity);
+            if (data) {
+               this->thread->data = data;
+               this->thread->capacity = capacity;
+            }
+         }
+
+         if (size <= this->thread->capacity) {
+            this->thread->inUse = true;
+            this->data = this->thread->data;
+            return;
+         }
+      }
+
+      this->thread = NULL;
+      this->data = malloc (size);
+   }
+
+   ~Scratch_Buffer ()
+   {
+      if (this->thread) {
+         this->thread->inUse = false;
+      } else {
+         free (this->data);
+      }
+   }
+
+   // Returns NULL if unable to allocate memory.
+   //
+   void* pointer () const { return this->data; }
+
+private:
+   Scratch_Buffer (const Scratch_Buffer&);
+   Scratch_Buffer& operator= (const Scratch_Buffer&);
+
+   Thread_Scratch* thread;
+   void* data;
+};
+
 //==============================================================================
 // PRIVATE FUNCTIONS
 //==============================================================================
@@ -119,6 +282,22 @@ void ACAI::Client::reportErrorFunc (const int line, const char* function,
 //
 #define reportError(...) reportErrorFunc (__LINE__, __FUNCTION__, __VA_ARGS__)
 
+//------------------------------------------------------------------------------
+// Sequence lock protected client snapshot. The poll thread is the only writer.
+// The sequence number is odd while a publication is in progress. All accesses
+// to the snapshot data are word-wise atomic so that readers never observe a
+// torn word, and any inconsistent copy is detected by the sequence check.
+//
+struct Snapshot_Slot {
+   int sequence;
+   ACAI::ClientSnapshot data;
+};
+
+#define SNAPSHOT_WORDS   (sizeof (ACAI::ClientSnapshot) / sizeof (int))
+
+// Ensure the snapshot size is an exact number of words.
+//
+typedef char Snapshot_Size_Check [(sizeof (ACAI::ClientSnapshot) % sizeof (int)) == 0 ? 1 : -1];
 
 //==============================================================================
 // ACAI::Client::PrivateData class and methods
@@ -129,12 +308,28 @@ public:
    explicit PrivateData (ACAI::Client* owner);
    ~PrivateData ();
 
+   // Private data objects are allocated on a cache line boundary - see below.
+   //
+   static void* operator new (size_t size);
+   static void operator delete (void* ptr);
+
    inline
    const char* cPvName () const { return this->pv_name.c_str(); }
 
    void clearBuffer ();     // clears buffer
    const union db_access_val*  updateBuffer (struct event_handler_args& args);
 
+   // Saves a copy of the put data in the deferred put slot, replacing any
+   // previous deferred put. Returns false if unable to allocate the buffer.
+   //
+   bool setDeferredPut (const chtype type, const unsigned long count, const void* dataPtr);
+
+   // Replaces the current meta data block with the interned equivalent of
+   // meta, taking ownership of meta, and releases the previous block.
+   // When meta is NULL, reverts to the shared null meta data block.
+   //
+   void setMetaData (ACAI::Meta_Data* meta);
+
    typedef enum ConnectionStatus {
       csNull = 0,           // channel not in use
       csPending,            // create channel invoked
@@ -142,10 +337,50 @@ public:
       csDisconnected        // virtual circuit disconnect.
    } ConnectionStatus;
 
-   ACAI::ClientString pv_name;
-   ACAI::ClientString channel_host_name;
+   // Hot per update information - written by updateHandler and read by the
+   // get data functions. These are grouped at the start of the object so that,
+   // together with the object alignment, they share a single cache line.
+   // Note: dataValues must be the first member - see the constructor.
+   //
+   // Pointer to actual data as received - we do not decode or unpack the data.
+   // We just keep the data blob as we received it.
+   // Union for each field type.
+   //
+   union Data_Values {
+      const dbr_string_t* stringRef;
+      const dbr_short_t*  shortRef;
+      const dbr_float_t*  floatRef;
+      const dbr_enum_t*   enumRef;
+      const dbr_char_t*   charRef;   // revert
+      const dbr_long_t*   longRef;
+      const dbr_double_t* doubleRef;
+      const void*         genericRef;
+   };
+   union Data_Values dataValues;
+
+   // Logical size of buffered data
+   // If argsDbr == NULL and logical_data_size > MINIMUM_BUFFER_SIZE we have a problem.
+   //
+   size_t logical_data_size;
+
+   epicsTimeStamp	timeStamp;
+   unsigned int data_element_count;        // number of elements received (as opposed to
+                                           // number on (IOC) server, channel_element_count).
+   unsigned int data_field_size;           // element size  LONG = 4 etc.
+   ACAI::ClientFieldType data_field_type;  // as per request - typically same as host_field_type
+   epicsAlarmCondition status;             // status of value
+   epicsAlarmSeverity severity;            // severity of alarm
+   ConnectionStatus connectionStatus;      //
+   bool is_first_update;
+
+   // We use this if/when the data will fit into this buffer, otherwise we use
+   // a reference to the call back data - which is okay as already copied
+   // once. This immediately follows the hot members.
+   //
+   char localBuffer [MINIMUM_BUFFER_SIZE];  // large enough for any scalar
 
-   int firstMember;         // this together with lastMember define effective class size.
+   // Cold members - only accessed on connection, configuration changes etc.
+   //
    int magic_number;        // used to verify void* to PrivateData* conversions.
 
    // Channel Access passes back one of these to callback functions as user data.
@@ -157,9 +392,9 @@ public:
 
    // Channel Access connection info
    //
+   void* handle;                // channel user data - see Handle_Table
    chid channel_id;             // chid is a pointer type
    evid event_id;               // evid is a pointer type
-   ConnectionStatus connectionStatus;  //
    bool lastIsConnected;        // previous value - allows calls to Connection_Bu to be filtered
    ACAI::ReadModes readMode;    // subscription v. single read. v. no read at all
    ACAI::EventMasks eventMask;  // event update tigger specification
@@ -173,60 +408,85 @@ public:
    bool use_put_callback;       // mode of operation control flag
    bool pending_put_callback;   // indicated waiting for a put callback.
 
-   // Cached channel values
+   // Last value wins deferred put slot - see setPutCoalescing. The buffer is
+   // retained once allocated, and is freed when the client is deleted.
    //
-   ACAI::ClientFieldType host_field_type;   // as on host IOC
-   unsigned int channel_element_count;      // as on host IOC
+   bool put_coalescing;         // mode of operation control flag
+   bool has_deferred_put;
+   bool throttle_deferred_put;  // the deferred put is due to the minimum interval
+   chtype deferred_put_type;
+   unsigned long deferred_put_count;
+   void* deferred_put_buffer;
+   size_t deferred_put_capacity;
+
+   // Outbound put throttle - see setPutMinimumInterval and setPutDeadband.
+   //
+   double put_minimum_interval;    // seconds
+   double put_deadband;
+   double next_put_time;           // monotonic time, seconds
+   double last_put_value;          // last scalar numeric value issued
+   bool has_last_put_value;
+   int suppressed_put_count;
+   int deferred_put_count_total;
+
+   // Inbound update filter - see setUpdateDeadband and setUpdateMinimumInterval.
+   //
+   double update_absolute_deadband;
+   double update_relative_deadband;
+   double update_minimum_interval;    // seconds
+
+   bool subscription_paused;          // see pauseSubscription
+
+   bool connection_up_deferred;       // see setConnectionBudget
 
-   // Meta data (apart from time stamp, returned on first update)
-   // Essentially as out of dbr_ctrl_double, dbr_ctrl_enum etc.
-   // Use double as this caters for all types (float, long, short etc.)
-   //
-   int precision;               // number of decimal places
-   char units[MAX_UNITS_SIZE];  // units of value
-   unsigned short num_states;   // number of strings (was no_str)
-   char enum_strings[MAX_ENUM_STATES][MAX_ENUM_STRING_SIZE];    // was strs
-   double upper_disp_limit;     // upper limit of graph
-   double lower_disp_limit;     // lower limit of graph
-   double upper_alarm_limit;
-   double upper_warning_limit;
-   double lower_warning_limit;
-   double lower_alarm_limit;
-   double upper_ctrl_limit;     // upper control limit
-   double lower_ctrl_limit;     // lower control limit
-
-   // Per update information.
+   // Subscription retention - see setRetainSubscription.
    //
-   bool is_first_update;
-   unsigned int data_field_size;           // element size  LONG = 4 etc.
-   ACAI::ClientFieldType data_field_type;  // as per request - typically same as host_field_type
-   unsigned int data_element_count;        // number of elements received (as opposed to
-                                           // number on (IOC) server, channel_element_count).
-   epicsAlarmCondition status;             // status of value
-   epicsAlarmSeverity severity;            // severity of alarm
-   epicsTimeStamp	timeStamp;
+   bool retain_subscription;          // mode of operation control flag
+   int retained_subscription_count;   // re-connections that re-used the subscription
 
-   // Pointer to actual data as received - we do not decode or unpack the data.
-   // We just keep the data blob as we received it.
-   // Union for each field type.
+   // Lazy meta data - see setLazyMetaData.
    //
-   union Data_Values {
-      const dbr_string_t* stringRef;
-      const dbr_short_t*  shortRef;
-      const dbr_float_t*  floatRef;
-      const dbr_enum_t*   enumRef;
-      const dbr_char_t*   charRef;   // revert
-      const dbr_long_t*   longRef;
-      const dbr_double_t* doubleRef;
-      const void*         genericRef;
-   };
-   union Data_Values dataValues;
+   bool lazy_meta_data;               // mode of operation control flag
+   void* metaFuncArg;                 // non NULL once meta data requested
+   evid meta_event_id;                // property subscription
 
-   // We use this if/when the data will fit into this buffer, otherwise we use
-   // a reference to the call back data - which is okay as already copied
-   // once.
+   // Adaptive request count - see setAdaptiveRequestCount.
    //
-   char localBuffer [MINIMUM_BUFFER_SIZE];  // large enough for any scalar
+   bool adaptive_request;             // mode of operation control flag
+   unsigned int adaptive_count;       // 0 when not yet determined
+   int adaptive_resubscribe_count;
+   double adaptive_bytes_saved;
+   ACAI::Client* adaptive_companion;  // monitors the number of elements in use
+
+   // Per client latency statistics - see setLatencyStatistics.
+   // These are NULL unless enabled.
+   //
+   ACAI::Latency_Histogram* queue_latency;
+   ACAI::Latency_Histogram* handler_duration;
+
+   // Update rate and bandwidth accounting - see updatesReceived etc.
+   //
+   size_t updates_received;
+   size_t updates_dispatched;
+   double bytes_received;
+   epicsUInt64 counters_start_time;   // monotonic time, nano seconds
+   epicsUInt64 last_update_time;      // monotonic time, nano seconds
+   double last_update_interval;       // seconds
+   unsigned int burst_generation;     // poll generation of the current burst
+   int burst_count;
+   int maximum_burst;
+
+   // Cached channel values
+   //
+   ACAI::ClientFieldType host_field_type;   // as on host IOC
+   unsigned int channel_element_count;      // as on host IOC
+
+   // Meta data (apart from time stamp, returned on first update) lives in a
+   // separately allocated, interned and hence possibly shared, read only block.
+   // This is never NULL, it references the null meta data block when no meta
+   // data is available.
+   //
+   const ACAI::Meta_Data* meta;
 
    // When we use a reference to the call back data, this holds a copy of the
    // event_handler_args.dbr member. We need this so that we can free the data
@@ -234,11 +494,6 @@ public:
    //
    const void* argsDbr;
 
-   // Logical size of buffered data
-   // If argsDbr == NULL and logical_data_size > MINIMUM_BUFFER_SIZE we have a problem.
-   //
-   size_t logical_data_size;
-
    time_t disconnect_time;       // system time
 
    // Basic string formatting option. This could be expanded, but that is really
@@ -246,9 +501,28 @@ public:
    // this object.
    //
    bool includeUnits;
-private:
+
+   // Snapshot publication, see getSnapshot. The slot is allocated when first
+   // enabled, and not freed until the client is deleted.
+   //
+   Snapshot_Slot* snapshot;
+   int publishSnapshots;            // atomic - also read by getSnapshot
+   ACAI::ClientUInt32 snapshotCount;
+
    ACAI::Client* owner;
-   int lastMember;
+   int lastMember;          // this together with dataValues define effective class size.
+
+   // These are standard strings and must not be zeroised.
+   //
+   ACAI::ClientString pv_name;
+   ACAI::ClientString channel_host_name;
+   ACAI::ClientString adaptive_length_pv_name;
+
+   // Outstanding asynchronous operations keyed by callback argument.
+   // Likewise must not be zeroised.
+   //
+   typedef std::map<void*, ACAI::Client_Completion*> Completion_Maps;
+   Completion_Maps completions;
 };
 
 //------------------------------------------------------------------------------
@@ -260,13 +534,15 @@ ACAI::Client::PrivateData::PrivateData (ACAI::Client* ownerIn)
    // Zeroise all members, except pv_name and channel_host_name.
    // They are now a standard strings and do not like getting zapped !!!
    //   
-   size = size_t (&this->lastMember) - size_t (&this->firstMember);
-   memset (&this->firstMember, 0, size);
+   size = size_t (&this->lastMember) - size_t (&this->dataValues);
+   memset ((void*) &this->dataValues, 0, size);
 
    this->owner = ownerIn;
+   this->counters_start_time = epicsMonotonicGet ();
 
    this->pv_name.clear();
    this->channel_host_name.clear();
+   this->adaptive_length_pv_name.clear();
 
    this->getFuncArg = NULL;
    this->subFuncArg = NULL;
@@ -298,6 +574,10 @@ ACAI::Client::PrivateData::PrivateData (ACAI::Client* ownerIn)
    //
    this->data_request_type = ACAI::ClientFieldDefault;
 
+   // No meta data until the first control update.
+   //
+   this->meta = ACAI::Meta_Data::nullMetaData ();
+
    // We default to the local buffer, big enough to hold a string variable.
    // For 95% of PVs, we will never touch this again.
    //
@@ -305,7 +585,7 @@ ACAI::Client::PrivateData::PrivateData (ACAI::Client* ownerIn)
    this->argsDbr = NULL;
    this->logical_data_size = 0;
 
-   // Lastly set magic number - used by validate channel id.
+   // Lastly set magic number - used by cast.
    //
    this->magic_number = MAGIC_NUMBER_P;
 }
@@ -316,6 +596,15 @@ ACAI::Client::PrivateData::~PrivateData ()
 {
    this->magic_number = 0;
    this->clearBuffer ();
+   this->setMetaData (NULL);
+   free (this->deferred_put_buffer);
+   this->deferred_put_buffer = NULL;
+   delete this->snapshot;
+   this->snapshot = NULL;
+   delete this->queue_latency;
+   this->queue_latency = NULL;
+   delete this->handler_duration;
+   this->handler_duration = NULL;
    this->getFuncArg = NULL;
    this->subFuncArg = NULL;
    this->putFuncArg = NULL;
@@ -323,6 +612,44 @@ ACAI::Client::PrivateData::~PrivateData ()
    this->event_id = NULL;
 }
 
+//------------------------------------------------------------------------------
+// static
+void* ACAI::Client::PrivateData::operator new (size_t size)
+{
+   // Over allocate and align to a cache line boundary. The address returned by
+   // malloc is saved just before the aligned address so that it may be freed.
+   //
+   void* raw = malloc (size + CACHE_LINE_SIZE + sizeof (void*));
+   if (!raw) throw std::bad_alloc ();
+
+   const size_t aligned = (size_t (raw) + sizeof (void*) + CACHE_LINE_SIZE - 1) &
+                          ~size_t (CACHE_LINE_SIZE - 1);
+   ((void**) aligned) [-1] = raw;
+   return (void*) aligned;
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Client::PrivateData::operator delete (void* ptr)
+{
+   if (ptr) {
+      free (((void**) ptr) [-1]);
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::PrivateData::setMetaData (ACAI::Meta_Data* metaIn)
+{
+   // Intern the new block before releasing the old block. When the content is
+   // unchanged, e.g. on a re-read, this avoids destroying and then re-creating
+   // an otherwise unshared block.
+   //
+   const ACAI::Meta_Data* previous = this->meta;
+   this->meta = ACAI::Meta_Data::intern (metaIn);
+   ACAI::Meta_Data::release (previous);
+}
+
 //------------------------------------------------------------------------------
 // Free any allocated values data buffer.
 // This function is idempotent.
@@ -338,6 +665,34 @@ void ACAI::Client::PrivateData::clearBuffer ()
    this->data_element_count = 0;
 }
 
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::PrivateData::setDeferredPut (const chtype type,
+                                                const unsigned long count,
+                                                const void* dataPtr)
+{
+   // For the plain DBR types, i.e. DBR_xxx == DBF_xxx, there is no header.
+   //
+   const size_t size = dbr_size_n (type, count);
+
+   if (size > this->deferred_put_capacity) {
+      void* buffer = realloc (this->deferred_put_buffer, size);
+      if (!buffer) return false;
+      this->deferred_put_buffer = buffer;
+      this->deferred_put_capacity = size;
+   }
+
+   // A deferred put may be deferred again, i.e. the data already in place.
+   //
+   if (dataPtr != this->deferred_put_buffer) {
+      memcpy (this->deferred_put_buffer, dataPtr, size);
+   }
+   this->deferred_put_type = type;
+   this->deferred_put_count = count;
+   this->has_deferred_put = true;
+   return true;
+}
+
 //------------------------------------------------------------------------------
 //
 const union db_access_val* ACAI::Client::PrivateData::updateBuffer (struct event_handler_args& args)
@@ -411,7 +766,7 @@ void ACAI::Client::commonConstruct()
    this->userRefTag = NULL;
    this->userStringTag = "";
 
-   // Set magic number - used by validate channel id.
+   // Set magic number - used by cast.
    //
    this->magic_number = MAGIC_NUMBER_C;
 }
@@ -537,81 +892,672 @@ unsigned int ACAI::Client::requestCount (bool& isDefined) const
 
 //------------------------------------------------------------------------------
 //
-void ACAI::Client::setPriority (const unsigned int priority)
+void ACAI::Client::setAdaptiveRequestCount (const bool adaptive,
+                                            const ACAI::ClientString& lengthPvName)
 {
-   this->pd->priority = LIMIT (priority, 0, 99);
+   this->pd->adaptive_length_pv_name = lengthPvName;
+
+   if (adaptive == this->pd->adaptive_request) return;
+   this->pd->adaptive_request = adaptive;
+
+   if (adaptive) {
+      this->startAdaptiveMonitor ();
+   } else {
+      this->stopAdaptiveMonitor ();
+
+      // Revert to the non adaptive request count.
+      //
+      if (this->pd->adaptive_count > 0) {
+         this->pd->adaptive_count = 0;
+         this->resubscribeChannel ();
+      }
+   }
 }
 
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::adaptiveRequestCount () const
+{
+   return this->pd->adaptive_request;
+}
 
-unsigned int ACAI::Client::priority () const
+//------------------------------------------------------------------------------
+//
+unsigned int ACAI::Client::adaptiveCount () const
 {
-   return this->pd->priority;
+   return this->pd->adaptive_count;
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Client::adaptiveBytesSaved () const
+{
+   return this->pd->adaptive_bytes_saved;
 }
 
+//------------------------------------------------------------------------------
+//
+int ACAI::Client::adaptiveResubscribeCount () const
+{
+   return this->pd->adaptive_resubscribe_count;
+}
 
 //------------------------------------------------------------------------------
 //
-void ACAI::Client::setLongString (const bool isLongStringIn)
+size_t ACAI::Client::updatesReceived () const
 {
-   this->pd->isLongString = isLongStringIn;
+   return this->pd->updates_received;
 }
 
+//------------------------------------------------------------------------------
+//
+size_t ACAI::Client::updatesDispatched () const
+{
+   return this->pd->updates_dispatched;
+}
 
-bool ACAI::Client::isLongString () const
+//------------------------------------------------------------------------------
+//
+double ACAI::Client::bytesReceived () const
 {
-   return this->pd->isLongString;
+   return this->pd->bytes_received;
 }
 
 //------------------------------------------------------------------------------
 //
-void ACAI::Client::setReadMode (const ACAI::ReadModes readModeIn)
+double ACAI::Client::lastUpdateInterval () const
 {
-   this->pd->readMode = readModeIn;
+   return this->pd->last_update_interval;
 }
 
-ACAI::ReadModes ACAI::Client::readMode () const
+//------------------------------------------------------------------------------
+//
+int ACAI::Client::maximumBurst () const
 {
-   return this->pd->readMode;
+   return this->pd->maximum_burst;
 }
 
 //------------------------------------------------------------------------------
 //
-void ACAI::Client::setEventMask (const ACAI::EventMasks eventMaskIn)
+double ACAI::Client::updateRate () const
 {
-   this->pd->eventMask = eventMaskIn;
+   const double elapsed = double (epicsMonotonicGet () - this->pd->counters_start_time) * 1.0e-9;
+   return elapsed > 0.0 ? double (this->pd->updates_received) / elapsed : 0.0;
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Client::byteRate () const
+{
+   const double elapsed = double (epicsMonotonicGet () - this->pd->counters_start_time) * 1.0e-9;
+   return elapsed > 0.0 ? this->pd->bytes_received / elapsed : 0.0;
 }
 
-ACAI::EventMasks ACAI::Client::eventMask () const
-{
-   return this->pd->eventMask;
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::resetUpdateCounters ()
+{
+   this->pd->updates_received = 0;
+   this->pd->updates_dispatched = 0;
+   this->pd->bytes_received = 0.0;
+   this->pd->counters_start_time = epicsMonotonicGet ();
+   this->pd->last_update_time = 0;
+   this->pd->last_update_interval = 0.0;
+   this->pd->burst_count = 0;
+   this->pd->maximum_burst = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setLatencyStatistics (const bool enabled)
+{
+   if (enabled) {
+      if (!this->pd->queue_latency) {
+         this->pd->queue_latency = new ACAI::Latency_Histogram ();
+         this->pd->handler_duration = new ACAI::Latency_Histogram ();
+      } else {
+         this->pd->queue_latency->reset ();
+         this->pd->handler_duration->reset ();
+      }
+   } else {
+      delete this->pd->queue_latency;
+      this->pd->queue_latency = NULL;
+      delete this->pd->handler_duration;
+      this->pd->handler_duration = NULL;
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::latencyStatistics () const
+{
+   return this->pd->queue_latency != NULL;
+}
+
+//------------------------------------------------------------------------------
+//
+const ACAI::Latency_Histogram* ACAI::Client::queueLatencyHistogram () const
+{
+   return this->pd->queue_latency;
+}
+
+//------------------------------------------------------------------------------
+//
+const ACAI::Latency_Histogram* ACAI::Client::handlerDurationHistogram () const
+{
+   return this->pd->handler_duration;
+}
+
+//------------------------------------------------------------------------------
+// Creates the companion client, if applicable and not already created.
+//
+void ACAI::Client::startAdaptiveMonitor ()
+{
+   if (!this->pd->adaptive_request || this->pd->adaptive_companion) return;
+   if (!this->isConnected () || (this->pd->readMode != ACAI::Subscribe)) return;
+   if (this->pd->channel_element_count <= 1) return;   // not an array
+
+   ACAI::ClientString lengthPvName = this->pd->adaptive_length_pv_name;
+   if (lengthPvName.empty ()) {
+      // Replace any field name with NORD.
+      //
+      lengthPvName = this->pd->pv_name;
+      const size_t dot = lengthPvName.find_last_of ('.');
+      if ((dot != ACAI::ClientString::npos) &&
+          (lengthPvName.find_first_of (':', dot) == ACAI::ClientString::npos)) {
+         lengthPvName.erase (dot);
+      }
+      lengthPvName += ".NORD";
+   }
+
+   ACAI::Client* companion = new ACAI::Client (lengthPvName);
+   companion->setDataRequestType (ACAI::ClientFieldLONG);
+   companion->userRefTag = this;
+   companion->setUpdateHandler (ACAI::Client::adaptiveLengthUpdate);
+   this->pd->adaptive_companion = companion;
+
+   if (!companion->openChannel ()) {
+      reportError ("adaptive request count (%s) failed to open %s",
+                   this->pd->cPvName(), lengthPvName.c_str ());
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::stopAdaptiveMonitor ()
+{
+   if (this->pd->adaptive_companion) {
+      delete this->pd->adaptive_companion;
+      this->pd->adaptive_companion = NULL;
+   }
+}
+
+//------------------------------------------------------------------------------
+// Re-makes the current subscription, e.g. with a new request count.
+// Unlike unsubscribeChannel, this is not a disconnection. As per
+// resumeSubscription, there is no initial (meta data) read - the new
+// subscription's first update suffices. Returns true if re-made.
+//
+bool ACAI::Client::resubscribeChannel ()
+{
+   if (!this->isConnected () || (this->pd->readMode != ACAI::Subscribe)) return false;
+   if (this->pd->subscription_paused) return false;   // applied on resume
+
+   this->clearSubscription ();
+   return this->readSubscribeChannel (ACAI::Subscribe, false);
+}
+
+//------------------------------------------------------------------------------
+// The request count ignoring any adaptive request count.
+//
+unsigned int ACAI::Client::nonAdaptiveRequestCount () const
+{
+   unsigned int count = this->pd->channel_element_count;
+   if (this->pd->request_element_count_defined) {
+      count = MIN (count, this->pd->request_element_count);
+   }
+   return count;
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Client::adaptiveLengthUpdate (ACAI::Client* companion, const bool)
+{
+   static const unsigned int minimumAdaptiveCount = 16;
+
+   if (!companion) return;
+   ACAI::Client* self = (ACAI::Client*) companion->userRefTag;
+   if (!self || (self->pd->adaptive_companion != companion)) return;
+
+   const int used = companion->getInteger ();
+   const unsigned int limit = self->nonAdaptiveRequestCount ();
+   if (limit == 0) return;
+
+   // Next power of two no less than the number of elements in use.
+   //
+   unsigned int target = minimumAdaptiveCount;
+   while ((target < (unsigned int) MAX (used, 0)) && (target < limit)) {
+      target *= 2;
+   }
+   target = MIN (target, limit);
+
+   const unsigned int current = self->pd->adaptive_count;
+   const bool grow = (current == 0) || ((unsigned int) MAX (used, 0) > current);
+   const bool shrink = (current > 0) && (target <= current / 4);
+
+   if ((grow || shrink) && (target != current)) {
+      self->pd->adaptive_count = target;
+      if (self->resubscribeChannel ()) {
+         self->pd->adaptive_resubscribe_count++;
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setPriority (const unsigned int priority)
+{
+   this->pd->priority = LIMIT (priority, 0, 99);
+}
+
+
+unsigned int ACAI::Client::priority () const
+{
+   return this->pd->priority;
+}
+
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setLongString (const bool isLongStringIn)
+{
+   this->pd->isLongString = isLongStringIn;
+}
+
+
+bool ACAI::Client::isLongString () const
+{
+   return this->pd->isLongString;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setReadMode (const ACAI::ReadModes readModeIn)
+{
+   this->pd->readMode = readModeIn;
+}
+
+ACAI::ReadModes ACAI::Client::readMode () const
+{
+   return this->pd->readMode;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setEventMask (const ACAI::EventMasks eventMaskIn)
+{
+   this->pd->eventMask = eventMaskIn;
+}
+
+ACAI::EventMasks ACAI::Client::eventMask () const
+{
+   return this->pd->eventMask;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setUpdateDeadband (const double absolute, const double relative)
+{
+   this->pd->update_absolute_deadband = MAX (absolute, 0.0);
+   this->pd->update_relative_deadband = MAX (relative, 0.0);
+   this->applyUpdateFilter ();
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Client::updateAbsoluteDeadband () const
+{
+   return this->pd->update_absolute_deadband;
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Client::updateRelativeDeadband () const
+{
+   return this->pd->update_relative_deadband;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setUpdateMinimumInterval (const double interval)
+{
+   this->pd->update_minimum_interval = MAX (interval, 0.0);
+   this->applyUpdateFilter ();
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Client::updateMinimumInterval () const
+{
+   return this->pd->update_minimum_interval;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setUpdateMaximumRate (const double rate)
+{
+   this->setUpdateMinimumInterval (rate > 0.0 ? 1.0 / rate : 0.0);
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client::filteredUpdateCount () const
+{
+   return buffered_update_filter_count (this->pd->subFuncArg);
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::applyUpdateFilter ()
+{
+   if (!this->pd->subFuncArg) return;   // not subscribed - applied when we are
+
+   const int status = set_buffered_update_filter (this->pd->subFuncArg,
+                                                  this->pd->update_absolute_deadband,
+                                                  this->pd->update_relative_deadband,
+                                                  this->pd->update_minimum_interval);
+   if (status != 0) {
+      reportError ("set_buffered_update_filter (%s) failed", this->pd->cPvName());
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setRetainSubscription (const bool retain)
+{
+   this->pd->retain_subscription = retain;
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::retainSubscription () const
+{
+   return this->pd->retain_subscription;
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client::retainedSubscriptionCount () const
+{
+   return this->pd->retained_subscription_count;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setLazyMetaData (const bool lazy)
+{
+   this->pd->lazy_meta_data = lazy;
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::lazyMetaData () const
+{
+   return this->pd->lazy_meta_data;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::pauseSubscription ()
+{
+   if (this->pd->subscription_paused) return;
+   this->pd->subscription_paused = true;
+   this->clearSubscription ();
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::resumeSubscription ()
+{
+   if (!this->pd->subscription_paused) return;
+   this->pd->subscription_paused = false;
+
+   // The subscription's first update provides the current value, so there is
+   // no need for another initial (meta data) read.
+   //
+   if (this->isConnected () && (this->pd->readMode == ACAI::Subscribe) &&
+       !this->pd->event_id) {
+      this->readSubscribeChannel (ACAI::Subscribe, false);
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::isSubscriptionPaused () const
+{
+   return this->pd->subscription_paused;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setUsePutCallback (const bool usePutCallbackIn)
+{
+   this->pd->use_put_callback = usePutCallbackIn;
+}
+
+bool ACAI::Client::usePutCallback () const
+{
+   return this->pd->use_put_callback;
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::isPendingPutCallback () const
+{
+   return this->pd->pending_put_callback;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::clearPendingPutCallback ()
+{
+   if (this->pd->pending_put_callback) {
+      this->pd->pending_put_callback = false;
+      this->callPutCallbackNotifcation (false);
+
+      // As per eventHandler, a put issued by the notification handlers
+      // supersedes the deferred put.
+      //
+      if (this->pd->pending_put_callback) {
+         this->pd->has_deferred_put = false;
+      } else {
+         this->issueDeferredPut ();
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setPutCoalescing (const bool putCoalescingIn)
+{
+   this->pd->put_coalescing = putCoalescingIn;
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::putCoalescing () const
+{
+   return this->pd->put_coalescing;
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::hasDeferredPut () const
+{
+   return this->pd->has_deferred_put;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setPutMinimumInterval (const double interval)
+{
+   this->pd->put_minimum_interval = MAX (interval, 0.0);
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Client::putMinimumInterval () const
+{
+   return this->pd->put_minimum_interval;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setPutDeadband (const double deadband)
+{
+   this->pd->put_deadband = MAX (deadband, 0.0);
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Client::putDeadband () const
+{
+   return this->pd->put_deadband;
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client::suppressedPutCount () const
+{
+   return this->pd->suppressed_put_count;
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client::deferredPutCount () const
+{
+   return this->pd->deferred_put_count_total;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::resetPutThrottleCounts ()
+{
+   this->pd->suppressed_put_count = 0;
+   this->pd->deferred_put_count_total = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::throttlePut (const int dbf_type, const unsigned long count,
+                                const void* dataPtr, bool& status)
+{
+   const chtype type = chtype (dbf_type);
+
+   // Deadband - scalar numeric puts only.
+   //
+   if ((this->pd->put_deadband > 0.0) && this->pd->has_last_put_value &&
+       (count == 1) && ((type == DBF_DOUBLE) || (type == DBF_LONG))) {
+
+      const double value = (type == DBF_DOUBLE) ? *((const dbr_double_t*) dataPtr)
+                                                : *((const dbr_long_t*) dataPtr);
+
+      if (ABS (value - this->pd->last_put_value) < this->pd->put_deadband) {
+         // The latest value is effectively that already written, so any value
+         // deferred by the minimum interval is now superseded.
+         //
+         if (this->pd->has_deferred_put && this->pd->throttle_deferred_put) {
+            this->pd->has_deferred_put = false;
+            this->pd->throttle_deferred_put = false;
+            this->pd->suppressed_put_count++;
+         }
+         this->pd->suppressed_put_count++;
+         status = true;
+         return true;
+      }
+   }
+
+   // Minimum interval.
+   //
+   if ((this->pd->put_minimum_interval > 0.0) &&
+       (monotonicTime () < this->pd->next_put_time)) {
+
+      if (this->pd->has_deferred_put) {
+         this->pd->suppressed_put_count++;    // superseded
+      }
+
+      status = this->pd->setDeferredPut (type, count, dataPtr);
+      if (!status) {
+         reportError ("putData (%s) unable to allocate deferred put buffer",
+                      this->pd->cPvName());
+         return true;
+      }
+
+      this->pd->throttle_deferred_put = true;
+      if (dataPtr != this->pd->deferred_put_buffer) {
+         this->pd->deferred_put_count_total++;    // i.e. not a re-deferral
+      }
+
+      epicsGuard<epicsMutex> guard (throttledClientsMutex);
+      throttledClients.insert (this);
+      return true;
+   }
+
+   return false;   // not throttled
 }
 
 //------------------------------------------------------------------------------
-//
-void ACAI::Client::setUsePutCallback (const bool usePutCallbackIn)
+// Note: as per the put functions themselves, the throttle state of each client
+// is only accessed by the poll thread. The mutex only protects the set itself,
+// e.g. for clients deleted by other threads while not throttled. Issuing a
+// deferred put calls no user code, so cannot delete any other due client.
+// static
+void ACAI::Client::processThrottledPuts ()
 {
-   this->pd->use_put_callback = usePutCallbackIn;
-}
+   std::vector<ACAI::Client*> due;
 
-bool ACAI::Client::usePutCallback () const
-{
-   return this->pd->use_put_callback;
-}
+   {
+      epicsGuard<epicsMutex> guard (throttledClientsMutex);
+      if (throttledClients.empty ()) return;
+
+      const double now = monotonicTime ();
+      Throttled_Client_Sets::iterator it = throttledClients.begin ();
+      while (it != throttledClients.end ()) {
+         ACAI::Client* client = *it;
+         if (!client->pd->has_deferred_put || !client->pd->throttle_deferred_put) {
+            throttledClients.erase (it++);       // no longer relevant
+         } else if (now >= client->pd->next_put_time) {
+            due.push_back (client);
+            throttledClients.erase (it++);
+         } else {
+            ++it;
+         }
+      }
+   }
 
-//------------------------------------------------------------------------------
-//
-bool ACAI::Client::isPendingPutCallback () const
-{
-   return this->pd->pending_put_callback;
+   // Issue outside of the mutex - putData may re-insert the client.
+   //
+   for (size_t j = 0; j < due.size (); j++) {
+      due [j]->issueDeferredPut ();
+   }
 }
 
 //------------------------------------------------------------------------------
 //
-void ACAI::Client::clearPendingPutCallback ()
+void ACAI::Client::issueDeferredPut ()
 {
-   if (this->pd->pending_put_callback) {
-      this->pd->pending_put_callback = false;
-      this->callPutCallbackNotifcation (false);
+   if (!this->pd->has_deferred_put) return;
+
+   // Clear first - putData may well re-defer if the user has, in the meantime,
+   // already issued another put.
+   //
+   this->pd->has_deferred_put = false;
+   this->pd->throttle_deferred_put = false;
+   const bool status = this->putData (this->pd->deferred_put_type,
+                                      this->pd->deferred_put_count,
+                                      this->pd->deferred_put_buffer);
+   if (!status) {
+      reportError ("issueDeferredPut (%s) failed", this->pd->cPvName());
    }
 }
 
@@ -641,11 +1587,23 @@ bool ACAI::Client::openChannel ()
 
    if (!this->pd->pv_name.empty()) {
 
-      status = ca_create_channel (this->pd->cPvName(),
-                                  buffered_connection_handler,
-                                  this,     // user private
-                                  this->pd->priority,
-                                  &this->pd->channel_id);
+      // The channel's user data is a generational handle as opposed to this
+      // object's address. This allows callbacks queued for a channel that has
+      // since been closed, or a client that has since been deleted, to be
+      // safely identified and dropped.
+      //
+      this->pd->handle = ACAI::Handle_Table::allocate (this);
+      if (!this->pd->handle) {
+         reportError ("openChannel (%s) failed - no handle available",
+                      this->pd->cPvName());
+         return false;
+      }
+
+      status = backend ()->create_channel (this->pd->cPvName(),
+                                           buffered_connection_handler,
+                                           this->pd->handle,     // user private
+                                           this->pd->priority,
+                                           &this->pd->channel_id);
 
       if (status == ECA_NORMAL) {
          this->pd->connectionStatus = PrivateData::csPending;
@@ -653,6 +1611,9 @@ bool ACAI::Client::openChannel ()
       } else {
          reportError ("ca_create_channel (%s) failed (%s, %d)", this->pd->cPvName(),
                       ca_message (status), status);
+         ACAI::Handle_Table::release (this->pd->handle);
+         this->pd->handle = NULL;
+         this->pd->channel_id = NULL;
          result = false;
       }
    } else {
@@ -674,7 +1635,7 @@ void ACAI::Client::closeChannel ()
    // Close channel iff needs be.
    //
    if (this->pd->channel_id) {
-      status = ca_clear_channel (this->pd->channel_id);
+      status = backend ()->clear_channel (this->pd->channel_id);
       if (status != ECA_NORMAL) {
          reportError ("ca_clear_channel (%s) failed (%s)",
                       this->pd->cPvName(), ca_message (status));
@@ -683,8 +1644,36 @@ void ACAI::Client::closeChannel ()
       this->pd->channel_id = NULL;
    }
 
+   // The adaptive request count is re-determined if/when re-opened.
+   //
+   this->stopAdaptiveMonitor ();
+   this->pd->adaptive_count = 0;
+
+   // Any callbacks still queued for this channel are now stale.
+   //
+   if (this->pd->handle) {
+      ACAI::Handle_Table::release (this->pd->handle);
+      this->pd->handle = NULL;
+   }
+
+   this->completeAllCompletions (ACAI::Client_Completion::Cancelled);
+
    this->pd->connectionStatus = PrivateData::csNull;
    this->pd->pending_put_callback = false;
+   this->pd->has_deferred_put = false;
+   this->pd->throttle_deferred_put = false;
+   this->pd->has_last_put_value = false;
+
+   {
+      epicsGuard<epicsMutex> guard (throttledClientsMutex);
+      throttledClients.erase (this);
+   }
+
+   if (this->pd->connection_up_deferred) {
+      epicsGuard<epicsMutex> guard (deferredConnectionsMutex);
+      deferredConnections.remove (this);
+      this->pd->connection_up_deferred = false;
+   }
 
    // Free any allocated values buffer.
    //
@@ -842,11 +1831,12 @@ ACAI::ClientString ACAI::Client::getString (unsigned int index) const
       return result;
    }
 
-   if ((this->pd->includeUnits) && (strlen (this->pd->units) > 0)) {
+   if (this->pd->includeUnits) this->ensureMetaData ();
+   if ((this->pd->includeUnits) && (strlen (this->pd->meta->units) > 0)) {
       // Separate the value of and units by a space.
       //
       snprintf (append_units, sizeof (append_units), " %s",
-                this->pd->units);
+                this->pd->meta->units);
    } else {
       append_units[0] = '\0';
    }
@@ -1003,19 +1993,43 @@ bool ACAI::Client::putData (const int dbf_type, const unsigned long count, const
       return false;
    }
 
+   // Apply any outbound throttling.
+   //
+   if ((this->pd->put_minimum_interval > 0.0) || (this->pd->put_deadband > 0.0)) {
+      bool throttleStatus;
+      if (this->throttlePut (dbf_type, count, dataPtr, throttleStatus)) {
+         return throttleStatus;
+      }
+   }
+
    // Are we using put callback on this channel ?
    //
    if (this->pd->use_put_callback) {
       // Yes - are we already waiting for a callback ?
       //
       if (this->pd->pending_put_callback) {
+         // A throttled put, now issued by issueDeferredPut, is likewise held
+         // in the deferred put slot irrespective of put coalescing, so that
+         // the final setpoint is not lost.
+         //
+         if (this->pd->put_coalescing || (dataPtr == this->pd->deferred_put_buffer)) {
+            // Last value wins - overwrite any existing deferred put.
+            //
+            if (!this->pd->setDeferredPut (type, count, dataPtr)) {
+               reportError ("putData (%s) unable to allocate deferred put buffer",
+                            this->pd->cPvName());
+               return false;
+            }
+            return true;
+         }
+
          reportError ("putData (%s) write inhibited - pending put callback",
                       this->pd->cPvName());
          return false;
       }
 
-      status = ca_array_put_callback (type, count, this->pd->channel_id,
-                                      dataPtr, buffered_event_handler, this->pd->putFuncArg);
+      status = backend ()->array_put_callback (type, count, this->pd->channel_id,
+                                               dataPtr, buffered_event_handler, this->pd->putFuncArg);
 
       // If write was successful, set pending flag.
       //
@@ -1024,7 +2038,31 @@ bool ACAI::Client::putData (const int dbf_type, const unsigned long count, const
    } else {
       // No call back - just a regular put.
       //
-      status = ca_array_put (type, count, this->pd->channel_id, dataPtr);
+      status = backend ()->array_put (type, count, this->pd->channel_id, dataPtr);
+   }
+
+   ACAI_TRACE (ACAI::TracePut, this->pd->channel_id, epicsMonotonicGet (), 0,
+               dbr_size_n (type, count));
+
+   // Record throttle state for successful puts.
+   //
+   if (status == ECA_NORMAL) {
+      if (this->pd->put_minimum_interval > 0.0) {
+         this->pd->next_put_time = monotonicTime () + this->pd->put_minimum_interval;
+      }
+      if (count == 1) {
+         if (type == DBF_DOUBLE) {
+            this->pd->last_put_value = *((const dbr_double_t*) dataPtr);
+            this->pd->has_last_put_value = true;
+         } else if (type == DBF_LONG) {
+            this->pd->last_put_value = *((const dbr_long_t*) dataPtr);
+            this->pd->has_last_put_value = true;
+         } else {
+            this->pd->has_last_put_value = false;
+         }
+      } else {
+         this->pd->has_last_put_value = false;
+      }
    }
 
    // Convert to a boolean result.
@@ -1059,49 +2097,58 @@ bool ACAI::Client::putBoolean (const bool value)
 //------------------------------------------------------------------------------
 //
 bool ACAI::Client::putString (const ACAI::ClientString& value)
+{
+   // Include the c_str terminating null, which allows the string to be passed
+   // directly to channel access for long strings.
+   //
+   return this->putString (value.c_str (), value.length () + 1);
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::putString (const char* value, const size_t length)
 {
    typedef unsigned long ulong;
 
-   const char* c_str_val = value.c_str ();
-   bool result;
+   if (!value) return false;
 
    // Can this PV to be treated as a long string?
    //
-   if ((this->pd->host_field_type == ACAI::ClientFieldCHAR) &&
-       (this->hostElementCount () >= 2)) {
+   const size_t hostCount = this->hostElementCount ();
+   if ((this->pd->host_field_type == ACAI::ClientFieldCHAR) && (hostCount >= 2)) {
       // Yes - limit the size to hostElementCount.
       //
-      size_t count = strnlen (c_str_val, this->hostElementCount ());
+      const size_t limit = MIN (length, hostCount);
+      const size_t count = strnlen (value, limit);
 
-      if (count < this->dataElementCount ()) {
-         // plus 1 - include the trailing zero.
-         result = this->putData (DBF_CHAR, ulong (count + 1), c_str_val);
-
-      } else if (count <= 512) {    // 512 is a bit arbitary
-         // Just use a stack buffer.
-         //
-         char work [512];
-         snprintf (work, count, "%s", c_str_val);  // snprintf always forces a '\0'
-         result = this->putData (DBF_CHAR, ulong (count), work);
-
-      } else {
-         // Tooo big for stack, allocate/free work buffer.
+      if (count < limit) {
+         // The terminating null is within the given string and the string
+         // fits - pass directly to channel access (plus 1 for the null).
          //
-         char* work = (char*) malloc (count);
-         snprintf (work, count, "%s", c_str_val);  // snprintf always forces a '\0'
-         result = this->putData (DBF_CHAR, ulong (count), work);
-         free (work);
+         return this->putData (DBF_CHAR, ulong (count + 1), value);
       }
 
-   } else {
-      // No - convert and truncate ClientString to a basic C string.
+      // Copy and terminate, truncating if necessary, into the scratch buffer.
       //
-      dbr_string_t dbr_value;
-      snprintf (dbr_value, sizeof (dbr_value), "%s", c_str_val);
-      result = this->putData (DBF_STRING, 1, dbr_value);
+      const size_t n = MIN (count, hostCount - 1);
+      Scratch_Buffer scratch (n + 1);
+      char* work = (char*) scratch.pointer ();
+      if (!work) {
+         reportError ("putString (%s) scratch buffer allocation failed", this->pd->cPvName());
+         return false;
+      }
+      memcpy (work, value, n);
+      work [n] = '\0';
+      return this->putData (DBF_CHAR, ulong (n + 1), work);
    }
 
-   return result;
+   // No - convert and truncate to a basic C string.
+   //
+   dbr_string_t dbr_value;
+   const size_t n = strnlen (value, MIN (length, sizeof (dbr_value) - 1));
+   memcpy (dbr_value, value, n);
+   memset (dbr_value + n, 0, sizeof (dbr_value) - n);
+   return this->putData (DBF_STRING, 1, dbr_value);
 }
 
 //------------------------------------------------------------------------------
@@ -1145,14 +2192,18 @@ bool ACAI::Client::putIntegerArray (const ACAI::ClientIntegerArray& valueArray)
 //
 bool ACAI::Client::putBooleanArray (const bool* valueArray, const unsigned int count)
 {
-   ACAI::ClientIntegerArray intermediate;
+   Scratch_Buffer scratch (MAX (count, 1) * sizeof (dbr_long_t));
+   dbr_long_t* work = (dbr_long_t*) scratch.pointer ();
+   if (!work) {
+      reportError ("putBooleanArray (%s) scratch buffer allocation failed", this->pd->cPvName());
+      return false;
+   }
 
-   intermediate.reserve ((int) count);
    for (unsigned int j = 0; j < count; j++) {
-      intermediate.push_back (valueArray[j] ? 1 : 0);
+      work [j] = valueArray[j] ? 1 : 0;
    }
 
-   return this->putIntegerArray(intermediate);
+   return this->putData (DBF_LONG, count, work);
 }
 
 //------------------------------------------------------------------------------
@@ -1164,40 +2215,72 @@ bool ACAI::Client::putBooleanArray (const ACAI::ClientBooleanArray& valueArray)
    // const bool* podPtr = &valueArray [0]; // does not compile
    // lvalue required as unary '&' operand
 
-   ACAI::ClientIntegerArray intermediate;
+   Scratch_Buffer scratch (MAX (count, 1) * sizeof (dbr_long_t));
+   dbr_long_t* work = (dbr_long_t*) scratch.pointer ();
+   if (!work) {
+      reportError ("putBooleanArray (%s) scratch buffer allocation failed", this->pd->cPvName());
+      return false;
+   }
 
-   intermediate.reserve ((int) count);
    for (unsigned int j = 0; j < count; j++) {
-      intermediate.push_back (valueArray[j] ? 1 : 0);
+      work [j] = valueArray[j] ? 1 : 0;
    }
 
-   return this->putIntegerArray(intermediate);
+   return this->putData (DBF_LONG, count, work);
 }
 
 //------------------------------------------------------------------------------
 //
 bool ACAI::Client::putStringArray (const ACAI::ClientString* valueArray, const unsigned int count)
 {
-   bool result = false;
-
    // Convert and truncate ClientStrings array to basic c strings.
    //
-   dbr_string_t* buffer = NULL;
-   buffer = (dbr_string_t *) calloc ((size_t) count, sizeof (dbr_string_t));
-   if (buffer) {
-      for (unsigned int j = 0; j < count; j++) {
-         // Convert and truncate ClientString to basic c string.
-         // snprintf ensures zero terminated.
-         //
-         snprintf (buffer [j], sizeof (dbr_string_t), "%s", valueArray [j].c_str ());
-      }
+   Scratch_Buffer scratch (MAX (count, 1) * sizeof (dbr_string_t));
+   dbr_string_t* work = (dbr_string_t*) scratch.pointer ();
+   if (!work) {
+      reportError ("putStringArray (%s) scratch buffer allocation failed", this->pd->cPvName());
+      return false;
+   }
 
-      result = this->putData (DBF_STRING, count, buffer);
-      free ((void *) buffer);
-   } else {
-      reportError ("calloc failed (%d string elements)", count);
+   for (unsigned int j = 0; j < count; j++) {
+      const size_t n = MIN (valueArray [j].length (), sizeof (dbr_string_t) - 1);
+      memcpy (work [j], valueArray [j].c_str (), n);
+      memset (work [j] + n, 0, sizeof (dbr_string_t) - n);
    }
-   return result;
+
+   return this->putData (DBF_STRING, count, work);
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::putStringArray (const char* fixedStrings, const size_t stringSize,
+                                   const unsigned int count)
+{
+   if (!fixedStrings || (stringSize == 0)) return false;
+
+   // Is the caller's layout that of the channel access string type?
+   // If so, hand straight to channel access.
+   //
+   if (stringSize == sizeof (dbr_string_t)) {
+      return this->putData (DBF_STRING, count, fixedStrings);
+   }
+
+   Scratch_Buffer scratch (MAX (count, 1) * sizeof (dbr_string_t));
+   dbr_string_t* work = (dbr_string_t*) scratch.pointer ();
+   if (!work) {
+      reportError ("putStringArray (%s) scratch buffer allocation failed", this->pd->cPvName());
+      return false;
+   }
+
+   const size_t limit = MIN (stringSize, sizeof (dbr_string_t) - 1);
+   for (unsigned int j = 0; j < count; j++) {
+      const char* item = fixedStrings + (j * stringSize);
+      const size_t n = strnlen (item, limit);
+      memcpy (work [j], item, n);
+      memset (work [j] + n, 0, sizeof (dbr_string_t) - n);
+   }
+
+   return this->putData (DBF_STRING, count, work);
 }
 
 //------------------------------------------------------------------------------
@@ -1217,12 +2300,221 @@ bool ACAI::Client::putByteArray (const void* valueArray, const unsigned int coun
    return this->putData (DBF_CHAR, count, valueArray);
 }
 
+//------------------------------------------------------------------------------
+//
+ACAI::Client_Put_Completion* ACAI::Client::putDataAsync (const int dbf_type,
+                                                         const unsigned long count,
+                                                         const void* dataPtr,
+                                                         const double timeOut)
+{
+   ACAI::Client_Put_Completion* token = new ACAI::Client_Put_Completion (this, timeOut);
+
+   if (!this->isConnected () || !this->pd->channel_id) {
+      token->complete (ACAI::Client_Completion::Failed);
+      return token;
+   }
+
+   void* funcArg = this->uniqueFunctionArg ();
+   const int status = backend ()->array_put_callback (chtype (dbf_type), count,
+                                                      this->pd->channel_id, dataPtr,
+                                                      buffered_event_handler, funcArg);
+   ACAI_TRACE (ACAI::TracePut, this->pd->channel_id, epicsMonotonicGet (), 0,
+               dbr_size_n (dbf_type, count));
+
+   if (status == ECA_NORMAL) {
+      token->funcArg = funcArg;
+      this->pd->completions [funcArg] = token;
+   } else {
+      reportError ("ca_array_put_callback (%s) failed (%s)",
+                   this->pd->cPvName(), ca_message (status));
+      token->complete (ACAI::Client_Completion::Failed);
+   }
+   return token;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client_Put_Completion* ACAI::Client::putFloatingAsync (const ACAI::ClientFloating value,
+                                                             const double timeOut)
+{
+   const dbr_double_t dbr_value = (dbr_double_t) value;
+   return this->putDataAsync (DBF_DOUBLE, 1, &dbr_value, timeOut);
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client_Put_Completion* ACAI::Client::putIntegerAsync (const ACAI::ClientInteger value,
+                                                            const double timeOut)
+{
+   const dbr_long_t dbr_value = (dbr_long_t) value;
+   return this->putDataAsync (DBF_LONG, 1, &dbr_value, timeOut);
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client_Put_Completion* ACAI::Client::putStringAsync (const ACAI::ClientString& value,
+                                                           const double timeOut)
+{
+   typedef unsigned long ulong;
+
+   // Can this PV to be treated as a long string? If so, as per putString,
+   // truncating if necessary to the host element count.
+   //
+   const size_t hostCount = this->hostElementCount ();
+   if ((this->pd->host_field_type == ACAI::ClientFieldCHAR) && (hostCount >= 2)) {
+      const size_t n = MIN (value.length (), hostCount - 1);
+      Scratch_Buffer scratch (n + 1);
+      char* work = (char*) scratch.pointer ();
+      if (work) {
+         memcpy (work, value.c_str (), n);
+         work [n] = '\0';
+         return this->putDataAsync (DBF_CHAR, ulong (n + 1), work, timeOut);
+      }
+      ACAI::Client_Put_Completion* token = new ACAI::Client_Put_Completion (this, timeOut);
+      token->complete (ACAI::Client_Completion::Failed);
+      return token;
+   }
+
+   dbr_string_t dbr_value;
+   const size_t n = MIN (value.length (), sizeof (dbr_value) - 1);
+   memcpy (dbr_value, value.c_str (), n);
+   memset (dbr_value + n, 0, sizeof (dbr_value) - n);
+   return this->putDataAsync (DBF_STRING, 1, dbr_value, timeOut);
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client_Put_Completion* ACAI::Client::putFloatingArrayAsync
+      (const ACAI::ClientFloatingArray& valueArray, const double timeOut)
+{
+   const unsigned long count = (unsigned long) valueArray.size ();
+   const void* podPtr = count > 0 ? &valueArray [0] : NULL;
+   return this->putDataAsync (DBF_DOUBLE, count, podPtr, timeOut);
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client_Put_Completion* ACAI::Client::putIntegerArrayAsync
+      (const ACAI::ClientIntegerArray& valueArray, const double timeOut)
+{
+   const unsigned long count = (unsigned long) valueArray.size ();
+   const void* podPtr = count > 0 ? &valueArray [0] : NULL;
+   return this->putDataAsync (DBF_LONG, count, podPtr, timeOut);
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client_Get_Completion* ACAI::Client::getAsync (const double timeOut,
+                                                     const unsigned int elementCount)
+{
+   ACAI::Client_Get_Completion* token = new ACAI::Client_Get_Completion (this, timeOut);
+
+   if (!this->isConnected () || !this->pd->channel_id) {
+      token->complete (ACAI::Client_Completion::Failed);
+      return token;
+   }
+
+   // Determine the number of elements - never more than the channel has.
+   // The token's payload is sized to the number of elements received, so
+   // this bounds the memory used by each outstanding get.
+   //
+   unsigned long count = this->pd->channel_element_count;
+   if (elementCount > 0) {
+      count = MIN (count, elementCount);
+   } else if (this->pd->request_element_count_defined) {
+      count = MIN (count, this->pd->request_element_count);
+   }
+
+   ACAI::ClientFieldType actualRequestType = this->pd->data_request_type;
+   if (actualRequestType == ACAI::ClientFieldDefault) {
+      actualRequestType = this->pd->host_field_type;
+   }
+
+   const long dbrType = dbf_type_to_DBR_TIME (actualRequestType);
+   if ((count == 0) || (dbrType < 0)) {
+      token->complete (ACAI::Client_Completion::Failed);
+      return token;
+   }
+
+   void* funcArg = this->uniqueFunctionArg ();
+   const int status = backend ()->array_get_callback (chtype (dbrType), count,
+                                                      this->pd->channel_id,
+                                                      buffered_event_handler, funcArg);
+   if (status == ECA_NORMAL) {
+      token->funcArg = funcArg;
+      this->pd->completions [funcArg] = token;
+   } else {
+      reportError ("ca_array_get_callback (%s) failed (%s)",
+                   this->pd->cPvName(), ca_message (status));
+      token->complete (ACAI::Client_Completion::Failed);
+   }
+   return token;
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client::pendingCompletionCount () const
+{
+   return (int) this->pd->completions.size ();
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the callback args are for an asynchronous operation.
+//
+bool ACAI::Client::completionHandler (struct event_handler_args& args)
+{
+   if (this->pd->completions.empty ()) return false;
+
+   PrivateData::Completion_Maps::iterator it = this->pd->completions.find (args.usr);
+   if (it == this->pd->completions.end ()) return false;
+
+   // Detach before calling the token.
+   //
+   ACAI::Client_Completion* token = it->second;
+   this->pd->completions.erase (it);
+   token->funcArg = NULL;
+
+   try {
+      token->callbackReceived (args.status, args.type, args.count, args.dbr);
+   }
+   ACAI_CATCH_EXCEPTION
+
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::removeCompletion (void* funcArg)
+{
+   this->pd->completions.erase (funcArg);
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::completeAllCompletions (const int state)
+{
+   if (this->pd->completions.empty ()) return;
+
+   // Take a copy, as complete calls back to removeCompletion.
+   //
+   PrivateData::Completion_Maps copy;
+   copy.swap (this->pd->completions);
+
+   ACAI_ITERATE (PrivateData::Completion_Maps, copy, it) {
+      ACAI::Client_Completion* token = it->second;
+      token->funcArg = NULL;
+      token->complete (ACAI::Client_Completion::States (state));
+   }
+}
+
 //------------------------------------------------------------------------------
 //
 int ACAI::Client::enumerationStatesCount () const
 {
    int result;
 
+   this->ensureMetaData ();
+
    if (this->dataFieldType () == ClientFieldENUM) {
       // Is this an alarm status (.STAT) PV ?
       //
@@ -1233,7 +2525,7 @@ int ACAI::Client::enumerationStatesCount () const
       } else {
          // No - use channel access values.
          //
-         result = this->pd->num_states;
+         result = this->pd->meta->num_states;
       }
    } else {
       result = 0;
@@ -1267,7 +2559,7 @@ ACAI::ClientString ACAI::Client::getEnumeration (int state) const
          } else {
             // No - use channel access values.
             //
-            const char* source = this->pd->enum_strings [state];
+            const char* source = this->pd->meta->enum_strings [state];
 
             // If the enum values are at max size, there is no null end-of-string
             // character at the end of the value.  Do not run into next enum value
@@ -1397,14 +2689,14 @@ bool ACAI::Client::hasValidSeverity () const
 //
 bool ACAI::Client::readAccess () const
 {
-   return ca_read_access (this->pd->channel_id) != 0;
+   return backend ()->read_access (this->pd->channel_id) != 0;
 }
 
 //------------------------------------------------------------------------------
 //
 bool ACAI::Client::writeAccess () const
 {
-   return ca_write_access (this->pd->channel_id) != 0;
+   return backend ()->write_access (this->pd->channel_id) != 0;
 }
 
 //------------------------------------------------------------------------------
@@ -1462,7 +2754,8 @@ bool ACAI::Client::processingAsLongString () const
 //------------------------------------------------------------------------------
 // Get initial data and subscribe for updates.
 //
-bool ACAI::Client::readSubscribeChannel (const ACAI::ReadModes readMode)
+bool ACAI::Client::readSubscribeChannel (const ACAI::ReadModes readMode,
+                                         const bool initialRead)
 {
    static const unsigned long default_max_array_size = 16384;
 
@@ -1491,6 +2784,12 @@ bool ACAI::Client::readSubscribeChannel (const ACAI::ReadModes readMode)
       count = MIN (count, this->pd->request_element_count);
    }
 
+   // Likewise honor any adaptive request count.
+   //
+   if (this->pd->adaptive_request && (this->pd->adaptive_count > 0)) {
+      count = MIN (count, this->pd->adaptive_count);
+   }
+
    // Determine initial buffer request type and subscription buffer
    // request type, based on the request field type.
    //
@@ -1551,6 +2850,13 @@ bool ACAI::Client::readSubscribeChannel (const ACAI::ReadModes readMode)
          return false;
    }
 
+   // With lazy meta data, there is no control read. Any initial read, i.e. for
+   // a single read, is for time stamped data only.
+   //
+   if (this->pd->lazy_meta_data) {
+      initial_type = update_type;
+   }
+
    max_array_size = default_max_array_size;
 
    // Attempt to read EPICS_CA_MAX_ARRAY_BYTES environment variable.
@@ -1588,14 +2894,19 @@ bool ACAI::Client::readSubscribeChannel (const ACAI::ReadModes readMode)
 
    // Read data together with all meta data.
    //
-   if ((readMode == ACAI::SingleRead) || (readMode == ACAI::Subscribe)) {
+   // For lazy meta data and Subscribe, the subscription's first update
+   // suffices.
+   //
+   if (initialRead &&
+       ((readMode == ACAI::SingleRead) ||
+        ((readMode == ACAI::Subscribe) && !this->pd->lazy_meta_data))) {
 
       if (debugLevel >= 4) {
          reportError ("ca_array_get_callback  %s", this->pd->cPvName());
       }
 
-      status = ca_array_get_callback (initial_type, count, this->pd->channel_id,
-                                      buffered_event_handler, this->pd->getFuncArg);
+      status = backend ()->array_get_callback (initial_type, count, this->pd->channel_id,
+                                               buffered_event_handler, this->pd->getFuncArg);
 
       if (status != ECA_NORMAL) {
          reportError ("ca_array_get_callback (%s) failed (%s)", this->pd->cPvName(),
@@ -1615,48 +2926,200 @@ bool ACAI::Client::readSubscribeChannel (const ACAI::ReadModes readMode)
 
       // Allocate the unique subscription call back function argument.
       //
+      // Any update filter must be in place before the first update arrives.
+      //
       this->pd->subFuncArg = this->uniqueFunctionArg ();
-      status = ca_create_subscription (update_type, count, this->pd->channel_id,
-                                       this->pd->eventMask, buffered_event_handler,
-                                       this->pd->subFuncArg, &this->pd->event_id);
+      this->applyUpdateFilter ();
+      status = backend ()->create_subscription (update_type, count, this->pd->channel_id,
+                                                this->pd->eventMask, buffered_event_handler,
+                                                this->pd->subFuncArg, &this->pd->event_id);
 
       if (status != ECA_NORMAL) {
          reportError ("ca_create_subscription (%s) failed (%s)",
                       this->pd->cPvName(), ca_message (status));
+         clear_buffered_update_filter (this->pd->subFuncArg);
          return false;
       }
    }
 
-   return true;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::unsubscribeChannel ()
+{
+   // Any meta data property subscription is re-made on demand.
+   //
+   this->clearMetaDataSubscription ();
+
+   // Unsubscribe iff needs be.
+   //
+   if (this->pd->event_id) {
+      this->clearSubscription ();
+
+      // Save disconnection time
+      //
+      time (&this->pd->disconnect_time);
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::clearMetaDataSubscription ()
+{
+   if (this->pd->meta_event_id) {
+      const int status = backend ()->clear_subscription (this->pd->meta_event_id);
+      if (status != ECA_NORMAL) {
+         reportError ("ca_clear_subscription (%s) failed (%s)",
+                      this->pd->cPvName(), ca_message (status));
+      }
+      this->pd->meta_event_id = NULL;
+   }
+   this->pd->metaFuncArg = NULL;
+}
+
+//------------------------------------------------------------------------------
+// For lazy meta data, requests the meta data if not already requested.
+// The property subscription provides the meta data now and whenever it changes.
+//
+void ACAI::Client::ensureMetaData () const
+{
+   if (!this->pd->lazy_meta_data || this->pd->metaFuncArg) return;
+   if (!this->isConnected () || !this->pd->channel_id) return;
+
+   // Only request once per connection, even if the request fails or there is
+   // no meta data as such, e.g. for strings.
+   //
+   this->pd->metaFuncArg = ACAI::Client::uniqueFunctionArg ();
+
+   ACAI::ClientFieldType actualRequestType = this->pd->data_request_type;
+   if (actualRequestType == ACAI::ClientFieldDefault) {
+      actualRequestType = this->pd->host_field_type;
+   }
+   if (actualRequestType == ACAI::ClientFieldSTRING) return;
+
+   const long ctrlType = dbf_type_to_DBR_CTRL (actualRequestType);
+   if (ctrlType < 0) return;
+
+   if (debugLevel >= 4) {
+      reportError ("ca_create_subscription (property) %s", this->pd->cPvName());
+   }
+
+   const int status = backend ()->create_subscription (chtype (ctrlType), 1,
+                                                       this->pd->channel_id, DBE_PROPERTY,
+                                                       buffered_event_handler,
+                                                       this->pd->metaFuncArg,
+                                                       &this->pd->meta_event_id);
+   if (status != ECA_NORMAL) {
+      reportError ("ca_create_subscription (%s) property failed (%s)",
+                   this->pd->cPvName(), ca_message (status));
+      this->pd->meta_event_id = NULL;
+   }
 }
 
 //------------------------------------------------------------------------------
+// Clears the CA subscription, if any, but unlike unsubscribeChannel, this is
+// not deemed a disconnection.
 //
-void ACAI::Client::unsubscribeChannel ()
+void ACAI::Client::clearSubscription ()
 {
    int status;
 
-   // Unsubscribe iff needs be.
-   //
    if (this->pd->event_id) {
 
       if (debugLevel >= 4) {
          reportError ("ca_clear_subscription  %s", this->pd->cPvName());
       }
 
-      status = ca_clear_subscription (this->pd->event_id);
+      status = backend ()->clear_subscription (this->pd->event_id);
       if (status != ECA_NORMAL) {
          reportError ("ca_clear_subscription (%s) failed (%s)",
                       this->pd->cPvName(), ca_message (status));
       }
 
+      clear_buffered_update_filter (this->pd->subFuncArg);
       this->pd->event_id = NULL;
       this->pd->subFuncArg = NULL;
+   }
+}
 
-      // Save disconnection time
-      //
-      time (&this->pd->disconnect_time);
+//------------------------------------------------------------------------------
+// Creates a meta data block out of a DBR_CTRL_xxx structure. Returns NULL for
+// other types, e.g. DBR_STS_STRING which has no meta data, or if the allocation
+// fails.
+//
+static ACAI::Meta_Data* createMetaData (const long dbrType,
+                                        const union db_access_val* pDbr,
+                                        const bool isAlarmStatusPv)
+{
+#define ASSIGN_META_DATA(from, prec)                                       \
+   meta = ACAI::Meta_Data::create (0);                                     \
+   if (meta) {                                                             \
+      meta->precision = prec;                                              \
+      snprintf (meta->units, sizeof (meta->units), "%s", from.units);      \
+      meta->upper_disp_limit    = (double) from.upper_disp_limit;          \
+      meta->lower_disp_limit    = (double) from.lower_disp_limit;          \
+      meta->upper_alarm_limit   = (double) from.upper_alarm_limit;         \
+      meta->upper_warning_limit = (double) from.upper_warning_limit;       \
+      meta->lower_warning_limit = (double) from.lower_warning_limit;       \
+      meta->lower_alarm_limit   = (double) from.lower_alarm_limit;         \
+      meta->upper_ctrl_limit    = (double) from.upper_ctrl_limit;          \
+      meta->lower_ctrl_limit    = (double) from.lower_ctrl_limit;          \
+   }
+
+   ACAI::Meta_Data* meta = NULL;
+
+   switch (dbrType) {
+
+      case DBR_CTRL_SHORT:
+         ASSIGN_META_DATA (pDbr->cshrtval, 0);
+         break;
+
+      case DBR_CTRL_FLOAT:
+         ASSIGN_META_DATA (pDbr->cfltval, pDbr->cfltval.precision);
+         break;
+
+      case DBR_CTRL_ENUM:
+         meta = ACAI::Meta_Data::create (LIMIT (pDbr->cenmval.no_str, 0, MAX_ENUM_STATES));
+         if (meta) {
+            // Set up sensible display/control upper limit.
+            //
+            if (isAlarmStatusPv) {
+               meta->upper_disp_limit = ALARM_NSTATUS - 1.0;
+               meta->upper_ctrl_limit = ALARM_NSTATUS - 1.0;
+            } else {
+               meta->upper_disp_limit = meta->num_states - 1.0;
+               meta->upper_ctrl_limit = meta->num_states - 1.0;
+            }
+
+            // Only copy the states we actually have room for.
+            //
+            memcpy (meta->enum_strings, pDbr->cenmval.strs,
+                    meta->num_states * sizeof (meta->enum_strings [0]));
+         }
+         break;
+
+      case DBR_CTRL_CHAR:
+         ASSIGN_META_DATA (pDbr->cchrval, 0);
+         break;
+
+      case DBR_CTRL_LONG:
+         ASSIGN_META_DATA (pDbr->clngval, 0);
+         break;
+
+      case DBR_CTRL_DOUBLE:
+         ASSIGN_META_DATA (pDbr->cdblval, pDbr->cdblval.precision);
+         break;
+
+      default:
+         meta = NULL;
+         break;
    }
+
+#undef ASSIGN_META_DATA
+
+   return meta;
 }
 
 //------------------------------------------------------------------------------
@@ -1708,32 +3171,14 @@ void ACAI::Client::updateHandler (struct event_handler_args& args)
    tpd->timeStamp = from.stamp
 
 
-#define ASSIGN_META_DATA(from, prec)                                       \
-   tpd->precision = prec;                                                  \
-   snprintf (tpd->units, sizeof (tpd->units), "%s", from.units);           \
-   tpd->num_states = 0;                                                    \
-   tpd->upper_disp_limit    = (double) from.upper_disp_limit;              \
-   tpd->lower_disp_limit    = (double) from.lower_disp_limit;              \
-   tpd->upper_alarm_limit   = (double) from.upper_alarm_limit;             \
-   tpd->upper_warning_limit = (double) from.upper_warning_limit;           \
-   tpd->lower_warning_limit = (double) from.lower_warning_limit;           \
-   tpd->lower_alarm_limit   = (double) from.lower_alarm_limit;             \
-   tpd->upper_ctrl_limit    = (double) from.upper_ctrl_limit;              \
-   tpd->lower_ctrl_limit    = (double) from.lower_ctrl_limit;
+#define ASSIGN_META_DATA                                                   \
+   tpd->setMetaData (createMetaData (args.type, pDbr, this->isAlarmStatusPv ()));
 
 
+   // Reverts to the null meta data block.
+   //
 #define CLEAR_META_DATA                                                    \
-   tpd->precision = 0;                                                     \
-   tpd->units[0] = '\0';                                                   \
-   tpd->num_states = 0;                                                    \
-   tpd->upper_disp_limit    = 0.0;                                         \
-   tpd->lower_disp_limit    = 0.0;                                         \
-   tpd->upper_alarm_limit   = 0.0;                                         \
-   tpd->upper_warning_limit = 0.0;                                         \
-   tpd->lower_warning_limit = 0.0;                                         \
-   tpd->lower_alarm_limit   = 0.0;                                         \
-   tpd->upper_ctrl_limit    = 0.0;                                         \
-   tpd->lower_ctrl_limit    = 0.0;
+   tpd->setMetaData (NULL);
 
 
    size_t length;
@@ -1789,51 +3234,37 @@ void ACAI::Client::updateHandler (struct event_handler_args& args)
       case DBR_CTRL_SHORT:
          tpd->data_field_type = ClientFieldSHORT;
          ASSIGN_STATUS (pDbr->cshrtval);
-         ASSIGN_META_DATA (pDbr->cshrtval, 0);
+         ASSIGN_META_DATA;
          break;
 
       case DBR_CTRL_FLOAT:
          tpd->data_field_type = ClientFieldFLOAT;
          ASSIGN_STATUS (pDbr->cfltval);
-         ASSIGN_META_DATA (pDbr->cfltval, pDbr->cfltval.precision);
+         ASSIGN_META_DATA;
          break;
 
       case DBR_CTRL_ENUM:
          tpd->data_field_type = ClientFieldENUM;
          ASSIGN_STATUS (pDbr->cenmval);
-         CLEAR_META_DATA;
-         tpd->num_states = pDbr->cenmval.no_str;
-
-         // Set up sensible display/control upper limit.
-         //
-         if (this->isAlarmStatusPv ()) {
-            tpd->upper_disp_limit = ALARM_NSTATUS - 1.0;
-            tpd->upper_ctrl_limit = ALARM_NSTATUS - 1.0;
-         } else {
-            tpd->upper_disp_limit = tpd->num_states - 1.0;
-            tpd->upper_ctrl_limit = tpd->num_states - 1.0;
-         }
-
-         memcpy (tpd->enum_strings, pDbr->cenmval.strs,
-                 sizeof (tpd->enum_strings));
+         ASSIGN_META_DATA;
          break;
 
       case DBR_CTRL_CHAR:
          tpd->data_field_type = ClientFieldCHAR;
          ASSIGN_STATUS (pDbr->cchrval);
-         ASSIGN_META_DATA (pDbr->cchrval, 0);
+         ASSIGN_META_DATA;
          break;
 
       case DBR_CTRL_LONG:
          tpd->data_field_type = ClientFieldLONG;
          ASSIGN_STATUS (pDbr->clngval);
-         ASSIGN_META_DATA (pDbr->clngval, 0);
+         ASSIGN_META_DATA;
          break;
 
       case DBR_CTRL_DOUBLE:
          tpd->data_field_type = ClientFieldDOUBLE;
          ASSIGN_STATUS (pDbr->cdblval);
-         ASSIGN_META_DATA (pDbr->cdblval, pDbr->cdblval.precision);
+         ASSIGN_META_DATA;
          break;
 
          /// Time updates values [count], time, severity and status
@@ -1884,52 +3315,209 @@ void ACAI::Client::updateHandler (struct event_handler_args& args)
 #undef ASSIGN_META_DATA
 #undef CLEAR_META_DATA
 
+   tpd->updates_dispatched++;
    this->callDataUpdate (tpd->is_first_update);
    tpd->is_first_update = false;
 }
 
 //------------------------------------------------------------------------------
 //
-void ACAI::Client::connectionHandler (struct connection_handler_args& args)
+void ACAI::Client::processConnectionUp ()
 {
    char temp [200];
 
-   switch (args.op) {
+   if (debugLevel >= 4) {
+      reportError ("PV connected %s", this->pd->cPvName());
+   }
+   ACAI_TRACE (ACAI::TraceConnectionUp, this->pd->channel_id, epicsMonotonicGet (), 0, 0);
 
-      case CA_OP_CONN_UP:
-         if (debugLevel >= 4) {
-            reportError ("PV connected %s", this->pd->cPvName());
-         }
+   this->pd->connectionStatus = PrivateData::csConnected;
 
-         this->pd->connectionStatus = PrivateData::csConnected;
-         // Relies on our definitions being consistant.
-         this->pd->host_field_type = (ACAI::ClientFieldType) ca_field_type (this->pd->channel_id);
-         this->pd->channel_element_count = ca_element_count (this->pd->channel_id);
+   {
+      // Relies on our definitions being consistant.
+      //
+      const ACAI::ClientFieldType previousType = this->pd->host_field_type;
+      const unsigned int previousCount = this->pd->channel_element_count;
 
-         // Copy host name.
-         //
-         ca_get_host_name (this->pd->channel_id, temp, sizeof (temp));
-         temp [sizeof (temp) - 1] = '\0';                 // belts 'n' braces
-         this->pd->channel_host_name = temp;
+      this->pd->host_field_type = (ACAI::ClientFieldType) backend ()->field_type (this->pd->channel_id);
+      this->pd->channel_element_count = backend ()->element_count (this->pd->channel_id);
+
+      // A subscription retained over a disconnection is only re-made if
+      // the channel's type or element count has changed.
+      //
+      if (this->pd->event_id &&
+          ((this->pd->host_field_type != previousType) ||
+           (this->pd->channel_element_count != previousCount))) {
+         this->clearMetaDataSubscription ();
+         this->clearSubscription ();
+      }
+   }
+
+   // Copy host name.
+   //
+   backend ()->get_host_name (this->pd->channel_id, temp, sizeof (temp));
+   temp [sizeof (temp) - 1] = '\0';                 // belts 'n' braces
+   this->pd->channel_host_name = temp;
 
-         this->pd->data_element_count = 0;                // no data yet
-         this->pd->is_first_update = true;                // initial request.
+   this->pd->data_element_count = 0;                // no data yet
+   this->pd->is_first_update = true;                // initial request.
 
-         // Allocate the unique per connection get/put function callback arguments.
-         //
-         this->pd->getFuncArg = this->uniqueFunctionArg ();
-         this->pd->putFuncArg = this->uniqueFunctionArg ();
+   // Allocate the unique per connection get/put function callback arguments.
+   //
+   this->pd->getFuncArg = this->uniqueFunctionArg ();
+   this->pd->putFuncArg = this->uniqueFunctionArg ();
 
-         this->readSubscribeChannel (this->pd->readMode); // read and optionally subscribe.
-         this->callConnectionUpdate ();
+   // Read and optionally subscribe. A paused subscription is not re-made,
+   // but we do read the current value and meta data. A retained
+   // subscription is re-established by the CA library itself, and its
+   // first update provides the current value.
+   //
+   if (this->pd->event_id) {
+      this->pd->retained_subscription_count++;
+   } else if (this->pd->subscription_paused && (this->pd->readMode == ACAI::Subscribe)) {
+      this->readSubscribeChannel (ACAI::SingleRead);
+   } else {
+      this->readSubscribeChannel (this->pd->readMode);
+   }
+   this->startAdaptiveMonitor ();
+   this->callConnectionUpdate ();
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the connection up processing has been deferred.
+//
+bool ACAI::Client::deferConnectionUp ()
+{
+   // A retained subscription costs next to nothing to re-establish, and its
+   // updates may arrive at any time, so never defer.
+   //
+   if ((connectionBudgetLimit <= 0) || this->pd->event_id ||
+       (connectionsThisPoll < connectionBudgetLimit)) {
+      connectionsThisPoll++;
+      return false;
+   }
+
+   epicsGuard<epicsMutex> guard (deferredConnectionsMutex);
+   if (!this->pd->connection_up_deferred) {
+      this->pd->connection_up_deferred = true;
+      deferredConnections.push_back (this);
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Client::processDeferredConnections ()
+{
+   while ((connectionBudgetLimit <= 0) || (connectionsThisPoll < connectionBudgetLimit)) {
+      ACAI::Client* client = NULL;
+      {
+         epicsGuard<epicsMutex> guard (deferredConnectionsMutex);
+         if (deferredConnections.empty ()) break;
+         client = deferredConnections.front ();
+         deferredConnections.pop_front ();
+         client->pd->connection_up_deferred = false;
+      }
+
+      // The channel may have since disconnected.
+      //
+      connectionsThisPoll++;
+      if (client->pd->channel_id && (backend ()->state (client->pd->channel_id) == cs_conn)) {
+         client->processConnectionUp ();
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Client::setConnectionBudget (const int budget)
+{
+   connectionBudgetLimit = MAX (budget, 0);
+}
+
+//------------------------------------------------------------------------------
+// static
+int ACAI::Client::connectionBudget ()
+{
+   return connectionBudgetLimit;
+}
+
+//------------------------------------------------------------------------------
+// static
+int ACAI::Client::pendingConnections ()
+{
+   epicsGuard<epicsMutex> guard (deferredConnectionsMutex);
+   return (int) deferredConnections.size ();
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Client::getStatistics (ACAI::Client_Statistics& statistics)
+{
+   Buffered_Callback_Statistics buffered;
+   get_buffered_callback_statistics (&buffered);
+
+   statistics.queueLength = buffered.queue_length;
+   statistics.queueHighWaterMark = buffered.queue_high_water_mark;
+   statistics.heldCount = buffered.held_count;
+   statistics.enqueueCount = buffered.enqueue_count;
+   statistics.dequeueCount = buffered.dequeue_count;
+   statistics.connectionCallbackCount = buffered.connection_count;
+   statistics.eventCallbackCount = buffered.event_count;
+   statistics.printfCallbackCount = buffered.printf_count;
+   statistics.bytesBuffered = buffered.bytes_buffered;
+   statistics.totalBytesBuffered = buffered.total_bytes_buffered;
+   statistics.coalescedCount = buffered.coalesced_count;
+   statistics.filteredCount = buffered.filtered_count;
+   statistics.allocationFailures = buffered.allocate_fail_count;
+   statistics.connectionUpCount = buffered.connection_up_count;
+   statistics.connectionDownCount = buffered.connection_down_count;
+   statistics.pollCount = buffered.dispatch_count;
+   statistics.lastPollDuration = buffered.last_dispatch_duration;
+   statistics.maximumPollDuration = buffered.maximum_dispatch_duration;
+   statistics.totalPollDuration = buffered.total_dispatch_duration;
+   statistics.elapsedTime = buffered.elapsed_time;
+
+   statistics.openChannels = ACAI::Handle_Table::allocatedCount ();
+   statistics.pendingConnections = ACAI::Client::pendingConnections ();
+   ACAI::Meta_Data::internStatistics (statistics.metaDataBlocks,
+                                      statistics.metaDataReferences);
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Client::resetStatistics ()
+{
+   reset_buffered_callback_statistics ();
+   ACAI::globalQueueLatencyHistogram ().reset ();
+   ACAI::globalHandlerDurationHistogram ().reset ();
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::connectionHandler (struct connection_handler_args& args)
+{
+   switch (args.op) {
+
+      case CA_OP_CONN_UP:
+         // Subject to the connection budget, the connection up processing
+         // may be deferred to a subsequent poll.
+         //
+         if (this->deferConnectionUp ()) break;
+         this->processConnectionUp ();
          break;
 
       case CA_OP_CONN_DOWN:
          if (debugLevel >= 4) {
             reportError ("PV disconnected %s", this->pd->cPvName());
          }
+         ACAI_TRACE (ACAI::TraceConnectionDown, this->pd->channel_id, epicsMonotonicGet (), 0, 0);
 
          this->pd->pending_put_callback = false;          // clear
+         this->pd->has_deferred_put = false;              // discard
+         this->pd->throttle_deferred_put = false;
+         this->completeAllCompletions (ACAI::Client_Completion::Failed);
+         this->pd->has_last_put_value = false;
          this->pd->connectionStatus = PrivateData::csDisconnected;
 
          // We unsubscribe here to avoid a duplicate subscriptions if/when we
@@ -1937,8 +3525,13 @@ void ACAI::Client::connectionHandler (struct connection_handler_args& args)
          // but doing a new Subscribe on connect will do a new Array_Get and new
          // Subscribe which is good in case any PV meta data parameters (units,
          // precision, num elements, and even native type) have changed.
+         // Unless retaining the subscription - see setRetainSubscription.
          //
-         this->unsubscribeChannel ();
+         if (this->pd->retain_subscription) {
+            time (&this->pd->disconnect_time);
+         } else {
+            this->unsubscribeChannel ();
+         }
 
          // Clear unique call back function arguments.
          //
@@ -1968,6 +3561,19 @@ void ACAI::Client::eventHandler (struct event_handler_args& args)
 
       if (args.status == ECA_NORMAL) {
 
+         this->accountUpdate (args);
+
+         // Account for the bytes saved by any adaptive request count.
+         //
+         if ((this->pd->adaptive_count > 0) && (args.usr == this->pd->subFuncArg) &&
+             dbr_type_is_valid (args.type)) {
+            const unsigned int full = this->nonAdaptiveRequestCount ();
+            if (full > args.count) {
+               this->pd->adaptive_bytes_saved +=
+                     double (full - args.count) * dbr_value_size [args.type];
+            }
+         }
+
          if (args.dbr) {
             this->updateHandler (args);
          } else {
@@ -1981,20 +3587,38 @@ void ACAI::Client::eventHandler (struct event_handler_args& args)
       }
 
    } else if (args.usr == this->pd->putFuncArg) {
+      ACAI_TRACE (ACAI::TracePutCallback, args.chid, epicsMonotonicGet (), 0, 0);
       if (this->pd->pending_put_callback) {
          // Clear pending flag.
          //
          this->pd->pending_put_callback = false;
          this->callPutCallbackNotifcation (args.status == ECA_NORMAL);
 
+         // Issue any coalesced put, irrespective of the status of the previous
+         // put. Note: the notification handlers may themselves have issued a
+         // put, in which case that put has superseded the deferred put.
+         //
+         if (this->pd->pending_put_callback) {
+            this->pd->has_deferred_put = false;
+         } else {
+            this->issueDeferredPut ();
+         }
+
       } else {
          reportError ("event_handler (%s) unexpected put call back",
                       this->pd->cPvName());
       }
 
+   } else if (this->pd->metaFuncArg && (args.usr == this->pd->metaFuncArg)) {
+      this->metaDataHandler (args);
+
+   } else if (this->completionHandler (args)) {
+      // Handled by asynchronous operation completion token.
+
    } else {
       // Not unexpected as channel_id may be reused, so may still pass the
-      // validateChannelId check.
+      // validateChannelId check. Also not unexpected for an asynchronous
+      // operation that has timed out or been cancelled.
       //
       if (debugLevel >= 2) {
          reportError ("event_handler (%s) unexpected args.usr %lu",
@@ -2004,6 +3628,66 @@ void ACAI::Client::eventHandler (struct event_handler_args& args)
 }
 
 
+//------------------------------------------------------------------------------
+// Maintains the update rate and bandwidth counters. A burst is the number of
+// updates received for this client within a single poll, including any
+// updates coalesced while queued.
+//
+void ACAI::Client::accountUpdate (const struct event_handler_args& args)
+{
+   const epicsUInt64 now = epicsMonotonicGet ();
+   PrivateData* tpd = this->pd;
+
+   if (tpd->updates_received > 0) {
+      tpd->last_update_interval = double (now - tpd->last_update_time) * 1.0e-9;
+   }
+   tpd->last_update_time = now;
+
+   // Include any earlier updates coalesced into this one while queued, as
+   // these were received even though never dispatched.
+   //
+   size_t coalescedBytes;
+   const size_t coalesced = buffered_event_coalesced (&args, &coalescedBytes);
+
+   tpd->updates_received += 1 + coalesced;
+   tpd->bytes_received += double (coalescedBytes);
+
+   if (args.dbr && dbr_type_is_valid (args.type)) {
+      tpd->bytes_received += double (dbr_size_n (args.type, args.count));
+   }
+
+   if (tpd->burst_generation != pollGeneration) {
+      tpd->burst_generation = pollGeneration;
+      tpd->burst_count = 0;
+   }
+   tpd->burst_count += int (1 + coalesced);
+   if (tpd->burst_count > tpd->maximum_burst) {
+      tpd->maximum_burst = tpd->burst_count;
+   }
+}
+
+//------------------------------------------------------------------------------
+// Processes lazily fetched meta data - see ensureMetaData.
+//
+void ACAI::Client::metaDataHandler (struct event_handler_args& args)
+{
+   if ((args.status != ECA_NORMAL) || !args.dbr) {
+      reportError ("event_handler meta data (%s) error (%s)",
+                   this->pd->cPvName(), ca_message (args.status));
+      return;
+   }
+
+   this->pd->setMetaData (createMetaData (args.type,
+                                          (const union db_access_val*) args.dbr,
+                                          this->isAlarmStatusPv ()));
+
+   // Let the application know, e.g. so that it may re-format the value.
+   //
+   if (this->dataIsAvailable ()) {
+      this->callDataUpdate (false);
+   }
+}
+
 //------------------------------------------------------------------------------
 //
 void ACAI::Client::setConnectionHandler (ConnectionHandlers eventHandler)
@@ -2090,6 +3774,7 @@ void ACAI::Client::callConnectionUpdate ()
    // Create a pseudo update time.
    //
    this->pd->timeStamp = epicsTime::getCurrent ();
+   this->publishSnapshot ();
 
    // Call hook function, but only if necessary, i.e. if status has changed.
    //
@@ -2125,6 +3810,8 @@ void ACAI::Client::callConnectionUpdate ()
 //
 void ACAI::Client::callDataUpdate (const bool isFirstUpdateIn)
 {
+   this->publishSnapshot ();
+
    // Catch any exceptions here
    //
    try {
@@ -2181,6 +3868,109 @@ void ACAI::Client::callPutCallbackNotifcation (const bool isSuccessfulIn)
    ACAI_CATCH_EXCEPTION
 }
 
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::publishSnapshot ()
+{
+   Snapshot_Slot* slot = this->pd->snapshot;
+   if (!slot || !epicsAtomicGetIntT (&this->pd->publishSnapshots)) return;
+
+   // Form the snapshot locally, i.e. outside of the critical region.
+   //
+   ACAI::ClientSnapshot item;
+   memset (&item, 0, sizeof (item));
+
+   item.updateCount = ++this->pd->snapshotCount;
+   item.isConnected = this->isConnected ();
+   item.dataIsAvailable = this->dataIsAvailable ();
+   item.hostFieldType = this->hostFieldType ();
+   item.dataFieldType = this->dataFieldType ();
+   item.dataElementCount = this->dataElementCount ();
+   item.alarmSeverity = this->alarmSeverity ();
+   item.alarmStatus = this->alarmStatus ();
+   item.timeStamp = this->timeStamp ();
+   item.floatingValue = this->getFloating (0);
+   item.integerValue = this->getInteger (0);
+   snprintf (item.stringValue, sizeof (item.stringValue), "%s",
+             this->getString (0).c_str ());
+   item.precision = this->precision ();
+   snprintf (item.units, sizeof (item.units), "%s", this->units ().c_str ());
+   item.lowerDisplayLimit = this->lowerDisplayLimit ();
+   item.upperDisplayLimit = this->upperDisplayLimit ();
+
+   const int* source = (const int*) &item;
+   int* target = (int*) &slot->data;
+
+   epicsAtomicIncrIntT (&slot->sequence);    // now odd
+   epicsAtomicWriteMemoryBarrier ();
+   for (size_t j = 0; j < SNAPSHOT_WORDS; j++) {
+      epicsAtomicSetIntT (&target [j], source [j]);
+   }
+   epicsAtomicWriteMemoryBarrier ();
+   epicsAtomicIncrIntT (&slot->sequence);    // now even
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client::setSnapshotEnabled (const bool isEnabled)
+{
+   if (isEnabled && !this->pd->snapshot) {
+      Snapshot_Slot* slot = new Snapshot_Slot;
+      memset (slot, 0, sizeof (Snapshot_Slot));
+      epicsAtomicSetPtrT ((EpicsAtomicPtrT*) &this->pd->snapshot, slot);
+   }
+   epicsAtomicSetIntT (&this->pd->publishSnapshots, isEnabled ? 1 : 0);
+
+   // Ensure snapshot is up to date.
+   //
+   this->publishSnapshot ();
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::snapshotEnabled () const
+{
+   return epicsAtomicGetIntT (&this->pd->publishSnapshots) != 0;
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client::getSnapshot (ACAI::ClientSnapshot& snapshot) const
+{
+   const Snapshot_Slot* slot = (const Snapshot_Slot*)
+         epicsAtomicGetPtrT ((const EpicsAtomicPtrT*) &this->pd->snapshot);
+   if (!slot) return false;
+
+   // The slot is retained when snapshots are disabled, but its content is
+   // then no longer maintained.
+   //
+   if (!epicsAtomicGetIntT (&this->pd->publishSnapshots)) return false;
+
+   ACAI::ClientSnapshot item;
+   const int* source = (const int*) &slot->data;
+   int* target = (int*) &item;
+
+   for (int attempt = 1; true; attempt++) {
+      const int before = epicsAtomicGetIntT (&slot->sequence);
+      if ((before & 1) == 0) {
+         epicsAtomicReadMemoryBarrier ();
+         for (size_t j = 0; j < SNAPSHOT_WORDS; j++) {
+            target [j] = epicsAtomicGetIntT (&source [j]);
+         }
+         epicsAtomicReadMemoryBarrier ();
+         const int after = epicsAtomicGetIntT (&slot->sequence);
+         if (before == after) break;    // consistent copy
+      }
+
+      // A publication is in progress - allow the poll thread to complete it.
+      //
+      if (attempt % 64 == 0) epicsThreadSleep (0.0);
+   }
+
+   snapshot = item;
+   return true;
+}
+
 //------------------------------------------------------------------------------
 // TODO: Must/should we use a mutex access to this??
 //
@@ -2266,7 +4056,19 @@ void ACAI::Client::poll (const int maximum)
    //
    if (!acai_context) return;
 
-   const int status = ca_flush_io ();
+   // Issue any throttled puts now due prior to the flush.
+   //
+   ACAI::Client::processThrottledPuts ();
+
+   // Start a new connection budget cycle. Previously deferred connections are
+   // processed first, so as to be processed in arrival order.
+   //
+   connectionsThisPoll = 0;
+   ACAI::Client::processDeferredConnections ();
+
+   pollGeneration++;
+
+   const int status = backend ()->flush_io ();
    if (status != ECA_NORMAL) {
       reportError ("ca_flush_io failed - %s", ca_message (status));
    }
@@ -2280,7 +4082,7 @@ void ACAI::Client::flush ()
 {
    if (!acai_context) return;
 
-   const int status = ca_flush_io ();
+   const int status = backend ()->flush_io ();
    if (status != ECA_NORMAL) {
       reportError ("ca_flush_io failed - %s", ca_message (status));
    }
@@ -2329,10 +4131,14 @@ void* ACAI::Client::uniqueFunctionArg ()
 {
    static size_t id = 0;
 
-   id++;
-   if ((void*) id == NULL) id++;  // Ensure not NULL
+   // Channels may be opened from any attached thread, so use an atomic
+   // increment as opposed to a mutex - this is lock free on all the
+   // mainstream targets.
+   //
+   size_t result = epicsAtomicIncrSizeT (&id);
+   if (result == 0) result = epicsAtomicIncrSizeT (&id);  // Ensure not NULL
 
-   return (void*) id;
+   return (void*) result;
 }
 
 
@@ -2352,26 +4158,42 @@ type ACAI::Client::getName () const                                  \
 }
 
 
-//             type                        getName             member                 when_not_connected
-GET_META_DATA (ACAI::ClientAlarmSeverity,  alarmSeverity,      severity,              ClientDisconnected)
-GET_META_DATA (ACAI::ClientAlarmCondition, alarmStatus,        status,                   ClientAlarmNone)
-GET_META_DATA (int,                        precision,          precision,                              0)
-GET_META_DATA (ACAI::ClientString,         units,              units,                                 "")
-GET_META_DATA (double,                     lowerDisplayLimit,  lower_disp_limit,                     0.0)
-GET_META_DATA (double,                     upperDisplayLimit,  upper_disp_limit,                     0.0)
-GET_META_DATA (double,                     lowerControlLimit,  lower_ctrl_limit,                     0.0)
-GET_META_DATA (double,                     upperControlLimit,  upper_ctrl_limit,                     0.0)
-GET_META_DATA (double,                     lowerWarningLimit,  lower_warning_limit,                  0.0)
-GET_META_DATA (double,                     upperWarningLimit,  upper_warning_limit,                  0.0)
-GET_META_DATA (double,                     lowerAlarmLimit,    lower_alarm_limit,                    0.0)
-GET_META_DATA (double,                     upperAlarmLimit,    upper_alarm_limit,                    0.0)
-GET_META_DATA (ACAI::ClientString,         hostName,           channel_host_name,                     "")
-GET_META_DATA (unsigned int,               hostElementCount,   channel_element_count,                  0)
-GET_META_DATA (ACAI::ClientFieldType,      hostFieldType,      host_field_type,     ClientFieldNO_ACCESS)
-GET_META_DATA (ACAI::ClientFieldType,      dataFieldType,      data_field_type,     ClientFieldNO_ACCESS)
-GET_META_DATA (unsigned int,               dataElementCount,   data_element_count,                     0)
+// As above, but for the meta data block members - these may be fetched lazily.
+//
+#define GET_LAZY_META_DATA(type, getName, member, when_not_connected) \
+                                                                     \
+type ACAI::Client::getName () const                                  \
+{                                                                    \
+   if (this->isConnected ()) {                                       \
+      this->ensureMetaData ();                                       \
+      return (type) this->pd->member;                                \
+   } else {                                                          \
+      return (type) when_not_connected;                              \
+   }                                                                 \
+}
+
+
+//                  type                        getName             member                 when_not_connected
+GET_META_DATA      (ACAI::ClientAlarmSeverity,  alarmSeverity,      severity,              ClientDisconnected)
+GET_META_DATA      (ACAI::ClientAlarmCondition, alarmStatus,        status,                   ClientAlarmNone)
+GET_LAZY_META_DATA (int,                        precision,          meta->precision,                        0)
+GET_LAZY_META_DATA (ACAI::ClientString,         units,              meta->units,                           "")
+GET_LAZY_META_DATA (double,                     lowerDisplayLimit,  meta->lower_disp_limit,               0.0)
+GET_LAZY_META_DATA (double,                     upperDisplayLimit,  meta->upper_disp_limit,               0.0)
+GET_LAZY_META_DATA (double,                     lowerControlLimit,  meta->lower_ctrl_limit,               0.0)
+GET_LAZY_META_DATA (double,                     upperControlLimit,  meta->upper_ctrl_limit,               0.0)
+GET_LAZY_META_DATA (double,                     lowerWarningLimit,  meta->lower_warning_limit,            0.0)
+GET_LAZY_META_DATA (double,                     upperWarningLimit,  meta->upper_warning_limit,            0.0)
+GET_LAZY_META_DATA (double,                     lowerAlarmLimit,    meta->lower_alarm_limit,              0.0)
+GET_LAZY_META_DATA (double,                     upperAlarmLimit,    meta->upper_alarm_limit,              0.0)
+GET_META_DATA      (ACAI::ClientString,         hostName,           channel_host_name,                     "")
+GET_META_DATA      (unsigned int,               hostElementCount,   channel_element_count,                  0)
+GET_META_DATA      (ACAI::ClientFieldType,      hostFieldType,      host_field_type,     ClientFieldNO_ACCESS)
+GET_META_DATA      (ACAI::ClientFieldType,      dataFieldType,      data_field_type,     ClientFieldNO_ACCESS)
+GET_META_DATA      (unsigned int,               dataElementCount,   data_element_count,                     0)
 
 #undef GET_META_DATA
+#undef GET_LAZY_META_DATA
 
 //------------------------------------------------------------------------------
 //
@@ -2488,11 +4310,9 @@ const char* ACAI::Client::dbRequestTypeImage (const long type)
 
 //------------------------------------------------------------------------------
 // static
-ACAI::Client* ACAI::Client::validateChannelId (const void* channel_idx)
+ACAI::Client* ACAI::Client::validateChannelId (const void* handle,
+                                                const void* channel_id)
 {
-   const chid channel_id = (const chid) channel_idx;
-
-   void* user_data = NULL;
    ACAI::Client* result = NULL;
 
    // Hypothesize something wrong unless we pass all checks.
@@ -2502,19 +4322,20 @@ ACAI::Client* ACAI::Client::validateChannelId (const void* channel_idx)
       return NULL;
    }
 
-   user_data = ca_puser (channel_id);
-   if (user_data == NULL) {
+   if (handle == NULL) {
       reportError ("validateChannelId: Unassigned channel_id user data");
       return NULL;
    }
 
-   result = Client::cast (user_data);
+   // Note: we never dereference the handle nor the channel id. The handle is
+   // only ever looked up in the handle table.
+   //
+   result = ACAI::Handle_Table::lookup (handle);
    if (!result) {
       // Although a sensible check, no need to report this - it is not
       // unexpected to get an update for a channel that has just recently
-      // been deleted (magic_number fields are cleared when client deleted).
-      //
-      // reportError ("User data does not reference a ACAI::Client object (magic number check)");
+      // been closed or a client that has just recently been deleted - the
+      // handle is released in both cases.
       //
       return NULL;
    }
@@ -2527,7 +4348,7 @@ ACAI::Client* ACAI::Client::validateChannelId (const void* channel_idx)
       return NULL;
    }
 
-   if (result->pd->channel_id != channel_id) {
+   if ((const void*) result->pd->channel_id != channel_id) {
       // Similarly this a sensible check and also no need to report this error,
       // it is not unexpected for this to occur if/when a client is recycled.
       //
@@ -2596,24 +4417,61 @@ public:
    //
    static void connectionHandler (struct connection_handler_args& args)
    {
+      const epicsUInt64 start = epicsMonotonicGet ();
+      const void* handle = buffered_connection_puser (&args);
       ACAI::Client *pClient;
 
-      pClient = ACAI::Client::validateChannelId (args.chid);
+      pClient = ACAI::Client::validateChannelId (handle, args.chid);
       if (pClient) {
          pClient->connectionHandler (args);
       }
+
+      recordLatency (handle, buffered_connection_enqueue_time (&args), start);
+      ACAI_TRACE (ACAI::TraceQueued, args.chid, buffered_connection_enqueue_time (&args), start, 0);
+      ACAI_TRACE (ACAI::TraceDispatch, args.chid, start, epicsMonotonicGet (), 0);
    }
 
    //---------------------------------------------------------------------------
    //
    static void eventHandler (struct event_handler_args& args)
    {
+      const epicsUInt64 start = epicsMonotonicGet ();
+      const void* handle = buffered_event_puser (&args);
       ACAI::Client *pClient;
 
-      pClient = ACAI::Client::validateChannelId (args.chid);
+      pClient = ACAI::Client::validateChannelId (handle, args.chid);
       if (pClient) {
          pClient->eventHandler (args);
       }
+
+      recordLatency (handle, buffered_event_enqueue_time (&args), start);
+      ACAI_TRACE (ACAI::TraceQueued, args.chid, buffered_event_enqueue_time (&args), start, 0);
+      ACAI_TRACE (ACAI::TraceDispatch, args.chid, start, epicsMonotonicGet (),
+                  args.dbr && dbr_type_is_valid (args.type) ? dbr_size_n (args.type, args.count) : 0);
+   }
+
+   //---------------------------------------------------------------------------
+   // Records the queue latency, i.e. enqueue to dispatch, and the handler
+   // duration, globally and, if enabled, for the client. The handler may have
+   // closed or even deleted the client, hence the client is looked up again
+   // from its handle as opposed to re-using the validated pointer.
+   //
+   static void recordLatency (const void* handle,
+                              const epicsUInt64 enqueueTime,
+                              const epicsUInt64 start)
+   {
+      const epicsUInt64 finish = epicsMonotonicGet ();
+      const double latency = (start >= enqueueTime) ? double (start - enqueueTime) * 1.0e-9 : 0.0;
+      const double duration = double (finish - start) * 1.0e-9;
+
+      ACAI::globalQueueLatencyHistogram ().record (latency);
+      ACAI::globalHandlerDurationHistogram ().record (duration);
+
+      ACAI::Client* pClient = handle ? ACAI::Handle_Table::lookup (handle) : NULL;
+      if (pClient && pClient->pd->queue_latency) {
+         pClient->pd->queue_latency->record (latency);
+         pClient->pd->handler_duration->record (duration);
+      }
    }
 
    //---------------------------------------------------------------------------
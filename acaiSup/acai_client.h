@@ -40,6 +40,11 @@ struct event_handler_args;
 namespace ACAI {
 
 class Abstract_Client_User;    // differed declaration.
+class Client_Completion;       // differed declaration.
+class Client_Put_Completion;   // differed declaration.
+class Client_Get_Completion;   // differed declaration.
+class Latency_Histogram;       // differed declaration.
+struct Client_Statistics;      // differed declaration.
 
 /// \brief The ACAI::Client class is main class within the ACAI library.
 ///
@@ -169,6 +174,35 @@ public:
    //
    static void flush ();
 
+   /// Sets the connection budget, i.e. the maximum number of channel connections
+   /// processed, each of which involves a read and subscribe and a connection
+   /// update notification, per call to poll. Connections in excess of the budget
+   /// are queued and processed, in arrival order, by subsequent polls. This stops
+   /// a reconnection storm, e.g. when an IOC reboots, from stalling the poll
+   /// thread, so that updates for other channels continue to be dispatched.
+   /// A value <= 0, the default, means unlimited.
+   ///
+   static void setConnectionBudget (const int budget);
+
+   /// Returns the current connection budget.
+   ///
+   static int connectionBudget ();
+
+   /// Returns the number of connections currently queued due to the budget.
+   ///
+   static int pendingConnections ();
+
+   /// Takes a snapshot of the library's operational statistics, i.e. callback
+   /// queue, connection and poll dispatch statistics - see acai_statistics.h.
+   /// The statistics are always collected, and are cheap to collect.
+   ///
+   static void getStatistics (ACAI::Client_Statistics& statistics);
+
+   /// Resets the cumulative operational statistics and the global latency
+   /// histograms.
+   ///
+   static void resetStatistics ();
+
    /// Channel Access protocol version
    //
    static ACAI::ClientString protocolVersion ();
@@ -285,6 +319,99 @@ public:
    ///
    unsigned int requestCount (bool& isDefined) const;
 
+   /// Enables or disables the adaptive request count. This is intended for large
+   /// variable length waveforms served by IOCs that do not support dynamic arrays.
+   /// When enabled, an internal companion client monitors the number of elements
+   /// actually in use, by default the NORD field of the channel's record, or as
+   /// specified by lengthPvName. The subscription is then re-made with a right
+   /// sized request count: the next power of two no less than the number in use,
+   /// but not less than 16. The count grows as soon as more elements are in use,
+   /// but only shrinks once the number in use falls to a quarter of the current
+   /// count, so as to avoid resubscribing for small fluctuations. The adaptive
+   /// count is subject to any setRequestCount limit and to hostElementCount.
+   ///
+   /// Only applicable to the Subscribe read mode and array channels. When enabled
+   /// while connected, this takes effect immediately, otherwise on connection.
+   ///
+   void setAdaptiveRequestCount (const bool adaptive,
+                                 const ACAI::ClientString& lengthPvName = "");
+
+   /// Returns the adaptive request count status.
+   ///
+   bool adaptiveRequestCount () const;
+
+   /// Returns the current adaptive request count, or 0 if not yet determined.
+   ///
+   unsigned int adaptiveCount () const;
+
+   /// Returns the estimated number of bytes not transferred due to the adaptive
+   /// request count, i.e. the sum over all updates of the difference between the
+   /// non adaptive and actual update sizes.
+   ///
+   double adaptiveBytesSaved () const;
+
+   /// Returns the number of times the subscription has been re-made due to the
+   /// adaptive request count changing.
+   ///
+   int adaptiveResubscribeCount () const;
+
+   /// Update rate and bandwidth accounting. These counters are always
+   /// maintained, and are cumulative since the client was created or the last
+   /// call to resetUpdateCounters.
+   ///
+   /// updatesReceived returns the number of successful get and subscription
+   /// updates received, i.e. after any update filtering. This includes updates
+   /// coalesced in the callback queue, i.e. superseded by a later update for
+   /// the same subscription before being dispatched (see Client_Statistics::
+   /// coalescedCount), so that a flooding channel is not under-counted.
+   /// Likewise bytesReceived and maximumBurst.
+   ///
+   size_t updatesReceived () const;
+
+   /// Returns the number of data updates dispatched to the update handlers.
+   ///
+   size_t updatesDispatched () const;
+
+   /// Returns the total size, in bytes, of the updates received.
+   ///
+   double bytesReceived () const;
+
+   /// Returns the time, in seconds, between the last two updates received.
+   ///
+   double lastUpdateInterval () const;
+
+   /// Returns the maximum number of updates received within a single poll.
+   ///
+   int maximumBurst () const;
+
+   /// Return the mean update and byte rates, per second, since the counters
+   /// were started.
+   ///
+   double updateRate () const;
+   double byteRate () const;
+
+   /// Resets the update rate and bandwidth counters.
+   ///
+   void resetUpdateCounters ();
+
+   /// Enables or disables per client latency statistics, i.e. histograms of the
+   /// time each of this client's callbacks spend queued awaiting poll, and of the
+   /// time taken to process each callback. Enabling clears any previously
+   /// recorded statistics. The default is disabled. Library wide histograms are
+   /// always recorded - see acai_statistics.h.
+   ///
+   void setLatencyStatistics (const bool enabled);
+
+   /// Returns the latency statistics status.
+   ///
+   bool latencyStatistics () const;
+
+   /// Return the client's queue latency and handler duration histograms, or NULL
+   /// if latency statistics are not enabled.
+   ///
+   const ACAI::Latency_Histogram* queueLatencyHistogram () const;
+   const ACAI::Latency_Histogram* handlerDurationHistogram () const;
+
    /// Set channel priorty. Limited to 0 .. 99, defaults to 10.
    /// The default is greater than 0 so that lesser values may be
    /// specified for large (e.g. image) array PVs.
@@ -350,6 +477,107 @@ public:
    ///
    ACAI::EventMasks eventMask () const;
 
+   // Subscription update filtering. Filters are applied as updates are buffered,
+   // i.e. before they are queued, so filtered updates cost no dispatch work.
+   // Updates whose alarm severity or status has changed are never filtered.
+   // Unlike the eventMask, changes take effect immediately.
+   //
+   /// Specifies the absolute and relative update deadbands. A scalar numeric
+   /// update is only passed on if its change from the last value passed exceeds
+   /// the absolute deadband and the relative deadband times the magnitude of the
+   /// last value passed, e.g. 0.01 for 1%. Values <= 0 disable the deadband.
+   /// Both are disabled by default. These do not apply to strings or arrays.
+   ///
+   void setUpdateDeadband (const double absolute, const double relative = 0.0);
+
+   /// Returns the current absolute update deadband.
+   ///
+   double updateAbsoluteDeadband () const;
+
+   /// Returns the current relative update deadband.
+   ///
+   double updateRelativeDeadband () const;
+
+   /// Specifies the minimum interval, in seconds, between subscription updates.
+   /// An update arriving early is held back, replacing any previously held
+   /// update, and the latest value is delivered once the interval has elapsed.
+   /// A value <= 0, the default, disables the minimum interval.
+   ///
+   void setUpdateMinimumInterval (const double interval);
+
+   /// Returns the current minimum update interval.
+   ///
+   double updateMinimumInterval () const;
+
+   /// Convenience function - equivalent to setUpdateMinimumInterval (1.0/rate).
+   /// A rate <= 0 disables the minimum interval.
+   ///
+   void setUpdateMaximumRate (const double rate);
+
+   /// Returns the number of updates filtered out for the current subscription.
+   ///
+   int filteredUpdateCount () const;
+
+   /// Determines what happens to the subscription when the channel disconnects.
+   /// When false (the default), the subscription is cleared on disconnection,
+   /// and the meta data read and subscription re-made on re-connection. When
+   /// true, the subscription is retained, and is re-established by the CA
+   /// library on re-connection, i.e. with no meta data read. This significantly
+   /// reduces the load of a reconnection storm, e.g. when an IOC hosting many
+   /// channels reboots. The meta data is still refreshed, i.e. the subscription
+   /// re-made as per the default, if the channel's host field type or element
+   /// count has changed. Any lazy meta data property subscription is likewise
+   /// retained.
+   ///
+   void setRetainSubscription (const bool retain);
+
+   /// Returns the subscription retention status.
+   ///
+   bool retainSubscription () const;
+
+   /// Returns the number of re-connections that have re-used the retained
+   /// subscription.
+   ///
+   int retainedSubscriptionCount () const;
+
+   /// Determines when the channel's meta data (precision, units, limits and
+   /// enumeration strings) is read. When false (the default), the meta data is
+   /// read, together with the initial value, using a DBR_CTRL_xxx request on
+   /// each connection, prior to subscribing. When true, the client subscribes
+   /// for DBR_TIME_xxx updates immediately, and the meta data is only requested
+   /// when first needed by a meta data function, e.g. precision or getEnumeration.
+   /// It is then obtained using a property event subscription, so that it also
+   /// remains current. Until the meta data arrives, the meta data functions
+   /// return zero/empty values. A data update notification is made when the
+   /// meta data arrives. This reduces the time to first value and the connection
+   /// bandwidth for large numbers of channels.
+   ///
+   /// Note: this is essentially only used when the channel connects or re-connects.
+   ///
+   void setLazyMetaData (const bool lazy);
+
+   /// Returns the lazy meta data status.
+   ///
+   bool lazyMetaData () const;
+
+   /// Pauses the subscription, if any, e.g. when a GUI panel is hidden. Only the
+   /// CA subscription is cleared; the channel remains connected, and the meta
+   /// data and last value received remain available. No connection callbacks
+   /// are made. A paused subscription remains paused across re-connections and
+   /// channel re-opens, although the current value is read on connection.
+   ///
+   void pauseSubscription ();
+
+   /// Resumes a paused subscription. For the Subscribe read mode, and when
+   /// connected, this re-makes the CA subscription only, i.e. there is no new
+   /// meta data read. The subscription's first update provides the current value.
+   ///
+   void resumeSubscription ();
+
+   /// Returns true if the subscription is paused.
+   ///
+   bool isSubscriptionPaused () const;
+
    /// Determines whether ca_array_put() or ca_array_put_callback() is used
    /// when writing data to a channel. The default is false i.e. no callbacks.
    ///
@@ -363,10 +591,70 @@ public:
 
    /// Indicates if the client is currently waiting for a put call back.
    /// When usePutCallback and pendingPutCallback both true, further
-   /// puts to the channel are inhibited.
+   /// puts to the channel are inhibited, unless put coalescing is enabled.
    ///
    bool isPendingPutCallback () const;
 
+   /// Determines what happens to a put requested while a put callback is pending.
+   /// When false (the default), the put is inhibited and the put function returns
+   /// false. When true, the put is held in a single, last value wins, deferred put
+   /// slot, and the put function returns true. The deferred put is issued when the
+   /// pending put callback completes, bounding the number of in-flight puts to one
+   /// while never losing the final value written. Any deferred put is discarded if
+   /// the channel disconnects or is closed.
+   ///
+   void setPutCoalescing (const bool putCoalescing);
+
+   /// Returns the current client put coalescing status.
+   ///
+   bool putCoalescing () const;
+
+   /// Indicates if the client is holding a deferred put.
+   ///
+   bool hasDeferredPut () const;
+
+   // Outbound put throttling. Both throttles are disabled by default.
+   // As the deferred puts are issued by poll, throttled puts must only be
+   // requested from the thread that calls poll.
+   //
+   /// Specifies the minimum interval, in seconds, between puts issued to the
+   /// channel. A put requested before the interval has elapsed is held in the
+   /// deferred put slot, see setPutCoalescing, and the latest such value is
+   /// issued by poll once the interval has elapsed. If a put callback is then
+   /// pending, the value remains deferred until the put callback completes,
+   /// irrespective of put coalescing. A value <= 0 disables this throttle.
+   ///
+   void setPutMinimumInterval (const double interval);
+
+   /// Returns the current minimum put interval.
+   ///
+   double putMinimumInterval () const;
+
+   /// Specifies the put deadband. This applies to scalar putFloating, putInteger
+   /// and putBoolean puts only. A put whose value differs from the value last
+   /// issued by less than the deadband is suppressed, i.e. not written, although
+   /// the put function returns true. A value <= 0 disables this throttle.
+   ///
+   void setPutDeadband (const double deadband);
+
+   /// Returns the current put deadband.
+   ///
+   double putDeadband () const;
+
+   /// Returns the number of puts suppressed by the put deadband, or superseded
+   /// by a subsequent put while deferred, since the last reset.
+   ///
+   int suppressedPutCount () const;
+
+   /// Returns the number of puts deferred by the minimum put interval since the
+   /// last reset.
+   ///
+   int deferredPutCount () const;
+
+   /// Resets the suppressed and deferred put counts.
+   ///
+   void resetPutThrottleCounts ();
+
    /// Allows the pending status to be cleared so that further put callbacks
    /// may be performed. This should be used with care as a callback from a put
    /// is associated with the last put, but may infact really be in reponse to
@@ -374,6 +662,7 @@ public:
    ///
    /// Note: if there is a pending put callback, then this clear function triggers
    /// a put callback notifications (success is false).
+   /// If there is a deferred put, this is then issued.
    ///
    /// Note: there is no automatic clear pending put call back notification timeout.
    ///
@@ -641,6 +930,27 @@ public:
    ///
    ACAI::ClientStringArray getStringArray () const;
 
+   /// Enables or disables the publication of snapshots, see getSnapshot.
+   /// Publication is disabled by default. This should be called from the thread
+   /// that calls poll, or prior to any other thread calling getSnapshot.
+   ///
+   void setSnapshotEnabled (const bool isEnabled);
+
+   /// Returns the snapshot enabled state.
+   ///
+   bool snapshotEnabled () const;
+
+   /// Provides a consistent copy of the client's cached state. Unlike the
+   /// other get functions, this function may be called from any thread while
+   /// the poll thread continues to dispatch updates. It is lock-free, but not
+   /// wait-free: it never takes a mutex, however it retries for as long as it
+   /// coincides with a publication, yielding periodically. The snapshot is
+   /// published by the poll thread on each connection and data update, prior
+   /// to calling any hook functions and callback handlers.
+   /// Returns false, leaving snapshot unchanged, if snapshots are not enabled.
+   ///
+   bool getSnapshot (ACAI::ClientSnapshot& snapshot) const;
+
    /// Write scaler value to channel.
    /// On the wire (via CA protocol) we use DBF_DOUBLE format, not the PV's native field format.
    ///
@@ -666,6 +976,17 @@ public:
    ///
    bool putString (const ACAI::ClientString& value);   // tuncated if needs be.
 
+   /// Write scaler value to channel, as above, without allocating memory once
+   /// the calling thread's put scratch buffer has grown to the required size.
+   /// The length specifies the number of characters available at value, which
+   /// need not be null terminated. If a terminating null is found within length
+   /// and the string fits, a long string is passed directly to channel access.
+   /// Conversions of more than 64 Kbytes are not retained in the scratch buffer
+   /// and allocate memory on each put. The scratch buffer is freed when the
+   /// thread exits (for threads created by epicsThreadCreate).
+   ///
+   bool putString (const char* value, const size_t length);
+
    // puts using std::vector types.
    //
    /// Write a floating vector array value to the channel.
@@ -694,10 +1015,66 @@ public:
    /// Write a traditional string array value to the channel.
    bool putStringArray   (const ACAI::ClientString*   valueArray, const unsigned int count);
 
+   /// Write a contiguous array of count fixed size strings to the channel, each
+   /// of stringSize bytes, without allocating memory once the calling thread's
+   /// put scratch buffer has grown to the required size. Each string is truncated
+   /// to ACAI::ClientMaxStringSize characters if needs be. When stringSize is
+   /// ACAI::ClientMaxStringSize + 1, and each string is null terminated, the
+   /// array is passed directly to channel access without conversion.
+   /// Scratch buffer size limit as per putString above, i.e. 1638 strings.
+   bool putStringArray   (const char* fixedStrings, const size_t stringSize,
+                          const unsigned int count);
+
    /// Write a traditional byte array value to the channel.
    /// Under the covers, this uses DBF_CHAR.
    bool putByteArray (const void* valueArray, const unsigned int count);
 
+   // Asynchronous puts. These always use ca_array_put_callback, irrespective of
+   // the usePutCallback setting, and are independent of any pending put callback,
+   // put coalescing and put throttling. Each put has its own completion token,
+   // so there is no limit on the number of outstanding puts. The returned token
+   // is never NULL, and must be deleted by the caller. If the put cannot be
+   // issued, e.g. the channel is not connected, the token's state is Failed.
+   // The timeOut is specified in seconds.
+   // Note: as with all puts, the put is actually sent on the next flush or poll.
+   //
+   /// Write scaler value to channel asynchronously, see putFloating.
+   ACAI::Client_Put_Completion* putFloatingAsync (const ACAI::ClientFloating value,
+                                                  const double timeOut = 5.0);
+
+   /// Write scaler value to channel asynchronously, see putInteger.
+   ACAI::Client_Put_Completion* putIntegerAsync (const ACAI::ClientInteger value,
+                                                 const double timeOut = 5.0);
+
+   /// Write scaler value to channel asynchronously, see putString.
+   ACAI::Client_Put_Completion* putStringAsync (const ACAI::ClientString& value,
+                                                const double timeOut = 5.0);
+
+   /// Write a floating vector array value to the channel asynchronously.
+   ACAI::Client_Put_Completion* putFloatingArrayAsync (const ACAI::ClientFloatingArray& valueArray,
+                                                       const double timeOut = 5.0);
+
+   /// Write an integer vector array value to the channel asynchronously.
+   ACAI::Client_Put_Completion* putIntegerArrayAsync (const ACAI::ClientIntegerArray& valueArray,
+                                                      const double timeOut = 5.0);
+
+   /// Read the channel asynchronously, i.e. a one-shot get, independent of any
+   /// subscription. The returned token is never NULL, must be deleted by the
+   /// caller, and on success holds its own copy of the data, see
+   /// ACAI::Client_Get_Completion. The data is requested as per the data request
+   /// field type. If elementCount is zero, the request count, if defined, else
+   /// the channel element count is used; the count is always limited to the
+   /// channel element count. Any number of gets may be issued across any number
+   /// of clients - a single flush or poll then sends them all.
+   /// The timeOut is specified in seconds.
+   ///
+   ACAI::Client_Get_Completion* getAsync (const double timeOut = 5.0,
+                                          const unsigned int elementCount = 0);
+
+   /// Returns the number of outstanding asynchronous operations.
+   ///
+   int pendingCompletionCount () const;
+
    /// Extract the channel enumeration state strings if they exist, else returns
    /// the string "#<state>", e.g. "#27".
    ///
@@ -906,41 +1283,92 @@ private:
    void callDataUpdate (const bool firstUpdate);
    void callPutCallbackNotifcation (const bool isSuccessful);
 
+   // Publishes the current state for getSnapshot, iff enabled.
+   //
+   void publishSnapshot ();
+
    // Manage Client/Abstract_Client_User associations.
    //
    void registerUser (ACAI::Abstract_Client_User* user);
    void deregisterUser (ACAI::Abstract_Client_User* user);
    void removeClientFromAllUserLists ();
 
-   bool readSubscribeChannel (const ACAI::ReadModes readMode);
+   bool readSubscribeChannel (const ACAI::ReadModes readMode,
+                              const bool initialRead = true);
    void unsubscribeChannel ();
+   void clearSubscription ();
+   void clearMetaDataSubscription ();
+   void ensureMetaData () const;
 
    // These are essentially the point of entry of the call backs.
    //
    void connectionHandler (struct connection_handler_args& args);
+   void processConnectionUp ();
+   bool deferConnectionUp ();
+   static void processDeferredConnections ();
    void updateHandler (struct event_handler_args& args);
    void eventHandler (struct event_handler_args& args);
+   void metaDataHandler (struct event_handler_args& args);
+   void accountUpdate (const struct event_handler_args& args);
 
    // Utility put data wrapper function.
    //
    bool putData (const int dbf_type, const unsigned long  count, const void* dataPtr);
 
+   // Issues the deferred put, if any. Called once a put callback completes.
+   //
+   void issueDeferredPut ();
+
+   // Adaptive request count support.
+   //
+   void startAdaptiveMonitor ();
+   void stopAdaptiveMonitor ();
+   bool resubscribeChannel ();
+   unsigned int nonAdaptiveRequestCount () const;
+   static void adaptiveLengthUpdate (ACAI::Client* companion, const bool firstUpdate);
+
+   // Registers, or clears, the update filter for the current subscription.
+   //
+   void applyUpdateFilter ();
+
+   // Asynchronous operation support.
+   //
+   ACAI::Client_Put_Completion* putDataAsync (const int dbf_type, const unsigned long count,
+                                              const void* dataPtr, const double timeOut);
+   bool completionHandler (struct event_handler_args& args);
+   void removeCompletion (void* funcArg);
+   void completeAllCompletions (const int state);
+
+   // Applies the put throttles. Returns true if the put has been suppressed or
+   // deferred, in which case status is the put function result.
+   //
+   bool throttlePut (const int dbf_type, const unsigned long count,
+                     const void* dataPtr, bool& status);
+
+   // Issues any throttle deferred puts that are now due - called by poll.
+   //
+   static void processThrottledPuts ();
+
    // Allocate a unique call back function argument. This is never NULL.
+   // This is thread safe.
    //
-   void* uniqueFunctionArg ();
+   static void* uniqueFunctionArg ();
 
    // Converts type out of event_handler_args to text - for error message.
    // This type not exposed to the api, so this function is private.
    //
    static const char* dbRequestTypeImage (const long type);
 
-   // Validates the channel id. If valid, returns referance to a ACAI::Client
-   // object otherwise returns NULL.
+   // Validates the channel handle, i.e. the channel's user data as captured
+   // when the callback was buffered, and the channel id. If valid, returns
+   // referance to a ACAI::Client object otherwise returns NULL.
    //
-   static Client* validateChannelId (const void* channel_id);
+   static Client* validateChannelId (const void* handle, const void* channel_id);
 
    friend class Abstract_Client_User;
    friend class Client_Private;
+   friend class Client_Put_Batch;
+   friend class Client_Completion;
 };
 
 }
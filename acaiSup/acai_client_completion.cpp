@@ -0,0 +1,457 @@
+/* acai_client_completion.cpp
+ *
+ * This file is part of the ACAI library.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#include <acai_client_completion.h>
+#include <acai_client.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <caerr.h>
+#include <db_access.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+
+#include <acai_private_common.h>
+
+//------------------------------------------------------------------------------
+// Returns the monotonic time in seconds.
+//
+static double monotonicTime ()
+{
+   return double (epicsMonotonicGet ()) * 1.0e-9;
+}
+
+//==============================================================================
+// Client_Completion
+//==============================================================================
+//
+ACAI::Client_Completion::Client_Completion (ACAI::Client* clientIn,
+                                            const double timeOut)
+{
+   this->owner = clientIn;
+   this->funcArg = NULL;
+   this->status = Pending;
+   this->deadline = monotonicTime () + MAX (timeOut, 0.0);
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client_Completion::~Client_Completion ()
+{
+   this->complete (Cancelled);
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client_Completion::States ACAI::Client_Completion::state ()
+{
+   if ((this->status == Pending) && (monotonicTime () >= this->deadline)) {
+      this->complete (TimedOut);
+   }
+   return this->status;
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client_Completion::isDone ()
+{
+   return this->state () != Pending;
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client_Completion::isSuccessful ()
+{
+   return this->state () == Succeeded;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client* ACAI::Client_Completion::client () const
+{
+   return this->owner;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client_Completion::cancel ()
+{
+   this->complete (Cancelled);
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client_Completion::complete (const States stateIn)
+{
+   if (this->status != Pending) return;
+
+   // Detach from the client, so that any subsequent callback is ignored.
+   //
+   if (this->funcArg && this->owner) {
+      this->owner->removeCompletion (this->funcArg);
+   }
+   this->funcArg = NULL;
+   this->status = stateIn;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client_Completion::callbackReceived (const int caStatus, const long,
+                                                const unsigned long, const void*)
+{
+   this->complete (caStatus == ECA_NORMAL ? Succeeded : Failed);
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client_Completion::wait (const double timeOut, const double pollInterval)
+{
+   const double interval = MAX (pollInterval, 0.001);
+   double total = 0.0;
+
+   bool done = this->isDone ();
+   while (!done && (total < timeOut)) {
+      epicsThreadSleep (interval);
+      total += interval;
+      ACAI::Client::poll ();
+      done = this->isDone ();
+   }
+   return this->isSuccessful ();
+}
+
+//------------------------------------------------------------------------------
+// static
+ACAI::ClientString ACAI::Client_Completion::stateImage (const States stateIn)
+{
+   ACAI::ClientString result;
+
+   switch (stateIn) {
+      case Pending:   result = "Pending";   break;
+      case Succeeded: result = "Succeeded"; break;
+      case Failed:    result = "Failed";    break;
+      case TimedOut:  result = "TimedOut";  break;
+      case Cancelled: result = "Cancelled"; break;
+      default:        result = "unknown";   break;
+   }
+   return result;
+}
+
+//------------------------------------------------------------------------------
+// static
+bool ACAI::Client_Completion::waitAll (const Lists& list, const double timeOut,
+                                       const double pollInterval)
+{
+   const double interval = MAX (pollInterval, 0.001);
+   double total = 0.0;
+   size_t next = 0;   // all items before next are known to be done
+
+   while (true) {
+      // Final states are final - no need to re-check items known to be done.
+      //
+      while ((next < list.size ()) && (!list [next] || list [next]->isDone ())) {
+         next++;
+      }
+      if ((next >= list.size ()) || (total >= timeOut)) break;
+
+      epicsThreadSleep (interval);
+      total += interval;
+      ACAI::Client::poll ();
+   }
+
+   bool result = true;
+   for (size_t j = 0; j < list.size (); j++) {
+      if (list [j] && !list [j]->isSuccessful ()) result = false;
+   }
+   return result;
+}
+
+//==============================================================================
+// Client_Put_Completion
+//==============================================================================
+//
+ACAI::Client_Put_Completion::Client_Put_Completion (ACAI::Client* clientIn,
+                                                    const double timeOut) :
+   ACAI::Client_Completion (clientIn, timeOut)
+{
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client_Put_Completion::~Client_Put_Completion () { }
+
+//==============================================================================
+// Client_Get_Completion
+//==============================================================================
+//
+ACAI::Client_Get_Completion::Client_Get_Completion (ACAI::Client* clientIn,
+                                                    const double timeOut) :
+   ACAI::Client_Completion (clientIn, timeOut)
+{
+   this->payload = NULL;
+   this->payloadType = -1;
+   this->payloadCount = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client_Get_Completion::~Client_Get_Completion ()
+{
+   if (this->payload) {
+      free (this->payload);
+      this->payload = NULL;
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client_Get_Completion::callbackReceived (const int caStatus,
+                                                    const long dbrType,
+                                                    const unsigned long count,
+                                                    const void* dbr)
+{
+   if ((caStatus != ECA_NORMAL) || !dbr ||
+       (dbrType < DBR_TIME_STRING) || (dbrType > DBR_TIME_DOUBLE)) {
+      this->complete (Failed);
+      return;
+   }
+
+   const size_t size = dbr_size_n (dbrType, count);
+   void* copy = malloc (size);
+   if (!copy) {
+      this->complete (Failed);
+      return;
+   }
+   memcpy (copy, dbr, size);
+
+   if (this->payload) free (this->payload);
+   this->payload = copy;
+   this->payloadType = dbrType;
+   this->payloadCount = count;
+   this->complete (Succeeded);
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::ClientFieldType ACAI::Client_Get_Completion::dataFieldType () const
+{
+   if (!this->payload) return ACAI::ClientFieldNO_ACCESS;
+   return ACAI::ClientFieldType (this->payloadType - DBR_TIME_STRING);
+}
+
+//------------------------------------------------------------------------------
+//
+unsigned int ACAI::Client_Get_Completion::dataElementCount () const
+{
+   return this->payload ? (unsigned int) this->payloadCount : 0;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::ClientAlarmSeverity ACAI::Client_Get_Completion::alarmSeverity () const
+{
+   if (!this->payload) return ACAI::ClientDisconnected;
+
+   // All the DBR_TIME_xxx structures have the same header layout.
+   //
+   const struct dbr_time_string* header = (const struct dbr_time_string*) this->payload;
+   return ACAI::ClientAlarmSeverity (header->severity);
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::ClientAlarmCondition ACAI::Client_Get_Completion::alarmStatus () const
+{
+   if (!this->payload) return ACAI::ClientAlarmNone;
+
+   const struct dbr_time_string* header = (const struct dbr_time_string*) this->payload;
+   return ACAI::ClientAlarmCondition (header->status);
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::ClientTimeStamp ACAI::Client_Get_Completion::timeStamp () const
+{
+   ACAI::ClientTimeStamp result;
+   result.secPastEpoch = 0;
+   result.nsec = 0;
+
+   if (this->payload) {
+      const struct dbr_time_string* header = (const struct dbr_time_string*) this->payload;
+      result.secPastEpoch = header->stamp.secPastEpoch;
+      result.nsec         = header->stamp.nsec;
+   }
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+const void* ACAI::Client_Get_Completion::rawDbr () const
+{
+   return this->payload;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::ClientFloating ACAI::Client_Get_Completion::getFloating (unsigned int index) const
+{
+   double result = 0.0;
+
+   if (!this->payload || (index >= this->payloadCount)) return result;
+
+   const void* valuePtr = dbr_value_ptr (this->payload, this->payloadType);
+
+   switch (this->payloadType) {
+      case DBR_TIME_STRING:
+         result = (ClientFloating) atof (((const dbr_string_t*) valuePtr) [index]);
+         break;
+      case DBR_TIME_SHORT:
+         result = (ClientFloating) ((const dbr_short_t*) valuePtr) [index];
+         break;
+      case DBR_TIME_FLOAT:
+         result = (ClientFloating) ((const dbr_float_t*) valuePtr) [index];
+         break;
+      case DBR_TIME_ENUM:
+         result = (ClientFloating) ((const dbr_enum_t*) valuePtr) [index];
+         break;
+      case DBR_TIME_CHAR:
+         result = (ClientFloating) ((const dbr_char_t*) valuePtr) [index];
+         break;
+      case DBR_TIME_LONG:
+         result = (ClientFloating) ((const dbr_long_t*) valuePtr) [index];
+         break;
+      case DBR_TIME_DOUBLE:
+         result = (ClientFloating) ((const dbr_double_t*) valuePtr) [index];
+         break;
+      default:
+         result = 0.0;
+         break;
+   }
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::ClientInteger ACAI::Client_Get_Completion::getInteger (unsigned int index) const
+{
+   int result = 0;
+
+   if (!this->payload || (index >= this->payloadCount)) return result;
+
+   const void* valuePtr = dbr_value_ptr (this->payload, this->payloadType);
+
+   switch (this->payloadType) {
+      case DBR_TIME_STRING:
+         result = (ClientInteger) atoi (((const dbr_string_t*) valuePtr) [index]);
+         break;
+      case DBR_TIME_SHORT:
+         result = (ClientInteger) ((const dbr_short_t*) valuePtr) [index];
+         break;
+      case DBR_TIME_FLOAT:
+         result = (ClientInteger) ((const dbr_float_t*) valuePtr) [index];
+         break;
+      case DBR_TIME_ENUM:
+         result = (ClientInteger) ((const dbr_enum_t*) valuePtr) [index];
+         break;
+      case DBR_TIME_CHAR:
+         result = (ClientInteger) ((const dbr_char_t*) valuePtr) [index];
+         break;
+      case DBR_TIME_LONG:
+         result = (ClientInteger) ((const dbr_long_t*) valuePtr) [index];
+         break;
+      case DBR_TIME_DOUBLE:
+         result = (ClientInteger) ((const dbr_double_t*) valuePtr) [index];
+         break;
+      default:
+         result = 0;
+         break;
+   }
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::ClientString ACAI::Client_Get_Completion::getString (unsigned int index) const
+{
+   ACAI::ClientString result ("");
+
+   if (!this->payload || (index >= this->payloadCount)) return result;
+
+   switch (this->payloadType) {
+      case DBR_TIME_STRING:
+         {
+            const dbr_string_t* values =
+                  (const dbr_string_t*) dbr_value_ptr (this->payload, this->payloadType);
+            result = ACAI::limitedAssign (values [index], MAX_STRING_SIZE);
+         }
+         break;
+
+      case DBR_TIME_SHORT:
+      case DBR_TIME_ENUM:
+      case DBR_TIME_CHAR:
+      case DBR_TIME_LONG:
+         result = ACAI::csnprintf (50, "%d", this->getInteger (index));
+         break;
+
+      case DBR_TIME_FLOAT:
+      case DBR_TIME_DOUBLE:
+         // No meta data available here - use the general format.
+         //
+         result = ACAI::csnprintf (50, "%.15g", this->getFloating (index));
+         break;
+
+      default:
+         break;
+   }
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::ClientFloatingArray ACAI::Client_Get_Completion::getFloatingArray () const
+{
+   const unsigned int n = this->dataElementCount ();
+   ACAI::ClientFloatingArray result;
+   result.reserve (n);
+   for (unsigned int j = 0; j < n; j++) {
+      result.push_back (this->getFloating (j));
+   }
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::ClientIntegerArray ACAI::Client_Get_Completion::getIntegerArray () const
+{
+   const unsigned int n = this->dataElementCount ();
+   ACAI::ClientIntegerArray result;
+   result.reserve (n);
+   for (unsigned int j = 0; j < n; j++) {
+      result.push_back (this->getInteger (j));
+   }
+   return result;
+}
+
+// end
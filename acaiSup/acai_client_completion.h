@@ -0,0 +1,223 @@
+/* acai_client_completion.h
+ *
+ * This file is part of the ACAI library. It provides completion tokens for
+ * asynchronous channel operations.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#ifndef ACAI_CLIENT_COMPLETION_H_
+#define ACAI_CLIENT_COMPLETION_H_
+
+#include <vector>
+#include <acai_client_types.h>
+#include <acai_shared.h>
+
+namespace ACAI {
+
+class Client;    // differed declaration.
+
+/// \brief The ACAI::Client_Completion class is the base class for the tokens
+/// returned by the ACAI::Client asynchronous functions, e.g. putFloatingAsync.
+///
+/// Each token is backed by its own channel access callback argument, so any
+/// number of asynchronous operations may be outstanding per client and across
+/// clients. A token is completed by ACAI::Client::poll, i.e. in the context
+/// of the thread that calls poll, when the associated callback is received.
+/// A token is also completed if/when the channel disconnects (Failed), if the
+/// channel is closed or the client deleted (Cancelled), or if the time out
+/// specified when the operation was issued expires (TimedOut).
+///
+/// Time outs are detected lazily: the deadline is only checked when the token's
+/// state is queried, i.e. by state, isDone, isSuccessful, wait or waitAll, and
+/// not by ACAI::Client::poll. Until then an expired token remains pending, and
+/// is still completed by a late callback. Query the state, or use wait, to
+/// apply the time out.
+///
+/// Tokens are owned by the caller, who must delete them. A token may be safely
+/// deleted at any time from the poll thread; deleting a pending token cancels it.
+///
+class ACAI_SHARED_CLASS Client_Completion {
+public:
+   /// Token states. All states other than Pending are final.
+   ///
+   enum States {
+      Pending,
+      Succeeded,
+      Failed,
+      TimedOut,
+      Cancelled
+   };
+
+   virtual ~Client_Completion ();
+
+   /// Returns the token's state. If the token's time out has expired while
+   /// pending, the token is completed with state TimedOut.
+   ///
+   States state ();
+
+   /// Returns true if the token's state is not Pending.
+   ///
+   bool isDone ();
+
+   /// Returns true if the token's state is Succeeded.
+   ///
+   bool isSuccessful ();
+
+   /// Returns the client that issued the operation. Note: this is not cleared
+   /// if/when the client is deleted.
+   ///
+   ACAI::Client* client () const;
+
+   /// Cancels the operation if pending. Any subsequent callback is ignored.
+   ///
+   void cancel ();
+
+   /// This function performs a delay poll cycle until either the token is done
+   /// or the total delay time exceeds the specified time out.
+   /// Returns true if the token's state is Succeeded.
+   /// The timeOut and pollInterval are specified in seconds.
+   /// The pollInterval is constrained to be >= 0.001s (1 mSec).
+   ///
+   bool wait (const double timeOut, const double pollInterval = 0.05);
+
+   /// Returns a textual/displayable form of the state.
+   ///
+   static ACAI::ClientString stateImage (const States state);
+
+   /// Container for waitAll.
+   ///
+   typedef std::vector<Client_Completion*> Lists;
+
+   /// As per wait, but waits until all the tokens in the list are done.
+   /// NULL list items are ignored.
+   /// Returns true if all the tokens' states are Succeeded.
+   ///
+   static bool waitAll (const Lists& list, const double timeOut,
+                        const double pollInterval = 0.05);
+
+protected:
+   explicit Client_Completion (ACAI::Client* client, const double timeOut);
+
+   // Called by ACAI::Client when the associated callback is received. The dbr
+   // parameter is a const union db_access_val* and is NULL for puts.
+   // The default implementation completes the token as Succeeded if the
+   // status is ECA_NORMAL, otherwise as Failed.
+   //
+   virtual void callbackReceived (const int caStatus, const long dbrType,
+                                  const unsigned long count, const void* dbr);
+
+   // Completes the token with the given state, and detaches the token from the
+   // client. Does nothing if the token is already complete.
+   //
+   void complete (const States state);
+
+private:
+   // Make objects of this class non-copyable.
+   //
+   Client_Completion (const Client_Completion&) {}
+   Client_Completion& operator= (const Client_Completion&) { return *this; }
+
+   ACAI::Client* owner;
+   void* funcArg;            // channel access callback argument - NULL if detached
+   States status;
+   double deadline;          // monotonic time, seconds
+
+   friend class Client;
+};
+
+/// \brief The ACAI::Client_Put_Completion class is returned by the ACAI::Client
+/// asynchronous put functions.
+///
+class ACAI_SHARED_CLASS Client_Put_Completion : public Client_Completion {
+public:
+   ~Client_Put_Completion ();
+
+private:
+   explicit Client_Put_Completion (ACAI::Client* client, const double timeOut);
+
+   friend class Client;
+};
+
+/// \brief The ACAI::Client_Get_Completion class is returned by the
+/// ACAI::Client::getAsync function.
+///
+/// On success, the token holds its own copy of the DBR_TIME_xxx payload, so
+/// its value(s) remain available after the client is deleted and are unaffected
+/// by subsequent channel updates. The payload is freed when the token is deleted.
+/// The value accessors return zero, or an empty string, if the token is not in
+/// the Succeeded state or the index is out of range.
+///
+class ACAI_SHARED_CLASS Client_Get_Completion : public Client_Completion {
+public:
+   ~Client_Get_Completion ();
+
+   /// The field type of the received data. Note: this is ClientFieldNO_ACCESS
+   /// until the token has Succeeded.
+   ///
+   ACAI::ClientFieldType dataFieldType () const;
+
+   /// The number of elements received.
+   ///
+   unsigned int dataElementCount () const;
+
+   /// Alarm severity, status and time stamp of the received data.
+   ///
+   ACAI::ClientAlarmSeverity alarmSeverity () const;
+   ACAI::ClientAlarmCondition alarmStatus () const;
+   ACAI::ClientTimeStamp timeStamp () const;
+
+   /// Extract a received value. Enumeration values are returned as the state
+   /// value - use ACAI::Client::getEnumeration for the state string.
+   ///
+   ACAI::ClientFloating getFloating (unsigned int index = 0) const;
+   ACAI::ClientInteger getInteger (unsigned int index = 0) const;
+   ACAI::ClientString getString (unsigned int index = 0) const;
+
+   /// Extract all the received values.
+   ///
+   ACAI::ClientFloatingArray getFloatingArray () const;
+   ACAI::ClientIntegerArray getIntegerArray () const;
+
+   /// Returns a pointer to the raw DBR_TIME_xxx payload, or NULL.
+   /// The dbr type is DBR_TIME_STRING + dataFieldType ().
+   ///
+   const void* rawDbr () const;
+
+protected:
+   // Copies the payload and completes the token.
+   //
+   void callbackReceived (const int caStatus, const long dbrType,
+                          const unsigned long count, const void* dbr);
+
+private:
+   explicit Client_Get_Completion (ACAI::Client* client, const double timeOut);
+
+   void* payload;            // malloc'ed copy of the DBR_TIME_xxx data, or NULL
+   long payloadType;
+   unsigned long payloadCount;
+
+   friend class Client;
+};
+
+}
+
+#endif  // ACAI_CLIENT_COMPLETION_H_
@@ -0,0 +1,234 @@
+/* acai_client_put_batch.cpp
+ *
+ * This file is part of the ACAI library.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#include <acai_client_put_batch.h>
+
+#include <db_access.h>
+#include <acai_private_common.h>
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client_Put_Batch::Client_Put_Batch ()
+{
+   this->failures = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client_Put_Batch::~Client_Put_Batch ()
+{
+   this->clear ();
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client_Put_Batch::reserve (const int number)
+{
+   if (number <= 0) return;
+   this->items.reserve (number);
+   this->floatingValues.reserve (number);
+   this->integerValues.reserve (number);
+   this->stringValues.reserve (number);
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client_Put_Batch::addItem (ACAI::Client* clientIn,
+                                     const PutKinds kind,
+                                     const unsigned int count,
+                                     const size_t offset)
+{
+   PutItems item;
+
+   item.client = clientIn;
+   item.kind = kind;
+   item.count = count;
+   item.offset = (unsigned int) offset;
+   item.result = false;
+
+   this->items.push_back (item);
+   return (int) this->items.size () - 1;
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client_Put_Batch::addFloating (ACAI::Client* clientIn,
+                                         const ACAI::ClientFloating value)
+{
+   if (!clientIn) return -1;
+
+   const size_t offset = this->floatingValues.size ();
+   this->floatingValues.push_back (value);
+   return this->addItem (clientIn, pkFloating, 1, offset);
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client_Put_Batch::addInteger (ACAI::Client* clientIn,
+                                        const ACAI::ClientInteger value)
+{
+   if (!clientIn) return -1;
+
+   const size_t offset = this->integerValues.size ();
+   this->integerValues.push_back (value);
+   return this->addItem (clientIn, pkInteger, 1, offset);
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client_Put_Batch::addBoolean (ACAI::Client* clientIn, const bool value)
+{
+   return this->addInteger (clientIn, value ? 1 : 0);
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client_Put_Batch::addString (ACAI::Client* clientIn,
+                                       const ACAI::ClientString& value)
+{
+   if (!clientIn) return -1;
+
+   // Whether the string is put as a long string depends on the channel's
+   // host field type at the time of execution, so defer the conversion.
+   //
+   const size_t offset = this->stringValues.size ();
+   this->stringValues.push_back (value);
+   return this->addItem (clientIn, pkString, 1, offset);
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client_Put_Batch::addFloatingArray (ACAI::Client* clientIn,
+                                              const ACAI::ClientFloatingArray& valueArray)
+{
+   if (!clientIn) return -1;
+
+   const size_t offset = this->floatingValues.size ();
+   this->floatingValues.insert (this->floatingValues.end (),
+                                valueArray.begin (), valueArray.end ());
+   return this->addItem (clientIn, pkFloating, (unsigned int) valueArray.size (), offset);
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client_Put_Batch::addIntegerArray (ACAI::Client* clientIn,
+                                             const ACAI::ClientIntegerArray& valueArray)
+{
+   if (!clientIn) return -1;
+
+   const size_t offset = this->integerValues.size ();
+   this->integerValues.insert (this->integerValues.end (),
+                               valueArray.begin (), valueArray.end ());
+   return this->addItem (clientIn, pkInteger, (unsigned int) valueArray.size (), offset);
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client_Put_Batch::count () const
+{
+   return (int) this->items.size ();
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Client_Put_Batch::clear ()
+{
+   // Note: clear retains the vectors' capacity.
+   //
+   this->items.clear ();
+   this->floatingValues.clear ();
+   this->integerValues.clear ();
+   this->stringValues.clear ();
+   this->failures = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client_Put_Batch::execute ()
+{
+   int successes = 0;
+
+   ACAI_ITERATE (PutItemLists, this->items, itemRef) {
+      PutItems& item = *itemRef;
+
+      // Client_Put_Batch is a friend of ACAI::Client, so the values are passed
+      // directly to putData without any further conversion.
+      //
+      switch (item.kind) {
+         case pkFloating:
+            item.result = item.client->putData
+                  (DBF_DOUBLE, item.count, &this->floatingValues [item.offset]);
+            break;
+
+         case pkInteger:
+            item.result = item.client->putData
+                  (DBF_LONG, item.count, &this->integerValues [item.offset]);
+            break;
+
+         case pkString:
+            item.result = item.client->putString (this->stringValues [item.offset]);
+            break;
+
+         default:
+            item.result = false;
+            break;
+      }
+
+      if (item.result) successes++;
+   }
+
+   this->failures = (int) this->items.size () - successes;
+
+   // One flush for the whole batch.
+   //
+   ACAI::Client::flush ();
+
+   return successes;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Client* ACAI::Client_Put_Batch::client (const int index) const
+{
+   if ((index < 0) || (index >= this->count ())) return NULL;
+   return this->items [index].client;
+}
+
+//------------------------------------------------------------------------------
+//
+bool ACAI::Client_Put_Batch::putResult (const int index) const
+{
+   if ((index < 0) || (index >= this->count ())) return false;
+   return this->items [index].result;
+}
+
+//------------------------------------------------------------------------------
+//
+int ACAI::Client_Put_Batch::failureCount () const
+{
+   return this->failures;
+}
+
+// end
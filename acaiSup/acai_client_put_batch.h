@@ -0,0 +1,167 @@
+/* acai_client_put_batch.h
+ *
+ * This file is part of the ACAI library. It provides a batched put container.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#ifndef ACAI_CLIENT_PUT_BATCH_H_
+#define ACAI_CLIENT_PUT_BATCH_H_
+
+#include <vector>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_shared.h>
+
+namespace ACAI {
+
+/// \brief The ACAI::Client_Put_Batch class collects writes to many clients and
+/// then issues them back-to-back followed by a single flush.
+///
+/// Values are held, as added, in contiguous per-type (floating, integer and
+/// string) buffers. The execute function then issues all the puts in the order
+/// added, converting each value as per the corresponding ACAI::Client put
+/// function, records the success or otherwise of each put, and calls
+/// ACAI::Client::flush once.
+///
+/// NOTE: execute does not convert the batch in a single pass. Floating and
+/// integer values are already held in the channel access DBF_DOUBLE and
+/// DBF_LONG formats and are passed to each put as is; only strings are
+/// converted, and then individually per put. The benefit of a batch over
+/// individual puts is the single flush and the re-usable value buffers.
+///
+/// A batch may be executed any number of times, e.g. once per feedback cycle,
+/// and may be re-used by calling clear. Re-use avoids re-allocation of the
+/// underlying buffers.
+///
+/// NOTE: As with ACAI::Client_Set, the class provides no mechanism to ensure
+/// that a client is removed from a batch when the client object is deleted.
+///
+class ACAI_SHARED_CLASS Client_Put_Batch {
+public:
+   /// Creates an empty put batch.
+   ///
+   explicit Client_Put_Batch ();
+
+   /// Deletes the put batch. This never deletes the referenced clients.
+   ///
+   virtual ~Client_Put_Batch ();
+
+   /// Pre-allocates space for the specified number of scalar puts, of each
+   /// kind, so that the item and value buffers are not re-allocated when a
+   /// batch of up to that many scalar puts is re-used.
+   ///
+   void reserve (const int number);
+
+   /// Adds a scalar put, as per ACAI::Client::putFloating.
+   /// Returns the index of the put within the batch, or -1 if client is NULL.
+   ///
+   int addFloating (ACAI::Client* client, const ACAI::ClientFloating value);
+
+   /// Adds a scalar put, as per ACAI::Client::putInteger.
+   /// Returns the index of the put within the batch, or -1 if client is NULL.
+   ///
+   int addInteger (ACAI::Client* client, const ACAI::ClientInteger value);
+
+   /// Adds a scalar put, as per ACAI::Client::putBoolean.
+   /// Returns the index of the put within the batch, or -1 if client is NULL.
+   ///
+   int addBoolean (ACAI::Client* client, const bool value);
+
+   /// Adds a scalar put, as per ACAI::Client::putString.
+   /// Returns the index of the put within the batch, or -1 if client is NULL.
+   ///
+   int addString (ACAI::Client* client, const ACAI::ClientString& value);
+
+   /// Adds an array put, as per ACAI::Client::putFloatingArray.
+   /// Returns the index of the put within the batch, or -1 if client is NULL.
+   ///
+   int addFloatingArray (ACAI::Client* client, const ACAI::ClientFloatingArray& valueArray);
+
+   /// Adds an array put, as per ACAI::Client::putIntegerArray.
+   /// Returns the index of the put within the batch, or -1 if client is NULL.
+   ///
+   int addIntegerArray (ACAI::Client* client, const ACAI::ClientIntegerArray& valueArray);
+
+   /// Returns the number of puts in the batch.
+   ///
+   int count () const;
+
+   /// Removes all puts from the batch.
+   ///
+   void clear ();
+
+   /// Issues all the puts in the order in which they were added, and then
+   /// flushes the Channel Access send buffer once.
+   /// Returns the number of successful puts. Individual put results are
+   /// available via the putResult function.
+   ///
+   int execute ();
+
+   /// Returns the client of the index-th put, or NULL if index out of range.
+   ///
+   ACAI::Client* client (const int index) const;
+
+   /// Returns the result of the index-th put from the most recent execute, as
+   /// per the return value of the equivilent ACAI::Client put function.
+   /// Returns false if index out of range or the batch has not been executed.
+   ///
+   bool putResult (const int index) const;
+
+   /// Returns the number of failed puts from the most recent execute.
+   ///
+   int failureCount () const;
+
+private:
+   // Make objects of this class non-copyable.
+   //
+   Client_Put_Batch (const Client_Put_Batch&) {}
+   Client_Put_Batch& operator= (const Client_Put_Batch&) { return *this; }
+
+   enum PutKinds {
+      pkFloating,
+      pkInteger,
+      pkString
+   };
+
+   struct PutItems {
+      ACAI::Client* client;
+      PutKinds kind;
+      unsigned int count;      // number of elements
+      unsigned int offset;     // into the relevant value buffer
+      bool result;
+   };
+
+   typedef std::vector<PutItems> PutItemLists;
+
+   int addItem (ACAI::Client* client, const PutKinds kind,
+                const unsigned int count, const size_t offset);
+
+   PutItemLists items;
+   ACAI::ClientFloatingArray floatingValues;
+   ACAI::ClientIntegerArray integerValues;
+   ACAI::ClientStringArray stringValues;
+   int failures;
+};
+
+}
+
+#endif  // ACAI_CLIENT_PUT_BATCH_H_
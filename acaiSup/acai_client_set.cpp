@@ -24,6 +24,7 @@
  */
 
 #include <acai_client_set.h>
+#include <algorithm>
 #include <acai_abstract_client_user.h>
 #include <acai_private_common.h>
 #include <epicsThread.h>
@@ -257,6 +258,65 @@ bool ACAI::Client_Set::waitAllChannelsReady (const double timeOut, const double
    return result;
 }
 
+//------------------------------------------------------------------------------
+// Each candidate's rank is evaluated once, as the rates depend on the time.
+//
+typedef std::pair<double, ACAI::Client*> Ranked_Clients;
+
+struct Rank_Compare {
+   bool operator () (const Ranked_Clients& a, const Ranked_Clients& b) const
+   {
+      if (a.first != b.first) return a.first > b.first;    // descending
+
+      // Ties are ordered by PV name, so that the result is deterministic.
+      //
+      return a.second->pvName () < b.second->pvName ();
+   }
+};
+
+static double clientRank (const ACAI::Client* client, const ACAI::ClientRankings ranking)
+{
+   switch (ranking) {
+      case ACAI::RankByUpdateRate:       return client->updateRate ();
+      case ACAI::RankByByteRate:         return client->byteRate ();
+      case ACAI::RankByUpdatesReceived:  return double (client->updatesReceived ());
+      case ACAI::RankByBytesReceived:    return client->bytesReceived ();
+      case ACAI::RankByMaximumBurst:     return double (client->maximumBurst ());
+   }
+   return 0.0;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::ClientLists ACAI::Client_Set::topClients (const int n,
+                                                const ACAI::ClientRankings ranking) const
+{
+   ACAI::ClientLists result;
+   if (n <= 0) return result;
+
+   std::vector<Ranked_Clients> ranked;
+   ranked.reserve (this->clientList.size ());
+
+   ACAI_ITERATE (ACAI::Client_Set::ClientSets, this->clientList, clientRef) {
+      ACAI::Client* client = *clientRef;
+      if (client) {
+         ranked.push_back (Ranked_Clients (clientRank (client, ranking), client));
+      }
+   }
+
+   // Partition about the nth item, and then sort just the top n.
+   //
+   const size_t number = MIN (size_t (n), ranked.size ());
+   std::nth_element (ranked.begin (), ranked.begin () + number, ranked.end (), Rank_Compare ());
+   std::sort (ranked.begin (), ranked.begin () + number, Rank_Compare ());
+
+   result.reserve (number);
+   for (size_t j = 0; j < number; j++) {
+      result.push_back (ranked [j].second);
+   }
+   return result;
+}
+
 //------------------------------------------------------------------------------
 //
 void ACAI::Client_Set::registerAllClients (ACAI::Abstract_Client_User* user)
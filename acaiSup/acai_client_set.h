@@ -27,6 +27,7 @@
 #define ACAI_CLIENT_SET_H_
 
 #include <set>
+#include <vector>
 #include <acai_client.h>
 #include <acai_shared.h>
 
@@ -38,6 +39,20 @@ class Abstract_Client_User;     // differed declaration
 //
 typedef void (*IteratorFunction) (ACAI::Client* client, void* context);
 
+/// topClients ranking criteria, see ACAI::Client updateRate etc.
+//
+enum ClientRankings {
+   RankByUpdateRate,       ///< updateRate
+   RankByByteRate,         ///< byteRate
+   RankByUpdatesReceived,  ///< updatesReceived
+   RankByBytesReceived,    ///< bytesReceived
+   RankByMaximumBurst      ///< maximumBurst
+};
+
+/// Client reference list.
+//
+typedef std::vector<ACAI::Client*> ClientLists;
+
 /// \brief The ACAI::Client_Set class provides a simple client reference (or pointer) container.
 ///
 /// At construction time, a container instance may be optionally configured to
@@ -165,6 +180,15 @@ public:
    ///
    bool waitAllChannelsReady (const double timeOut, const double pollInterval = 0.05);
 
+   /// Returns (up to) the top n clients in the container by the given ranking,
+   /// in descending order, e.g. to find the channels flooding the application.
+   /// Clients of equal rank are ordered by PV name. If n exceeds the number of
+   /// clients, all the clients are returned; if n <= 0, none are.
+   /// Only the selected clients are sorted, so this is O(count) for small n.
+   ///
+   ACAI::ClientLists topClients (const int n,
+                                 const ACAI::ClientRankings ranking = ACAI::RankByUpdateRate) const;
+
 private:
    // Make objects of this class non-copyable.
    //
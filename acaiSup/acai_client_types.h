@@ -190,6 +190,38 @@ enum EventMasks {
    EventProperty = (1<<3)   ///< Trigger an event when a property change (control limit, graphical limit, status string, enum string ...) occurs.
 };
 
+/// Maximum size of a Channel Access string, excluding the terminating null.
+/// MUST be kept consistent with MAX_STRING_SIZE - 1, out of db_access.h
+///
+const unsigned int ClientMaxStringSize = 39;
+
+/// Maximum size of the engineering units string, excluding the terminating null.
+/// MUST be kept consistent with MAX_UNITS_SIZE - 1, out of db_access.h
+///
+const unsigned int ClientMaxUnitsSize = 7;
+
+/// \brief A consistent copy of a client's cached state and of the value of its
+/// first element. See ACAI::Client::getSnapshot.
+///
+struct ClientSnapshot {
+   ACAI::ClientUInt32 updateCount;          ///< incremented on each publication
+   bool isConnected;                        ///< as per ACAI::Client::isConnected
+   bool dataIsAvailable;                    ///< as per ACAI::Client::dataIsAvailable
+   ACAI::ClientFieldType hostFieldType;     ///< as per ACAI::Client::hostFieldType
+   ACAI::ClientFieldType dataFieldType;     ///< as per ACAI::Client::dataFieldType
+   unsigned int dataElementCount;           ///< as per ACAI::Client::dataElementCount
+   ACAI::ClientAlarmSeverity alarmSeverity; ///< as per ACAI::Client::alarmSeverity
+   ACAI::ClientAlarmCondition alarmStatus;  ///< as per ACAI::Client::alarmStatus
+   ACAI::ClientTimeStamp timeStamp;         ///< as per ACAI::Client::timeStamp
+   ACAI::ClientFloating floatingValue;      ///< as per ACAI::Client::getFloating (0)
+   ACAI::ClientInteger integerValue;        ///< as per ACAI::Client::getInteger (0)
+   char stringValue [ClientMaxStringSize + 1];   ///< as per ACAI::Client::getString (0), truncated if needs be
+   int precision;                           ///< as per ACAI::Client::precision
+   char units [ClientMaxUnitsSize + 1];     ///< as per ACAI::Client::units
+   ACAI::ClientFloating lowerDisplayLimit;  ///< as per ACAI::Client::lowerDisplayLimit
+   ACAI::ClientFloating upperDisplayLimit;  ///< as per ACAI::Client::upperDisplayLimit
+};
+
 //------------------------------------------------------------------------------
 /// This function returns true if the specified alarm severity is one of no alarm,
 /// minor alarm or major alarm otherwise false, i.e. when invalid or disconnected.
@@ -0,0 +1,143 @@
+/* acai_handle_table.cpp
+ *
+ * This file is part of the ACAI library.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#include <acai_handle_table.h>
+
+#include <stddef.h>
+#include <vector>
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+
+// The low order bits of a handle hold the slot number plus one, so that a
+// handle is never NULL, the remaining high order bits hold the generation.
+//
+#define SLOT_BITS         20
+#define SLOT_MASK         ((size_t (1) << SLOT_BITS) - 1)
+#define MAXIMUM_SLOTS     (SLOT_MASK - 1)
+
+struct Handle_Slot {
+   ACAI::Client* client;     // NULL when slot is free
+   size_t generation;
+};
+
+typedef std::vector<Handle_Slot> Handle_Slot_Vectors;
+typedef std::vector<size_t> Free_Slot_Vectors;
+
+static Handle_Slot_Vectors slots;
+static Free_Slot_Vectors freeSlots;
+static int allocated = 0;
+static epicsMutex handleMutex;
+
+//------------------------------------------------------------------------------
+//
+static void* makeHandle (const size_t slot, const size_t generation)
+{
+   const size_t value = (generation << SLOT_BITS) | (slot + 1);
+   return (void*) value;
+}
+
+//------------------------------------------------------------------------------
+// Decodes the handle, and returns true if it references an allocated slot.
+// Caller must hold the mutex.
+//
+static bool decodeHandle (const void* handle, size_t& slot)
+{
+   const size_t value = (size_t) handle;
+   const size_t index = value & SLOT_MASK;
+
+   if (index == 0) return false;    // NULL or otherwise malformed
+   slot = index - 1;
+   if (slot >= slots.size ()) return false;
+
+   // Generation comparison is modulo available generation bits.
+   //
+   const size_t generation = value >> SLOT_BITS;
+   const Handle_Slot& item = slots [slot];
+   return (item.client != NULL) &&
+          (((item.generation << SLOT_BITS) >> SLOT_BITS) == generation);
+}
+
+//------------------------------------------------------------------------------
+// static
+void* ACAI::Handle_Table::allocate (ACAI::Client* client)
+{
+   if (!client) return NULL;
+
+   epicsGuard<epicsMutex> guard (handleMutex);
+
+   size_t slot;
+   if (!freeSlots.empty ()) {
+      slot = freeSlots.back ();
+      freeSlots.pop_back ();
+   } else {
+      if (slots.size () >= MAXIMUM_SLOTS) return NULL;
+      Handle_Slot item;
+      item.client = NULL;
+      item.generation = 0;
+      slots.push_back (item);
+      slot = slots.size () - 1;
+   }
+
+   slots [slot].client = client;
+   allocated++;
+   return makeHandle (slot, slots [slot].generation);
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Handle_Table::release (const void* handle)
+{
+   epicsGuard<epicsMutex> guard (handleMutex);
+
+   size_t slot;
+   if (!decodeHandle (handle, slot)) return;
+
+   slots [slot].client = NULL;
+   slots [slot].generation++;
+   freeSlots.push_back (slot);
+   allocated--;
+}
+
+//------------------------------------------------------------------------------
+// static
+ACAI::Client* ACAI::Handle_Table::lookup (const void* handle)
+{
+   epicsGuard<epicsMutex> guard (handleMutex);
+
+   size_t slot;
+   if (!decodeHandle (handle, slot)) return NULL;
+   return slots [slot].client;
+}
+
+//------------------------------------------------------------------------------
+// static
+int ACAI::Handle_Table::allocatedCount ()
+{
+   epicsGuard<epicsMutex> guard (handleMutex);
+   return allocated;
+}
+
+// end
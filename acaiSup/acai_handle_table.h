@@ -0,0 +1,70 @@
+/* acai_handle_table.h
+ *
+ * This file is part of the ACAI library. It provides the generational handle
+ * table used to associate channel access user data with ACAI::Client objects.
+ * This is private to the library and is not installed.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#ifndef ACAI_HANDLE_TABLE_H_
+#define ACAI_HANDLE_TABLE_H_
+
+namespace ACAI {
+
+class Client;
+
+// A handle comprises a slot index and a generation number packed into a
+// pointer sized value. It is passed to channel access as the channel's user
+// data in lieu of the client object address. When a handle is released, the
+// slot's generation number is incremented, so that any stale handle, e.g.
+// one captured by a callback queued prior to the client being deleted, no
+// longer matches and may be rejected without dereferencing the client.
+//
+// A handle is never NULL. All functions are thread safe.
+//
+class Handle_Table {
+public:
+   // Allocates a handle that references the given client.
+   //
+   static void* allocate (Client* client);
+
+   // Releases the handle. The handle and any copies of it become stale.
+   // Does nothing if handle is NULL or already stale.
+   //
+   static void release (const void* handle);
+
+   // Returns the client referenced by the handle, or NULL if the handle is
+   // NULL, stale or otherwise invalid. This is O(1).
+   //
+   static Client* lookup (const void* handle);
+
+   // Returns the number of currently allocated handles - diagnostic.
+   //
+   static int allocatedCount ();
+
+private:
+   Handle_Table () {}   // static only - no instances
+};
+
+}
+
+#endif   // ACAI_HANDLE_TABLE_H_
@@ -0,0 +1,193 @@
+/* acai_meta_data.cpp
+ *
+ * This file is part of the ACAI library.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#include <acai_meta_data.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <set>
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+
+#include <acai_private_common.h>
+
+// The null meta data block. Being static, this is zeroised.
+//
+static ACAI::Meta_Data nullMetaDataBlock;
+
+// Orders meta data blocks by hash and then by content.
+// Blocks of different sizes necessarily have different num_states values,
+// and hence differ within the common compared prefix.
+//
+struct Meta_Data_Compare {
+   bool operator () (const ACAI::Meta_Data* a, const ACAI::Meta_Data* b) const
+   {
+      if (a->hash != b->hash) return a->hash < b->hash;
+      const size_t size = MIN (a->contentSize (), b->contentSize ());
+      return memcmp (&a->precision, &b->precision, size) < 0;
+   }
+};
+
+// The intern table.
+//
+typedef std::set<ACAI::Meta_Data*, Meta_Data_Compare> Meta_Data_Sets;
+static Meta_Data_Sets internTable;
+static int internReferences = 0;
+static epicsMutex internMutex;
+
+//------------------------------------------------------------------------------
+// static
+size_t ACAI::Meta_Data::allocationSize (const unsigned short num_states)
+{
+   // Always allow for at least one state - the struct itself declares one.
+   //
+   const size_t n = MAX (num_states, 1);
+   return offsetof (ACAI::Meta_Data, enum_strings) + (n * MAX_ENUM_STRING_SIZE);
+}
+
+//------------------------------------------------------------------------------
+// static
+ACAI::Meta_Data* ACAI::Meta_Data::create (const unsigned short num_states)
+{
+   const size_t size = ACAI::Meta_Data::allocationSize (num_states);
+
+   // calloc zeroises the allocated memory.
+   //
+   ACAI::Meta_Data* result = (ACAI::Meta_Data*) calloc (1, size);
+   if (result) {
+      result->num_states = num_states;
+   }
+   return result;
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Meta_Data::destroy (ACAI::Meta_Data* meta)
+{
+   if (meta && (meta != &nullMetaDataBlock)) {
+      free ((void*) meta);
+   }
+}
+
+//------------------------------------------------------------------------------
+// static
+const ACAI::Meta_Data* ACAI::Meta_Data::nullMetaData ()
+{
+   return &nullMetaDataBlock;
+}
+
+//------------------------------------------------------------------------------
+//
+size_t ACAI::Meta_Data::contentSize () const
+{
+   return ACAI::Meta_Data::allocationSize (this->num_states) -
+          offsetof (ACAI::Meta_Data, precision);
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Meta_Data::normalise ()
+{
+   size_t len;
+
+   len = strnlen (this->units, sizeof (this->units));
+   memset (this->units + len, 0, sizeof (this->units) - len);
+
+   for (unsigned short j = 0; j < this->num_states; j++) {
+      char* text = this->enum_strings [j];
+      len = strnlen (text, MAX_ENUM_STRING_SIZE);
+      memset (text + len, 0, MAX_ENUM_STRING_SIZE - len);
+   }
+}
+
+//------------------------------------------------------------------------------
+// static
+const ACAI::Meta_Data* ACAI::Meta_Data::intern (ACAI::Meta_Data* candidate)
+{
+   if (!candidate) return &nullMetaDataBlock;
+   if (candidate == &nullMetaDataBlock) return &nullMetaDataBlock;
+
+   // Calculate FNV-1a hash of the normalised content.
+   //
+   candidate->normalise ();
+
+   const unsigned char* content = (const unsigned char*) &candidate->precision;
+   const size_t size = candidate->contentSize ();
+   size_t hash = 2166136261u;
+   for (size_t j = 0; j < size; j++) {
+      hash = (hash ^ content [j]) * 16777619u;
+   }
+   candidate->hash = hash;
+
+   ACAI::Meta_Data* result;
+
+   epicsGuard<epicsMutex> guard (internMutex);
+
+   Meta_Data_Sets::iterator it = internTable.find (candidate);
+   if (it != internTable.end ()) {
+      // We already have one of these - share it.
+      //
+      result = *it;
+      ACAI::Meta_Data::destroy (candidate);
+   } else {
+      result = candidate;
+      result->reference_count = 0;
+      internTable.insert (result);
+   }
+
+   result->reference_count++;
+   internReferences++;
+   return result;
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Meta_Data::release (const ACAI::Meta_Data* meta)
+{
+   if (!meta || (meta == &nullMetaDataBlock)) return;
+
+   ACAI::Meta_Data* block = (ACAI::Meta_Data*) meta;
+
+   epicsGuard<epicsMutex> guard (internMutex);
+
+   internReferences--;
+   block->reference_count--;
+   if (block->reference_count <= 0) {
+      internTable.erase (block);
+      ACAI::Meta_Data::destroy (block);
+   }
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Meta_Data::internStatistics (int& blocks, int& references)
+{
+   epicsGuard<epicsMutex> guard (internMutex);
+   blocks = (int) internTable.size ();
+   references = internReferences;
+}
+
+// end
@@ -0,0 +1,124 @@
+/* acai_meta_data.h
+ *
+ * This file is part of the ACAI library. It provides the channel meta data
+ * block referenced by, as opposed to embedded within, each client's private
+ * data. This is private to the library and is not installed.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#ifndef ACAI_META_DATA_H_
+#define ACAI_META_DATA_H_
+
+#include <stddef.h>
+#include <db_access.h>
+
+namespace ACAI {
+
+// Meta data (apart from time stamp, returned on first update).
+// Essentially as out of dbr_ctrl_double, dbr_ctrl_enum etc.
+// Use double as this caters for all types (float, long, short etc.)
+//
+// The vast majority of channels are not enumerations, so the enumeration
+// strings array is sized at allocation time to the actual number of states.
+// Hence objects of this type must be created and destroyed using the create
+// and destroy functions, and must never be copied by value.
+//
+// Many channels, e.g. those from the same record template, have identical
+// meta data. Blocks are therefore interned: identical blocks are stored once
+// and shared by reference count between all the clients that use them.
+// An interned block must be treated as read only.
+//
+struct Meta_Data {
+   // Allocates a zeroised meta data block large enough to hold num_states
+   // enumeration strings. Returns NULL if the allocation fails.
+   //
+   static Meta_Data* create (const unsigned short num_states);
+
+   // Frees a meta data block allocated by create. Does nothing if meta is NULL
+   // or is the null meta data block.
+   //
+   static void destroy (Meta_Data* meta);
+
+   // Returns a reference to a shared, all zero, meta data block. This is used
+   // when no meta data is available and is never destroyed.
+   //
+   static const Meta_Data* nullMetaData ();
+
+   // Returns the number of bytes allocated for a block with num_states states.
+   //
+   static size_t allocationSize (const unsigned short num_states);
+
+   // Takes ownership of the candidate block, which must have been allocated by
+   // create, and returns a reference to the interned block with identical
+   // content. If such a block already exists, the candidate is destroyed.
+   // If candidate is NULL, returns the null meta data block.
+   // Thread safe.
+   //
+   static const Meta_Data* intern (Meta_Data* candidate);
+
+   // Releases a reference to a block returned by intern. The block is destroyed
+   // when the last reference is released. Does nothing for the null block.
+   // Thread safe.
+   //
+   static void release (const Meta_Data* meta);
+
+   // Returns the number of distinct interned blocks and the total number of
+   // references to those blocks - diagnostic.
+   //
+   static void internStatistics (int& blocks, int& references);
+
+   // Interning information - not part of the content.
+   //
+   size_t hash;
+   int reference_count;
+
+   // Content - must start with precision - see contentSize.
+   //
+   int precision;               // number of decimal places
+   char units[MAX_UNITS_SIZE];  // units of value
+   double upper_disp_limit;     // upper limit of graph
+   double lower_disp_limit;     // lower limit of graph
+   double upper_alarm_limit;
+   double upper_warning_limit;
+   double lower_warning_limit;
+   double lower_alarm_limit;
+   double upper_ctrl_limit;     // upper control limit
+   double lower_ctrl_limit;     // lower control limit
+   unsigned short num_states;   // number of strings (was no_str)
+
+   // Actually num_states elements - this must be the last member.
+   //
+   char enum_strings[1][MAX_ENUM_STRING_SIZE];    // was strs
+
+   // Clears any characters beyond the terminating null of units and each enum
+   // string, so that blocks with equivalent content compare identical.
+   //
+   void normalise ();
+
+   // Content size, i.e. excluding the interning information, in bytes.
+   //
+   size_t contentSize () const;
+};
+
+}
+
+#endif   // ACAI_META_DATA_H_
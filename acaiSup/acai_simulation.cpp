@@ -0,0 +1,965 @@
+/* acai_simulation.cpp
+ *
+ * This file is part of the ACAI library.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#include <acai_simulation.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <alarm.h>
+#include <cadef.h>
+#include <caerr.h>
+#include <db_access.h>
+#include <epicsEvent.h>
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+
+#include <acai_backend.h>
+#include <acai_private_common.h>
+
+// Simulated channel, PV and subscription data. A simulated channel's address
+// is used as the channel id, and a simulated subscription's address is used
+// as the event id.
+//
+struct Simulated_PV;
+struct Simulated_Channel;
+
+struct Simulated_Subscription {
+   Simulated_Channel* channel;
+   chtype type;
+   unsigned long count;
+   long mask;
+   caEventCallBackFunc* handler;
+   void* arg;
+};
+
+typedef std::set<Simulated_Subscription*> Simulated_Subscription_Sets;
+
+struct Simulated_Channel {
+   ACAI::ClientString pvName;
+   Simulated_PV* pv;                     // NULL when PV undefined
+   caCh* connectionHandler;
+   void* puser;
+   bool isConnected;
+   bool everConnected;
+   Simulated_Subscription_Sets subscriptions;
+};
+
+typedef std::set<Simulated_Channel*> Simulated_Channel_Sets;
+
+struct Simulated_PV {
+   ACAI::ClientFieldType fieldType;
+   unsigned int elementCount;
+   double updateRate;
+   double accumulated;                   // fractional updates carried over
+   bool isConnected;
+   double disconnectPeriod;              // disconnect cycle, 0.0 => none
+   double disconnectDuration;
+   double cyclePhase;                    // simulated time within the cycle
+   short severity;                       // alarm state
+   short status;
+   unsigned long sequence;               // the update number, n
+   std::vector<double> values;
+   ACAI::ClientString text;              // STRING PVs only
+   Simulated_Channel_Sets channels;
+};
+
+typedef std::map<ACAI::ClientString, Simulated_PV*> Simulated_PV_Maps;
+
+static const char* enumStates [] = { "Zero", "One", "Two", "Three" };
+static const int numberEnumStates = ARRAY_LENGTH (enumStates);
+
+// All simulation data is protected by the one mutex. Callbacks into the
+// buffered callback handlers are made while holding the mutex - these only
+// queue the data and never call back into the backend.
+//
+static epicsMutex simulationMutex;
+static Simulated_PV_Maps pvMap;
+static Simulated_Channel_Sets unresolvedChannels;
+static size_t postedCount = 0;
+static size_t metaDataCount = 0;
+
+static epicsEventId stopEvent = NULL;
+static epicsEventId doneEvent = NULL;
+static double threadPeriod = 0.01;
+
+//------------------------------------------------------------------------------
+// Sets the PV's value for update number n.
+//
+static void generateValue (Simulated_PV* pv)
+{
+   pv->sequence++;
+
+   const double n = double (pv->sequence);
+   for (unsigned int k = 0; k < pv->elementCount; k++) {
+      double v = n + k;
+      switch (pv->fieldType) {
+         case ACAI::ClientFieldFLOAT:
+         case ACAI::ClientFieldDOUBLE:
+            v += 0.25;
+            break;
+         case ACAI::ClientFieldCHAR:
+            v = fmod (v, 256.0);
+            break;
+         case ACAI::ClientFieldENUM:
+            v = fmod (v, double (numberEnumStates));
+            break;
+         default:
+            break;
+      }
+      pv->values [k] = v;
+   }
+
+   if (pv->fieldType == ACAI::ClientFieldSTRING) {
+      pv->text = ACAI::csnprintf (40, "sim %lu", pv->sequence);
+   }
+}
+
+//------------------------------------------------------------------------------
+// Sets the DBR meta data for the control types. The graphic types are left
+// zeroed as ACAI::Client does not request them.
+//
+#define SET_LIMITS(p) {                         \
+   (p)->upper_disp_limit = 100;                 \
+   (p)->lower_disp_limit = 0;                   \
+   (p)->upper_ctrl_limit = 100;                 \
+   (p)->lower_ctrl_limit = 0;                   \
+   strncpy ((p)->units, "sim", MAX_UNITS_SIZE); \
+}
+
+static void setMetaData (char* dbr, const chtype type, const Simulated_PV* pv)
+{
+   // All DBR_STS_xxx and later structures have the same alarm header layout.
+   //
+   if (type >= DBR_STS_STRING) {
+      ((struct dbr_sts_string*) dbr)->status = pv->status;
+      ((struct dbr_sts_string*) dbr)->severity = pv->severity;
+   }
+
+   if (type >= DBR_TIME_STRING && type <= DBR_TIME_DOUBLE) {
+      epicsTimeGetCurrent (&((struct dbr_time_string*) dbr)->stamp);
+   }
+
+   switch (type) {
+      case DBR_CTRL_SHORT:
+         SET_LIMITS ((struct dbr_ctrl_short*) dbr);
+         break;
+      case DBR_CTRL_FLOAT:
+         SET_LIMITS ((struct dbr_ctrl_float*) dbr);
+         ((struct dbr_ctrl_float*) dbr)->precision = 3;
+         break;
+      case DBR_CTRL_ENUM:
+         {
+            struct dbr_ctrl_enum* p = (struct dbr_ctrl_enum*) dbr;
+            p->no_str = numberEnumStates;
+            for (int j = 0; j < numberEnumStates; j++) {
+               strncpy (p->strs [j], enumStates [j], MAX_ENUM_STRING_SIZE - 1);
+            }
+         }
+         break;
+      case DBR_CTRL_CHAR:
+         SET_LIMITS ((struct dbr_ctrl_char*) dbr);
+         break;
+      case DBR_CTRL_LONG:
+         SET_LIMITS ((struct dbr_ctrl_long*) dbr);
+         break;
+      case DBR_CTRL_DOUBLE:
+         SET_LIMITS ((struct dbr_ctrl_double*) dbr);
+         ((struct dbr_ctrl_double*) dbr)->precision = 3;
+         break;
+      default:
+         break;
+   }
+}
+
+#undef SET_LIMITS
+
+//------------------------------------------------------------------------------
+// Allocates and populates a DBR of the requested type. A zero or oversize
+// count is taken as the PV's element count. The caller must free the DBR.
+//
+static char* createDbr (const Simulated_PV* pv, const chtype type,
+                        unsigned long& count)
+{
+   if (!dbr_type_is_valid (type) || type > DBR_CTRL_DOUBLE) return NULL;
+
+   if (count == 0 || count > pv->elementCount) count = pv->elementCount;
+
+   char* dbr = (char*) calloc (1, dbr_size_n (type, count));
+   if (!dbr) return NULL;
+
+   setMetaData (dbr, type, pv);
+
+   void* value = dbr_value_ptr (dbr, type);
+   const int baseType = int (type % (LAST_TYPE + 1));
+
+   for (unsigned long k = 0; k < count; k++) {
+      const double v = pv->values [k];
+      switch (baseType) {
+         case DBR_STRING:
+            {
+               char* target = (char*) value + k * MAX_STRING_SIZE;
+               if (pv->fieldType == ACAI::ClientFieldSTRING) {
+                  snprintf (target, MAX_STRING_SIZE, "%s", pv->text.c_str ());
+               } else if (pv->fieldType == ACAI::ClientFieldENUM) {
+                  snprintf (target, MAX_STRING_SIZE, "%s", enumStates [int (v) % numberEnumStates]);
+               } else {
+                  snprintf (target, MAX_STRING_SIZE, "%g", v);
+               }
+            }
+            break;
+         case DBR_SHORT:
+            ((dbr_short_t*) value) [k] = dbr_short_t (v);
+            break;
+         case DBR_FLOAT:
+            ((dbr_float_t*) value) [k] = dbr_float_t (v);
+            break;
+         case DBR_ENUM:
+            ((dbr_enum_t*) value) [k] = dbr_enum_t (v);
+            break;
+         case DBR_CHAR:
+            ((dbr_char_t*) value) [k] = dbr_char_t (v);
+            break;
+         case DBR_LONG:
+            ((dbr_long_t*) value) [k] = dbr_long_t (v);
+            break;
+         case DBR_DOUBLE:
+            ((dbr_double_t*) value) [k] = dbr_double_t (v);
+            break;
+      }
+   }
+   return dbr;
+}
+
+//------------------------------------------------------------------------------
+// Delivers a get, put or subscription callback.
+//
+static void deliver (Simulated_Channel* channel, const chtype type,
+                     const unsigned long count, caEventCallBackFunc* handler,
+                     void* arg)
+{
+   unsigned long actual = count;
+   char* dbr = createDbr (channel->pv, type, actual);
+
+   struct event_handler_args args;
+   args.usr = arg;
+   args.chid = (chid) channel;
+   args.type = type;
+   args.count = long (actual);
+   args.dbr = dbr;
+   args.status = dbr ? ECA_NORMAL : ECA_BADTYPE;
+
+   handler (args);
+   free (dbr);
+}
+
+//------------------------------------------------------------------------------
+//
+static void postSubscription (Simulated_Subscription* subscription)
+{
+   deliver (subscription->channel, subscription->type, subscription->count,
+            subscription->handler, subscription->arg);
+   postedCount++;
+}
+
+//------------------------------------------------------------------------------
+// Posts the PV's current value to all subscriptions with a matching mask.
+//
+static void postValue (Simulated_PV* pv, const long mask)
+{
+   ACAI_ITERATE (Simulated_Channel_Sets, pv->channels, channel) {
+      if (!(*channel)->isConnected) continue;
+      ACAI_ITERATE (Simulated_Subscription_Sets, (*channel)->subscriptions, sub) {
+         if ((*sub)->mask & mask) postSubscription (*sub);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// Sets the channel's connection state and calls the connection handler.
+// On (re-)connection, each subscription receives an update.
+//
+static void setChannelConnected (Simulated_Channel* channel, const bool isConnected)
+{
+   if (channel->isConnected == isConnected) return;
+
+   channel->isConnected = isConnected;
+   if (isConnected) channel->everConnected = true;
+
+   struct connection_handler_args args;
+   args.chid = (chid) channel;
+   args.op = isConnected ? CA_OP_CONN_UP : CA_OP_CONN_DOWN;
+   channel->connectionHandler (args);
+
+   if (isConnected) {
+      ACAI_ITERATE (Simulated_Subscription_Sets, channel->subscriptions, sub) {
+         postSubscription (*sub);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// Sets the PV's connection state, and that of all its channels.
+//
+static void setPvConnected (Simulated_PV* pv, const bool isConnected)
+{
+   pv->isConnected = isConnected;
+   pv->accumulated = 0.0;
+   ACAI_ITERATE (Simulated_Channel_Sets, pv->channels, channel) {
+      setChannelConnected (*channel, isConnected);
+   }
+}
+
+//------------------------------------------------------------------------------
+// Generates the updates due for the PV over the interval, if connected.
+// Returns the number of updates generated.
+//
+static int generateUpdates (Simulated_PV* pv, const double interval)
+{
+   if (!pv->isConnected || pv->updateRate <= 0.0) return 0;
+
+   pv->accumulated += interval * pv->updateRate;
+   const int number = int (pv->accumulated);
+   pv->accumulated -= number;
+
+   for (int j = 0; j < number; j++) {
+      generateValue (pv);
+      postValue (pv, DBE_VALUE | DBE_LOG);
+   }
+   return number;
+}
+
+//------------------------------------------------------------------------------
+// Advances the PV by the interval. With a disconnect cycle, the interval is
+// split at each cycle boundary, so that the connection state changes at the
+// correct simulated time irrespective of the interval, and no updates are
+// generated while disconnected.
+//
+static int advancePv (Simulated_PV* pv, double interval)
+{
+   if (pv->disconnectPeriod <= 0.0) return generateUpdates (pv, interval);
+
+   const double upTime = pv->disconnectPeriod - pv->disconnectDuration;
+   int result = 0;
+   for (;;) {
+      const bool connectedPhase = (pv->cyclePhase < upTime);
+      if (pv->isConnected != connectedPhase) setPvConnected (pv, connectedPhase);
+      if (interval <= 0.0) break;
+
+      const double boundary = connectedPhase ? upTime : pv->disconnectPeriod;
+      const double remaining = boundary - pv->cyclePhase;
+      if (interval < remaining) {
+         result += generateUpdates (pv, interval);
+         pv->cyclePhase += interval;
+         break;
+      }
+
+      result += generateUpdates (pv, remaining);
+      interval -= remaining;
+      pv->cyclePhase = (boundary < pv->disconnectPeriod) ? boundary : 0.0;
+   }
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+static Simulated_PV* findPv (const ACAI::ClientString& pvName)
+{
+   Simulated_PV_Maps::iterator it = pvMap.find (pvName);
+   return (it != pvMap.end ()) ? it->second : NULL;
+}
+
+
+//==============================================================================
+// Simulated backend functions.
+//==============================================================================
+//
+static int simCreateChannel (const char* pvName, caCh* connectionHandler,
+                             void* puser, capri, chid* pChannelId)
+{
+   if (!pvName || !connectionHandler || !pChannelId) return ECA_BADCHID;
+
+   epicsGuard<epicsMutex> guard (simulationMutex);
+
+   Simulated_Channel* channel = new Simulated_Channel ();
+   channel->pvName = pvName;
+   channel->pv = findPv (channel->pvName);
+   channel->connectionHandler = connectionHandler;
+   channel->puser = puser;
+   channel->isConnected = false;
+   channel->everConnected = false;
+
+   *pChannelId = (chid) channel;
+
+   if (channel->pv) {
+      channel->pv->channels.insert (channel);
+      if (channel->pv->isConnected) setChannelConnected (channel, true);
+   } else {
+      unresolvedChannels.insert (channel);
+   }
+   return ECA_NORMAL;
+}
+
+//------------------------------------------------------------------------------
+//
+static int simClearChannel (chid channelId)
+{
+   Simulated_Channel* channel = (Simulated_Channel*) channelId;
+   if (!channel) return ECA_BADCHID;
+
+   epicsGuard<epicsMutex> guard (simulationMutex);
+
+   if (channel->pv) {
+      channel->pv->channels.erase (channel);
+   } else {
+      unresolvedChannels.erase (channel);
+   }
+
+   ACAI_ITERATE (Simulated_Subscription_Sets, channel->subscriptions, sub) {
+      delete *sub;
+   }
+   delete channel;
+   return ECA_NORMAL;
+}
+
+//------------------------------------------------------------------------------
+//
+static short simFieldType (chid channelId)
+{
+   Simulated_Channel* channel = (Simulated_Channel*) channelId;
+   epicsGuard<epicsMutex> guard (simulationMutex);
+   return (channel && channel->isConnected) ? short (channel->pv->fieldType) : TYPENOTCONN;
+}
+
+//------------------------------------------------------------------------------
+//
+static unsigned long simElementCount (chid channelId)
+{
+   Simulated_Channel* channel = (Simulated_Channel*) channelId;
+   epicsGuard<epicsMutex> guard (simulationMutex);
+   return (channel && channel->isConnected) ? channel->pv->elementCount : 0;
+}
+
+//------------------------------------------------------------------------------
+//
+static enum channel_state simState (chid channelId)
+{
+   Simulated_Channel* channel = (Simulated_Channel*) channelId;
+   epicsGuard<epicsMutex> guard (simulationMutex);
+   if (!channel) return cs_closed;
+   if (channel->isConnected) return cs_conn;
+   return channel->everConnected ? cs_prev_conn : cs_never_conn;
+}
+
+//------------------------------------------------------------------------------
+//
+static unsigned simAccess (chid channelId)
+{
+   Simulated_Channel* channel = (Simulated_Channel*) channelId;
+   epicsGuard<epicsMutex> guard (simulationMutex);
+   return (channel && channel->isConnected) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+//
+static void simGetHostName (chid, char* buffer, unsigned length)
+{
+   if (buffer && length > 0) snprintf (buffer, length, "%s", "simulation");
+}
+
+//------------------------------------------------------------------------------
+// Called by the buffered callback handlers, possibly with the mutex held, and
+// the user data is fixed for the channel's lifetime, so no locking here.
+//
+static void* simPuser (chid channelId)
+{
+   Simulated_Channel* channel = (Simulated_Channel*) channelId;
+   return channel ? channel->puser : NULL;
+}
+
+//------------------------------------------------------------------------------
+//
+static int simArrayGetCallback (chtype type, unsigned long count, chid channelId,
+                                caEventCallBackFunc* handler, void* arg)
+{
+   Simulated_Channel* channel = (Simulated_Channel*) channelId;
+   if (!channel || !handler) return ECA_BADCHID;
+
+   epicsGuard<epicsMutex> guard (simulationMutex);
+   if (!channel->isConnected) return ECA_DISCONN;
+   if (!dbr_type_is_valid (type)) return ECA_BADTYPE;
+
+   if (dbr_type_is_CTRL (type)) metaDataCount++;
+   deliver (channel, type, count, handler, arg);
+   return ECA_NORMAL;
+}
+
+//------------------------------------------------------------------------------
+//
+static int simCreateSubscription (chtype type, unsigned long count, chid channelId,
+                                  long mask, caEventCallBackFunc* handler, void* arg,
+                                  evid* pEventId)
+{
+   Simulated_Channel* channel = (Simulated_Channel*) channelId;
+   if (!channel || !handler) return ECA_BADCHID;
+   if (!dbr_type_is_valid (type)) return ECA_BADTYPE;
+
+   epicsGuard<epicsMutex> guard (simulationMutex);
+
+   if (dbr_type_is_CTRL (type)) metaDataCount++;
+
+   Simulated_Subscription* subscription = new Simulated_Subscription ();
+   subscription->channel = channel;
+   subscription->type = type;
+   subscription->count = count;
+   subscription->mask = mask;
+   subscription->handler = handler;
+   subscription->arg = arg;
+
+   channel->subscriptions.insert (subscription);
+   if (pEventId) *pEventId = (evid) subscription;
+
+   // As per channel access, a new subscription receives an initial update.
+   //
+   if (channel->isConnected) postSubscription (subscription);
+   return ECA_NORMAL;
+}
+
+//------------------------------------------------------------------------------
+//
+static int simClearSubscription (evid eventId)
+{
+   Simulated_Subscription* subscription = (Simulated_Subscription*) eventId;
+   if (!subscription) return ECA_BADCHID;
+
+   epicsGuard<epicsMutex> guard (simulationMutex);
+   subscription->channel->subscriptions.erase (subscription);
+   delete subscription;
+   return ECA_NORMAL;
+}
+
+//------------------------------------------------------------------------------
+// Decodes the put value into the PV and posts it to all subscriptions.
+//
+static int putValue (Simulated_Channel* channel, const chtype type,
+                     const unsigned long count, const void* pValue)
+{
+   if (!channel->isConnected) return ECA_DISCONN;
+   if (type > DBR_DOUBLE) return ECA_BADTYPE;
+   if (!pValue || count == 0) return ECA_BADCOUNT;
+
+   Simulated_PV* pv = channel->pv;
+   const unsigned long number = MIN (count, (unsigned long) pv->elementCount);
+
+   for (unsigned long k = 0; k < number; k++) {
+      double v = 0.0;
+      switch (type) {
+         case DBR_STRING:
+            {
+               char text [MAX_STRING_SIZE + 1];
+               snprintf (text, sizeof (text), "%.*s", MAX_STRING_SIZE,
+                         (const char*) pValue + k * MAX_STRING_SIZE);
+               if (pv->fieldType == ACAI::ClientFieldSTRING && k == 0) {
+                  pv->text = text;
+               }
+               v = atof (text);
+               for (int j = 0; j < numberEnumStates; j++) {
+                  if (strcmp (text, enumStates [j]) == 0) v = j;
+               }
+            }
+            break;
+         case DBR_SHORT:
+            v = ((const dbr_short_t*) pValue) [k];
+            break;
+         case DBR_FLOAT:
+            v = ((const dbr_float_t*) pValue) [k];
+            break;
+         case DBR_ENUM:
+            v = ((const dbr_enum_t*) pValue) [k];
+            break;
+         case DBR_CHAR:
+            v = ((const dbr_char_t*) pValue) [k];
+            break;
+         case DBR_LONG:
+            v = ((const dbr_long_t*) pValue) [k];
+            break;
+         case DBR_DOUBLE:
+            v = ((const dbr_double_t*) pValue) [k];
+            break;
+      }
+      pv->values [k] = v;
+   }
+
+   if (pv->fieldType == ACAI::ClientFieldSTRING && type != DBR_STRING) {
+      pv->text = ACAI::csnprintf (40, "%g", pv->values [0]);
+   }
+
+   postValue (pv, DBE_VALUE | DBE_LOG);
+   return ECA_NORMAL;
+}
+
+//------------------------------------------------------------------------------
+//
+static int simArrayPut (chtype type, unsigned long count, chid channelId,
+                        const void* pValue)
+{
+   Simulated_Channel* channel = (Simulated_Channel*) channelId;
+   if (!channel) return ECA_BADCHID;
+
+   epicsGuard<epicsMutex> guard (simulationMutex);
+   return putValue (channel, type, count, pValue);
+}
+
+//------------------------------------------------------------------------------
+//
+static int simArrayPutCallback (chtype type, unsigned long count, chid channelId,
+                                const void* pValue, caEventCallBackFunc* handler,
+                                void* arg)
+{
+   Simulated_Channel* channel = (Simulated_Channel*) channelId;
+   if (!channel || !handler) return ECA_BADCHID;
+
+   epicsGuard<epicsMutex> guard (simulationMutex);
+   const int status = putValue (channel, type, count, pValue);
+   if (status != ECA_NORMAL) return status;
+
+   // Put completion - as per channel access, there is no data.
+   //
+   struct event_handler_args args;
+   args.usr = arg;
+   args.chid = channelId;
+   args.type = type;
+   args.count = long (count);
+   args.dbr = NULL;
+   args.status = ECA_NORMAL;
+   handler (args);
+   return ECA_NORMAL;
+}
+
+//------------------------------------------------------------------------------
+//
+static int simFlushIo ()
+{
+   return ECA_NORMAL;   // nothing to flush
+}
+
+static const ACAI::Backend simulatedBackend = {
+   "simulation",
+   simCreateChannel,
+   simClearChannel,
+   simFieldType,
+   simElementCount,
+   simState,
+   simAccess,
+   simAccess,
+   simGetHostName,
+   simPuser,
+   simArrayGetCallback,
+   simCreateSubscription,
+   simClearSubscription,
+   simArrayPut,
+   simArrayPutCallback,
+   simFlushIo
+};
+
+
+//==============================================================================
+// Simulation
+//==============================================================================
+//
+// static
+bool ACAI::Simulation::enable ()
+{
+   return ACAI::selectBackend (&simulatedBackend);
+}
+
+//------------------------------------------------------------------------------
+// static
+bool ACAI::Simulation::disable ()
+{
+   ACAI::Simulation::stopThread ();
+   return ACAI::selectBackend (NULL);
+}
+
+//------------------------------------------------------------------------------
+// static
+bool ACAI::Simulation::isEnabled ()
+{
+   return ACAI::currentBackend () == &simulatedBackend;
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Simulation::definePv (const ACAI::ClientString& pvName,
+                                 const ACAI::ClientFieldType fieldType,
+                                 const unsigned int elementCount,
+                                 const double updateRate)
+{
+   epicsGuard<epicsMutex> guard (simulationMutex);
+
+   Simulated_PV* pv = findPv (pvName);
+   if (pv) {
+      // Re-definition - as per an IOC reboot with a modified database.
+      //
+      ACAI_ITERATE (Simulated_Channel_Sets, pv->channels, channel) {
+         setChannelConnected (*channel, false);
+      }
+   } else {
+      pv = new Simulated_PV ();
+      pv->sequence = 0;
+      pvMap [pvName] = pv;
+
+      // Resolve any channels waiting on this PV.
+      //
+      Simulated_Channel_Sets waiting;
+      ACAI_ITERATE (Simulated_Channel_Sets, unresolvedChannels, channel) {
+         if ((*channel)->pvName == pvName) waiting.insert (*channel);
+      }
+      ACAI_ITERATE (Simulated_Channel_Sets, waiting, channel) {
+         unresolvedChannels.erase (*channel);
+         (*channel)->pv = pv;
+         pv->channels.insert (*channel);
+      }
+   }
+
+   pv->fieldType = LIMIT (fieldType, ACAI::ClientFieldSTRING, ACAI::ClientFieldDOUBLE);
+   pv->elementCount = MAX (elementCount, 1);
+   pv->updateRate = MAX (updateRate, 0.0);
+   pv->accumulated = 0.0;
+   pv->isConnected = true;
+   pv->disconnectPeriod = 0.0;
+   pv->disconnectDuration = 0.0;
+   pv->cyclePhase = 0.0;
+   pv->severity = 0;
+   pv->status = 0;
+   pv->values.assign (pv->elementCount, 0.0);
+   generateValue (pv);
+
+   ACAI_ITERATE (Simulated_Channel_Sets, pv->channels, channel) {
+      setChannelConnected (*channel, true);
+   }
+}
+
+//------------------------------------------------------------------------------
+// static
+bool ACAI::Simulation::setUpdateRate (const ACAI::ClientString& pvName,
+                                      const double updateRate)
+{
+   epicsGuard<epicsMutex> guard (simulationMutex);
+
+   Simulated_PV* pv = findPv (pvName);
+   if (!pv) return false;
+
+   pv->updateRate = MAX (updateRate, 0.0);
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// static
+bool ACAI::Simulation::setConnected (const ACAI::ClientString& pvName,
+                                     const bool isConnected)
+{
+   epicsGuard<epicsMutex> guard (simulationMutex);
+
+   Simulated_PV* pv = findPv (pvName);
+   if (!pv) return false;
+
+   setPvConnected (pv, isConnected);
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// static
+bool ACAI::Simulation::setDisconnectCycle (const ACAI::ClientString& pvName,
+                                           const double period,
+                                           const double duration)
+{
+   epicsGuard<epicsMutex> guard (simulationMutex);
+
+   Simulated_PV* pv = findPv (pvName);
+   if (!pv) return false;
+
+   if ((period > 0.0) && (duration > 0.0)) {
+      pv->disconnectPeriod = period;
+      pv->disconnectDuration = MIN (duration, period);
+   } else {
+      pv->disconnectPeriod = 0.0;
+      pv->disconnectDuration = 0.0;
+   }
+   pv->cyclePhase = 0.0;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// static
+bool ACAI::Simulation::setAlarm (const ACAI::ClientString& pvName,
+                                 const ACAI::ClientAlarmSeverity severity,
+                                 const ACAI::ClientAlarmCondition status)
+{
+   epicsGuard<epicsMutex> guard (simulationMutex);
+
+   Simulated_PV* pv = findPv (pvName);
+   if (!pv || !pv->isConnected) return false;
+
+   pv->severity = short (severity);
+   pv->status = short (status);
+   postValue (pv, DBE_ALARM);
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// static
+bool ACAI::Simulation::postUpdate (const ACAI::ClientString& pvName)
+{
+   epicsGuard<epicsMutex> guard (simulationMutex);
+
+   Simulated_PV* pv = findPv (pvName);
+   if (!pv || !pv->isConnected) return false;
+
+   generateValue (pv);
+   postValue (pv, DBE_VALUE | DBE_LOG);
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Simulation::removeAllPvs ()
+{
+   epicsGuard<epicsMutex> guard (simulationMutex);
+
+   ACAI_ITERATE (Simulated_PV_Maps, pvMap, it) {
+      Simulated_PV* pv = it->second;
+      ACAI_ITERATE (Simulated_Channel_Sets, pv->channels, channel) {
+         setChannelConnected (*channel, false);
+         (*channel)->pv = NULL;
+         unresolvedChannels.insert (*channel);
+      }
+      delete pv;
+   }
+   pvMap.clear ();
+}
+
+//------------------------------------------------------------------------------
+// static
+int ACAI::Simulation::advance (const double interval)
+{
+   if (interval <= 0.0) return 0;
+
+   epicsGuard<epicsMutex> guard (simulationMutex);
+
+   int result = 0;
+   ACAI_ITERATE (Simulated_PV_Maps, pvMap, it) {
+      result += advancePv (it->second, interval);
+   }
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+static void simulationThread (void*)
+{
+   epicsUInt64 last = epicsMonotonicGet ();
+   while (epicsEventWaitWithTimeout (stopEvent, threadPeriod) == epicsEventWaitTimeout) {
+      const epicsUInt64 now = epicsMonotonicGet ();
+      ACAI::Simulation::advance (double (now - last) * 1.0e-9);
+      last = now;
+   }
+   epicsEventSignal (doneEvent);
+}
+
+//------------------------------------------------------------------------------
+// static
+bool ACAI::Simulation::startThread (const double period)
+{
+   epicsGuard<epicsMutex> guard (simulationMutex);
+
+   if (stopEvent) return false;   // already running
+
+   threadPeriod = MAX (period, 0.001);
+   stopEvent = epicsEventCreate (epicsEventEmpty);
+   doneEvent = epicsEventCreate (epicsEventEmpty);
+
+   epicsThreadId id = epicsThreadCreate ("acai_simulation", epicsThreadPriorityMedium,
+                                         epicsThreadGetStackSize (epicsThreadStackMedium),
+                                         simulationThread, NULL);
+   if (!id) {
+      epicsEventDestroy (stopEvent);
+      epicsEventDestroy (doneEvent);
+      stopEvent = NULL;
+      doneEvent = NULL;
+      return false;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Simulation::stopThread ()
+{
+   epicsEventId stop;
+   epicsEventId done;
+   {
+      epicsGuard<epicsMutex> guard (simulationMutex);
+      stop = stopEvent;
+      done = doneEvent;
+   }
+   if (!stop) return;   // not running
+
+   // Must not hold the mutex here as the thread may be within advance.
+   //
+   epicsEventSignal (stop);
+   epicsEventWait (done);
+
+   epicsGuard<epicsMutex> guard (simulationMutex);
+   epicsEventDestroy (stopEvent);
+   epicsEventDestroy (doneEvent);
+   stopEvent = NULL;
+   doneEvent = NULL;
+}
+
+//------------------------------------------------------------------------------
+// static
+size_t ACAI::Simulation::updatesPosted ()
+{
+   epicsGuard<epicsMutex> guard (simulationMutex);
+   return postedCount;
+}
+
+//------------------------------------------------------------------------------
+// static
+size_t ACAI::Simulation::metaDataRequests ()
+{
+   epicsGuard<epicsMutex> guard (simulationMutex);
+   return metaDataCount;
+}
+
+// end
@@ -0,0 +1,158 @@
+/* acai_simulation.h
+ *
+ * This file is part of the ACAI library. It provides an in-process
+ * simulated channel access backend for deterministic tests and benchmarks.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#ifndef ACAI_SIMULATION_H_
+#define ACAI_SIMULATION_H_
+
+#include <stddef.h>
+#include <acai_client_types.h>
+#include <acai_shared.h>
+
+namespace ACAI {
+
+/// \brief The ACAI::Simulation class provides an in-process simulated channel
+/// access backend.
+///
+/// When enabled, all ACAI::Client objects use simulated PVs instead of channel
+/// access, so that the library's own throughput and latency may be measured,
+/// and its behaviour tested, deterministically and without an IOC or network.
+/// All other ACAI functionality, i.e. callback buffering, poll, update
+/// handlers, etc., is unchanged.
+///
+/// Simulated PVs are defined by name, field type, element count and update
+/// rate. A channel for an undefined PV remains unconnected until the PV is
+/// defined. Gets, puts and put callbacks complete immediately, i.e. are
+/// available at the next poll. A put sets the PV's value, which is posted to
+/// all subscriptions. Otherwise, each update increments the PV's update
+/// number, n, and element k of the value is n + k, plus 0.25 for FLOAT and
+/// DOUBLE PVs, modulo 256 for CHAR PVs, and modulo 4 for ENUM PVs, whose
+/// states are "Zero" .. "Three". The value of a STRING PV is "sim n".
+/// Time stamps use the current time.
+///
+/// Updates are generated either explicitly by calling advance, which is fully
+/// deterministic, or by a simulation thread, which calls advance periodically
+/// with the actual elapsed time, and mimics the channel access callback thread.
+///
+/// All functions are static and thread safe.
+///
+class ACAI_SHARED_CLASS Simulation {
+public:
+   /// Selects the simulated backend. This must be done while no channels are
+   /// open, and returns false otherwise.
+   ///
+   static bool enable ();
+
+   /// Restores the channel access backend, subject to the same restriction.
+   /// Stops any simulation thread. PV definitions are retained.
+   ///
+   static bool disable ();
+
+   /// Returns true if the simulated backend is in use.
+   ///
+   static bool isEnabled ();
+
+   /// Defines, or re-defines, a simulated PV. The element count is constrained
+   /// to >= 1, and the update rate, in updates per second, to >= 0.0. The PV is
+   /// initially connected, with no disconnect cycle.
+   ///
+   static void definePv (const ACAI::ClientString& pvName,
+                         const ACAI::ClientFieldType fieldType,
+                         const unsigned int elementCount = 1,
+                         const double updateRate = 0.0);
+
+   /// Sets a simulated PV's update rate. Returns false if the PV is undefined.
+   ///
+   static bool setUpdateRate (const ACAI::ClientString& pvName, const double updateRate);
+
+   /// Connects or disconnects a simulated PV, e.g. to simulate an IOC reboot.
+   /// As per channel access, subscriptions persist while disconnected and each
+   /// receives an update on re-connection. Returns false if the PV is undefined.
+   ///
+   static bool setConnected (const ACAI::ClientString& pvName, const bool isConnected);
+
+   /// Sets a simulated PV's disconnect cycle, e.g. to simulate an unreliable
+   /// network or IOC. Every period seconds of simulated time, the PV is
+   /// disconnected for the last duration seconds of the cycle, and no updates
+   /// are generated while disconnected. The cycle starts, connected, at the
+   /// next call to advance, and the connection state is then controlled by the
+   /// cycle, overriding setConnected. The duration is constrained to <= period.
+   /// A period or duration <= 0.0 cancels the cycle, leaving the PV in its
+   /// current connection state. Returns false if the PV is undefined.
+   ///
+   static bool setDisconnectCycle (const ACAI::ClientString& pvName,
+                                   const double period, const double duration);
+
+   /// Sets a simulated PV's alarm severity and status, which are initially
+   /// none, and posts an alarm update with the current value. Returns false if
+   /// the PV is undefined or disconnected.
+   ///
+   static bool setAlarm (const ACAI::ClientString& pvName,
+                         const ACAI::ClientAlarmSeverity severity,
+                         const ACAI::ClientAlarmCondition status);
+
+   /// Generates a single update for the PV now, irrespective of the update rate.
+   /// Returns false if the PV is undefined or disconnected.
+   ///
+   static bool postUpdate (const ACAI::ClientString& pvName);
+
+   /// Removes all simulated PVs. Any channels are disconnected.
+   ///
+   static void removeAllPvs ();
+
+   /// Advances simulated time by the given interval, in seconds, generating the
+   /// updates due for each PV according to its update rate, and applying any
+   /// disconnect cycle. Fractional updates are carried over to the next call.
+   /// Returns the number of updates generated, i.e. the number of PV value
+   /// changes.
+   ///
+   static int advance (const double interval);
+
+   /// Starts a thread that calls advance every period seconds, with the actual
+   /// elapsed time. Returns false if a thread is already running.
+   ///
+   static bool startThread (const double period = 0.01);
+
+   /// Stops the simulation thread, if any, and waits for it to finish.
+   ///
+   static void stopThread ();
+
+   /// Returns the total number of subscription updates posted, i.e. callbacks,
+   /// summed over all subscriptions.
+   ///
+   static size_t updatesPosted ();
+
+   /// Returns the total number of meta data requests, i.e. DBR_CTRL_xxx get
+   /// and subscription requests, summed over all channels.
+   ///
+   static size_t metaDataRequests ();
+
+private:
+   Simulation () {}   // static only - no instances
+};
+
+}
+
+#endif  // ACAI_SIMULATION_H_
@@ -0,0 +1,288 @@
+/* acai_statistics.cpp
+ *
+ * This file is part of the ACAI library.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#include <acai_statistics.h>
+
+#include <math.h>
+#include <stdio.h>
+
+#include <epicsAtomic.h>
+
+#include <acai_private_common.h>
+
+static ACAI::Latency_Histogram queueLatency;
+static ACAI::Latency_Histogram handlerDuration;
+
+//------------------------------------------------------------------------------
+//
+ACAI::Latency_Histogram::Latency_Histogram ()
+{
+   this->reset ();
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Latency_Histogram::~Latency_Histogram () { }
+
+//------------------------------------------------------------------------------
+// static
+int ACAI::Latency_Histogram::bucketIndex (const size_t nanoSeconds)
+{
+   if (nanoSeconds < SubBuckets) return int (nanoSeconds);
+
+   // Find the magnitude such that SubBuckets <= value < 2*SubBuckets.
+   //
+   size_t value = nanoSeconds;
+   int magnitude = 0;
+   while (value >= 2 * SubBuckets) {
+      value >>= 1;
+      magnitude++;
+   }
+
+   const int index = (magnitude + 1) * SubBuckets + int (value - SubBuckets);
+   return MIN (index, NumberOfBuckets - 1);
+}
+
+//------------------------------------------------------------------------------
+// static
+double ACAI::Latency_Histogram::bucketValue (const int index)
+{
+   if (index < SubBuckets) return double (index);
+
+   // Return the bucket's mid point.
+   //
+   const int magnitude = (index / SubBuckets) - 1;
+   const int sub = index % SubBuckets;
+   const double lower = ldexp (double (SubBuckets + sub), magnitude);
+   const double width = ldexp (1.0, magnitude);
+   return lower + 0.5 * width;
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Latency_Histogram::record (const double seconds)
+{
+   // Constrain to what a size_t can safely hold - about 2.1 seconds for 32 bit
+   // targets. Note: on such targets the sum, and hence the mean, is only
+   // meaningful for modest counts.
+   //
+   static const double limit = double (size_t (-1) / 2);
+
+   double ns = seconds * 1.0e9;
+   ns = LIMIT (ns, 0.0, limit);
+   const size_t nanoSeconds = size_t (ns);
+
+   epicsAtomicIncrSizeT (&this->counts [bucketIndex (nanoSeconds)]);
+   epicsAtomicIncrSizeT (&this->total);
+   epicsAtomicAddSizeT (&this->sum, nanoSeconds);
+}
+
+//------------------------------------------------------------------------------
+//
+void ACAI::Latency_Histogram::reset ()
+{
+   for (int j = 0; j < NumberOfBuckets; j++) {
+      epicsAtomicSetSizeT (&this->counts [j], 0);
+   }
+   epicsAtomicSetSizeT (&this->total, 0);
+   epicsAtomicSetSizeT (&this->sum, 0);
+}
+
+//------------------------------------------------------------------------------
+//
+size_t ACAI::Latency_Histogram::count () const
+{
+   return epicsAtomicGetSizeT (&this->total);
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Latency_Histogram::mean () const
+{
+   const size_t n = this->count ();
+   if (n == 0) return 0.0;
+   return double (epicsAtomicGetSizeT (&this->sum)) * 1.0e-9 / double (n);
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Latency_Histogram::percentile (const double percent) const
+{
+   // Use the sum of the counts as opposed to total, which may be inconsistent
+   // if recording is concurrent.
+   //
+   size_t n = 0;
+   for (int j = 0; j < NumberOfBuckets; j++) {
+      n += epicsAtomicGetSizeT (&this->counts [j]);
+   }
+   if (n == 0) return 0.0;
+
+   const double p = LIMIT (percent, 0.0, 100.0);
+   size_t target = size_t (ceil (p * double (n) / 100.0));
+   target = LIMIT (target, size_t (1), n);
+
+   size_t cumulative = 0;
+   for (int j = 0; j < NumberOfBuckets; j++) {
+      cumulative += epicsAtomicGetSizeT (&this->counts [j]);
+      if (cumulative >= target) {
+         return bucketValue (j) * 1.0e-9;
+      }
+   }
+   return bucketValue (NumberOfBuckets - 1) * 1.0e-9;
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Latency_Histogram::maximum () const
+{
+   for (int j = NumberOfBuckets - 1; j >= 0; j--) {
+      if (epicsAtomicGetSizeT (&this->counts [j]) > 0) {
+         return bucketValue (j) * 1.0e-9;
+      }
+   }
+   return 0.0;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::ClientString ACAI::Latency_Histogram::summaryImage () const
+{
+   return ACAI::csnprintf (200,
+                           "count=%lu mean=%.1fus p50=%.1fus p99=%.1fus p99.9=%.1fus max=%.1fus",
+                           (unsigned long) this->count (),
+                           this->mean () * 1.0e6,
+                           this->percentile (50.0) * 1.0e6,
+                           this->percentile (99.0) * 1.0e6,
+                           this->percentile (99.9) * 1.0e6,
+                           this->maximum () * 1.0e6);
+}
+
+//==============================================================================
+// Client_Statistics
+//==============================================================================
+//
+ACAI::Client_Statistics::Client_Statistics ()
+{
+   this->queueLength = 0;
+   this->queueHighWaterMark = 0;
+   this->heldCount = 0;
+   this->enqueueCount = 0;
+   this->dequeueCount = 0;
+   this->connectionCallbackCount = 0;
+   this->eventCallbackCount = 0;
+   this->printfCallbackCount = 0;
+   this->bytesBuffered = 0;
+   this->totalBytesBuffered = 0;
+   this->coalescedCount = 0;
+   this->filteredCount = 0;
+   this->allocationFailures = 0;
+   this->connectionUpCount = 0;
+   this->connectionDownCount = 0;
+   this->openChannels = 0;
+   this->pendingConnections = 0;
+   this->pollCount = 0;
+   this->lastPollDuration = 0.0;
+   this->maximumPollDuration = 0.0;
+   this->totalPollDuration = 0.0;
+   this->metaDataBlocks = 0;
+   this->metaDataReferences = 0;
+   this->elapsedTime = 0.0;
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Client_Statistics::enqueueRate () const
+{
+   return this->elapsedTime > 0.0 ? double (this->enqueueCount) / this->elapsedTime : 0.0;
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Client_Statistics::dequeueRate () const
+{
+   return this->elapsedTime > 0.0 ? double (this->dequeueCount) / this->elapsedTime : 0.0;
+}
+
+//------------------------------------------------------------------------------
+//
+double ACAI::Client_Statistics::meanPollDuration () const
+{
+   return this->pollCount > 0 ? this->totalPollDuration / double (this->pollCount) : 0.0;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::ClientString ACAI::Client_Statistics::image () const
+{
+   ACAI::ClientString result;
+
+   result  = ACAI::csnprintf (120, "elapsed time:  %.3f s\n", this->elapsedTime);
+   result += ACAI::csnprintf (120, "queue:         length %lu, high water mark %lu, held %lu\n",
+                              (unsigned long) this->queueLength,
+                              (unsigned long) this->queueHighWaterMark,
+                              (unsigned long) this->heldCount);
+   result += ACAI::csnprintf (120, "enqueued:      %lu (%.1f/s), dequeued %lu (%.1f/s)\n",
+                              (unsigned long) this->enqueueCount, this->enqueueRate (),
+                              (unsigned long) this->dequeueCount, this->dequeueRate ());
+   result += ACAI::csnprintf (120, "callbacks:     connection %lu, event %lu, printf %lu\n",
+                              (unsigned long) this->connectionCallbackCount,
+                              (unsigned long) this->eventCallbackCount,
+                              (unsigned long) this->printfCallbackCount);
+   result += ACAI::csnprintf (120, "bytes:         buffered %lu, total %lu\n",
+                              (unsigned long) this->bytesBuffered,
+                              (unsigned long) this->totalBytesBuffered);
+   result += ACAI::csnprintf (120, "dropped:       coalesced %lu, filtered %lu, allocation failures %lu\n",
+                              (unsigned long) this->coalescedCount,
+                              (unsigned long) this->filteredCount,
+                              (unsigned long) this->allocationFailures);
+   result += ACAI::csnprintf (120, "connections:   up %lu, down %lu, open %d, pending %d\n",
+                              (unsigned long) this->connectionUpCount,
+                              (unsigned long) this->connectionDownCount,
+                              this->openChannels, this->pendingConnections);
+   result += ACAI::csnprintf (120, "polls:         %lu, last %.1f us, mean %.1f us, max %.1f us\n",
+                              (unsigned long) this->pollCount,
+                              this->lastPollDuration * 1.0e6,
+                              this->meanPollDuration () * 1.0e6,
+                              this->maximumPollDuration * 1.0e6);
+   result += ACAI::csnprintf (120, "meta data:     blocks %d, references %d\n",
+                              this->metaDataBlocks, this->metaDataReferences);
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Latency_Histogram& ACAI::globalQueueLatencyHistogram ()
+{
+   return queueLatency;
+}
+
+//------------------------------------------------------------------------------
+//
+ACAI::Latency_Histogram& ACAI::globalHandlerDurationHistogram ()
+{
+   return handlerDuration;
+}
+
+// end
@@ -0,0 +1,171 @@
+/* acai_statistics.h
+ *
+ * This file is part of the ACAI library. It provides run time statistics,
+ * specifically latency histograms and operational statistics.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#ifndef ACAI_STATISTICS_H_
+#define ACAI_STATISTICS_H_
+
+#include <stddef.h>
+#include <acai_client_types.h>
+#include <acai_shared.h>
+
+namespace ACAI {
+
+/// \brief The ACAI::Latency_Histogram class records a distribution of time
+/// intervals, e.g. how long updates wait in the callback queue.
+///
+/// The histogram is HDR style: buckets are linear (1 nS wide) below 8 nS, and
+/// thereafter there are eight linear sub buckets per power of two, so that
+/// any recorded value is resolved to within about 6%. Values of 15 x 2^39 nS
+/// (about 2.3 hours) and above are recorded in the top bucket.
+///
+/// Recording is lock free and thread safe, and costs a few atomic increments.
+/// The readout functions are not synchronised with recording, i.e. values
+/// recorded concurrently with a readout may or may not be included.
+///
+class ACAI_SHARED_CLASS Latency_Histogram {
+public:
+   explicit Latency_Histogram ();
+   ~Latency_Histogram ();
+
+   /// Records an interval specified in seconds. Negative intervals are recorded
+   /// as zero.
+   ///
+   void record (const double seconds);
+
+   /// Clears all recorded intervals.
+   ///
+   void reset ();
+
+   /// Returns the number of intervals recorded since the last reset.
+   ///
+   size_t count () const;
+
+   /// Returns the mean interval in seconds, or 0.0 if no intervals recorded.
+   ///
+   double mean () const;
+
+   /// Returns the interval, in seconds, at or below which the specified
+   /// percentage, e.g. 99.0, of recorded intervals lie, to within the bucket
+   /// resolution. Returns 0.0 if no intervals recorded.
+   ///
+   double percentile (const double percent) const;
+
+   /// Returns the (approximate) maximum interval recorded, in seconds.
+   ///
+   double maximum () const;
+
+   /// Returns a one line summary: count, mean, 50%, 99%, 99.9% and maximum,
+   /// with times in micro seconds.
+   ///
+   ACAI::ClientString summaryImage () const;
+
+private:
+   enum Sizes {
+      SubBuckets = 8,
+      Magnitudes = 40,
+      NumberOfBuckets = SubBuckets * (Magnitudes + 1)
+   };
+
+   static int bucketIndex (const size_t nanoSeconds);
+   static double bucketValue (const int index);   // nano seconds
+
+   size_t counts [NumberOfBuckets];
+   size_t total;
+   size_t sum;     // nano seconds
+};
+
+/// \brief The ACAI::Client_Statistics struct is a snapshot of the library's
+/// operational statistics - see ACAI::Client::getStatistics.
+///
+/// Counts are cumulative since ACAI::Client::initialise or the last call to
+/// ACAI::Client::resetStatistics. Durations are in seconds.
+///
+struct ACAI_SHARED_CLASS Client_Statistics {
+   explicit Client_Statistics ();
+
+   // Callback queue.
+   //
+   size_t queueLength;              ///< current number of queued callbacks
+   size_t queueHighWaterMark;       ///< maximum queue length
+   size_t heldCount;                ///< updates held back by update filters
+   size_t enqueueCount;             ///< callbacks queued, of all kinds
+   size_t dequeueCount;             ///< callbacks dispatched
+   size_t connectionCallbackCount;  ///< connection callbacks queued
+   size_t eventCallbackCount;       ///< event callbacks queued
+   size_t printfCallbackCount;      ///< printf callbacks queued
+   size_t bytesBuffered;            ///< current size of queued data
+   size_t totalBytesBuffered;       ///< cumulative size of queued data
+   size_t coalescedCount;           ///< updates superseded by a later update
+   size_t filteredCount;            ///< updates removed by update filters
+   size_t allocationFailures;       ///< callbacks lost due to allocation failure
+
+   // Connections.
+   //
+   size_t connectionUpCount;        ///< connection up callbacks
+   size_t connectionDownCount;      ///< connection down callbacks
+   int openChannels;                ///< currently open channels
+   int pendingConnections;          ///< see ACAI::Client::setConnectionBudget
+
+   // Dispatch, i.e. per ACAI::Client::poll.
+   //
+   size_t pollCount;
+   double lastPollDuration;
+   double maximumPollDuration;
+   double totalPollDuration;
+
+   // Interned meta data.
+   //
+   int metaDataBlocks;
+   int metaDataReferences;
+
+   double elapsedTime;              ///< seconds covered by the statistics
+
+   /// Derived statistics - these return 0.0 when undefined.
+   ///
+   double enqueueRate () const;     ///< callbacks/second
+   double dequeueRate () const;     ///< callbacks/second
+   double meanPollDuration () const;
+
+   /// Returns a multi-line, human readable, image of the statistics.
+   ///
+   ACAI::ClientString image () const;
+};
+
+// Library wide histograms. These cover all clients, and are always recorded.
+//
+/// Returns the histogram of times between a callback being buffered by the
+/// channel access thread and its dispatch by ACAI::Client::poll.
+///
+ACAI_SHARED_FUNC ACAI::Latency_Histogram& globalQueueLatencyHistogram ();
+
+/// Returns the histogram of the time taken to process each dispatched callback,
+/// including all user handlers and notifications.
+///
+ACAI_SHARED_FUNC ACAI::Latency_Histogram& globalHandlerDurationHistogram ();
+
+}
+
+#endif  // ACAI_STATISTICS_H_
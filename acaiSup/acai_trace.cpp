@@ -0,0 +1,362 @@
+/* acai_trace.cpp
+ *
+ * This file is part of the ACAI library.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#include <acai_trace.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <epicsAtomic.h>
+#include <epicsExit.h>
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+
+#include <acai_private_common.h>
+
+// Recorded event.
+//
+struct Trace_Event {
+   epicsUInt64 start;
+   epicsUInt64 finish;
+   const void* id;
+   size_t size;
+   ACAI::TraceKinds kind;
+};
+
+// Per thread ring buffer. Only the owning thread writes to the ring. The number
+// of events written is published after the event itself, so that a reader never
+// sees an event before it is complete (unless subsequently overwritten).
+//
+// When the owning thread exits, the ring is retained, together with its events,
+// but becomes available for re-use by a new thread. Rings are thus never freed,
+// but their number is bounded by the peak number of concurrent tracing threads.
+//
+struct Trace_Ring {
+   int threadIndex;
+   char threadName [40];
+   size_t capacity;
+   size_t written;            // total events written
+   Trace_Event* events;
+   bool inUse;                // protected by ringsMutex
+};
+
+typedef std::vector<Trace_Ring*> Trace_Ring_Lists;
+
+static int enabled = 0;
+static int defaultCapacity = 16384;
+static Trace_Ring_Lists rings;          // rings are never freed, but are re-used
+static int numberOfThreads = 0;         // allocates the thread indices
+static epicsMutex ringsMutex;           // protects the rings list and inUse
+static epicsThreadOnceId onceId = EPICS_THREAD_ONCE_INIT;
+static epicsThreadPrivateId ringKey = NULL;
+
+static const char* kindImages [ACAI::NUMBER_OF_TRACE_KINDS] = {
+   "connection up",
+   "connection down",
+   "queued",
+   "dispatch",
+   "put",
+   "put callback"
+};
+
+//------------------------------------------------------------------------------
+//
+static void createRingKey (void*)
+{
+   ringKey = epicsThreadPrivateCreate ();
+}
+
+//------------------------------------------------------------------------------
+// Called on thread exit - makes the thread's ring available for re-use.
+//
+static void releaseRing (void* arg)
+{
+   Trace_Ring* ring = (Trace_Ring*) arg;
+   epicsThreadPrivateSet (ringKey, NULL);
+
+   epicsGuard<epicsMutex> guard (ringsMutex);
+   ring->inUse = false;
+}
+
+//------------------------------------------------------------------------------
+// Returns the calling thread's ring, re-using or creating one if needs be.
+//
+static Trace_Ring* threadRing ()
+{
+   epicsThreadOnce (&onceId, createRingKey, NULL);
+
+   Trace_Ring* ring = (Trace_Ring*) epicsThreadPrivateGet (ringKey);
+   if (ring) return ring;
+
+   const size_t capacity = size_t (epicsAtomicGetIntT (&defaultCapacity));
+
+   {
+      epicsGuard<epicsMutex> guard (ringsMutex);
+
+      // Re-use the ring of an exited thread, if one of the required capacity
+      // is available. Its events are discarded.
+      //
+      ACAI_ITERATE (Trace_Ring_Lists, rings, ringRef) {
+         Trace_Ring* candidate = *ringRef;
+         if (!candidate->inUse && (candidate->capacity == capacity)) {
+            ring = candidate;
+            break;
+         }
+      }
+
+      if (ring) {
+         ring->inUse = true;
+         ring->threadIndex = ++numberOfThreads;
+         epicsAtomicSetSizeT (&ring->written, 0);
+      }
+   }
+
+   if (!ring) {
+      Trace_Event* events = (Trace_Event*) calloc (capacity, sizeof (Trace_Event));
+      if (!events) return NULL;
+
+      ring = new Trace_Ring;
+      ring->capacity = capacity;
+      ring->written = 0;
+      ring->events = events;
+      ring->inUse = true;
+
+      epicsGuard<epicsMutex> guard (ringsMutex);
+      ring->threadIndex = ++numberOfThreads;
+      rings.push_back (ring);
+   }
+
+   snprintf (ring->threadName, sizeof (ring->threadName), "%s",
+             epicsThreadGetNameSelf ());
+
+   epicsThreadPrivateSet (ringKey, ring);
+   epicsAtThreadExit (releaseRing, ring);
+   return ring;
+}
+
+//------------------------------------------------------------------------------
+// Returns a copy of the rings list.
+//
+static Trace_Ring_Lists allRings ()
+{
+   epicsGuard<epicsMutex> guard (ringsMutex);
+   return rings;
+}
+
+//------------------------------------------------------------------------------
+// static
+bool ACAI::Trace::isCompiledIn ()
+{
+#ifdef ACAI_TRACING
+   return true;
+#else
+   return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Trace::setEnabled (const bool enabledIn)
+{
+   epicsAtomicSetIntT (&enabled, enabledIn ? 1 : 0);
+}
+
+//------------------------------------------------------------------------------
+// static
+bool ACAI::Trace::isEnabled ()
+{
+   return epicsAtomicGetIntT (&enabled) != 0;
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Trace::setRingCapacity (const int capacity)
+{
+   epicsAtomicSetIntT (&defaultCapacity, MAX (capacity, 64));
+}
+
+//------------------------------------------------------------------------------
+// static
+int ACAI::Trace::ringCapacity ()
+{
+   return epicsAtomicGetIntT (&defaultCapacity);
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Trace::record (const ACAI::TraceKinds kind, const void* id,
+                          const epicsUInt64 start, const epicsUInt64 finish,
+                          const size_t size)
+{
+   Trace_Ring* ring = threadRing ();
+   if (!ring) return;
+
+   const size_t index = ring->written;
+   Trace_Event* event = &ring->events [index % ring->capacity];
+   event->start = start;
+   event->finish = MAX (start, finish);
+   event->id = id;
+   event->size = size;
+   event->kind = kind;
+
+   epicsAtomicWriteMemoryBarrier ();
+   epicsAtomicSetSizeT (&ring->written, index + 1);
+}
+
+//------------------------------------------------------------------------------
+// static
+size_t ACAI::Trace::eventCount ()
+{
+   Trace_Ring_Lists list = allRings ();
+   size_t result = 0;
+
+   ACAI_ITERATE (Trace_Ring_Lists, list, ringRef) {
+      const Trace_Ring* ring = *ringRef;
+      result += MIN (epicsAtomicGetSizeT (&ring->written), ring->capacity);
+   }
+   return result;
+}
+
+//------------------------------------------------------------------------------
+// static
+void ACAI::Trace::clear ()
+{
+   Trace_Ring_Lists list = allRings ();
+
+   ACAI_ITERATE (Trace_Ring_Lists, list, ringRef) {
+      Trace_Ring* ring = *ringRef;
+      epicsAtomicSetSizeT (&ring->written, 0);
+   }
+}
+
+//------------------------------------------------------------------------------
+// Copies text to buffer as the contents of a JSON string, i.e. with quotes,
+// back slashes and control characters escaped. Truncates as necessary.
+//
+static void jsonEscape (const char* text, char* buffer, const size_t size)
+{
+   size_t n = 0;
+   for (const char* p = text; *p; p++) {
+      const unsigned char c = (unsigned char) *p;
+      char escaped [8];
+      if ((c == '"') || (c == '\\')) {
+         snprintf (escaped, sizeof (escaped), "\\%c", c);
+      } else if (c < 0x20) {
+         snprintf (escaped, sizeof (escaped), "\\u%04x", (unsigned int) c);
+      } else {
+         escaped [0] = c;
+         escaped [1] = '\0';
+      }
+
+      const size_t length = strlen (escaped);
+      if (n + length >= size) break;
+      memcpy (buffer + n, escaped, length);
+      n += length;
+   }
+   buffer [n] = '\0';
+}
+
+//------------------------------------------------------------------------------
+// static
+bool ACAI::Trace::writeChromeTrace (const char* filename)
+{
+   if (!filename) return false;
+
+   FILE* file = fopen (filename, "w");
+   if (!file) return false;
+
+   Trace_Ring_Lists list = allRings ();
+
+   // Find the earliest event time - all times are written relative to this.
+   //
+   epicsUInt64 origin = 0;
+   bool first = true;
+   ACAI_ITERATE (Trace_Ring_Lists, list, ringRef) {
+      const Trace_Ring* ring = *ringRef;
+      const size_t written = epicsAtomicGetSizeT (&ring->written);
+      epicsAtomicReadMemoryBarrier ();
+      const size_t number = MIN (written, ring->capacity);
+      for (size_t j = written - number; j < written; j++) {
+         const Trace_Event* event = &ring->events [j % ring->capacity];
+         if (first || (event->start < origin)) {
+            origin = event->start;
+            first = false;
+         }
+      }
+   }
+
+   fprintf (file, "{\"traceEvents\":[\n");
+   const char* separator = "";
+
+   ACAI_ITERATE (Trace_Ring_Lists, list, ringRef) {
+      const Trace_Ring* ring = *ringRef;
+
+      char threadName [6 * sizeof (ring->threadName)];
+      jsonEscape (ring->threadName, threadName, sizeof (threadName));
+      fprintf (file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+               "\"args\":{\"name\":\"%s\"}}",
+               separator, ring->threadIndex, threadName);
+      separator = ",\n";
+
+      const size_t written = epicsAtomicGetSizeT (&ring->written);
+      epicsAtomicReadMemoryBarrier ();
+      const size_t number = MIN (written, ring->capacity);
+      for (size_t j = written - number; j < written; j++) {
+         const Trace_Event* event = &ring->events [j % ring->capacity];
+         const char* name = ACAI::Trace::kindImage (event->kind);
+         const double ts = double (event->start - MIN (event->start, origin)) * 1.0e-3;   // uS
+
+         if (event->finish > event->start) {
+            const double dur = double (event->finish - event->start) * 1.0e-3;
+            fprintf (file, "%s{\"name\":\"%s\",\"cat\":\"acai\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,",
+                     separator, name, ts, dur);
+         } else {
+            fprintf (file, "%s{\"name\":\"%s\",\"cat\":\"acai\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,",
+                     separator, name, ts);
+         }
+         fprintf (file, "\"pid\":1,\"tid\":%d,\"args\":{\"id\":\"%p\",\"size\":%lu}}",
+                  ring->threadIndex, event->id, (unsigned long) event->size);
+      }
+   }
+
+   fprintf (file, "\n]}\n");
+   const bool result = (ferror (file) == 0);
+   fclose (file);
+   return result;
+}
+
+//------------------------------------------------------------------------------
+// static
+const char* ACAI::Trace::kindImage (const ACAI::TraceKinds kind)
+{
+   const int k = int (kind);
+   return ((k >= 0) && (k < NUMBER_OF_TRACE_KINDS)) ? kindImages [k] : "unknown";
+}
+
+// end
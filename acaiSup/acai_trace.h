@@ -0,0 +1,130 @@
+/* acai_trace.h
+ *
+ * This file is part of the ACAI library. It provides a low overhead
+ * event tracing facility.
+ *
+ * Copyright (C) 2013-2023  Andrew C. Starritt
+ *
+ * The ACAI library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * The ACAI library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the ACAI library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Contact details:
+ * andrew.starritt@gmail.com
+ * PO Box 3118, Prahran East, Victoria 3181, Australia.
+ *
+ */
+
+#ifndef ACAI_TRACE_H_
+#define ACAI_TRACE_H_
+
+#include <stddef.h>
+#include <epicsTypes.h>
+#include <acai_shared.h>
+
+namespace ACAI {
+
+/// Traced event kinds.
+///
+enum TraceKinds {
+   TraceConnectionUp = 0,     ///< connection up dispatched
+   TraceConnectionDown,       ///< connection down dispatched
+   TraceQueued,               ///< callback queued, i.e. enqueue to dispatch
+   TraceDispatch,             ///< callback dispatch, i.e. handler duration
+   TracePut,                  ///< put issued
+   TracePutCallback,          ///< put callback dispatched
+   NUMBER_OF_TRACE_KINDS      // must be last
+};
+
+/// \brief The ACAI::Trace class provides a low overhead event tracing facility
+/// for diagnosing latency spikes.
+///
+/// Events are recorded into a per thread ring buffer, so recording takes no
+/// lock. When a ring is full, the oldest events are overwritten. When a thread
+/// created by epicsThreadCreate exits, its ring and events are retained until
+/// the ring is re-used by a subsequent thread, so the memory used is bounded by
+/// the peak number of concurrent tracing threads rather than by thread churn. The recorded
+/// events may be written out in the Chrome trace event JSON format, which may
+/// be viewed using chrome://tracing or https://ui.perfetto.dev
+///
+/// The library's trace points are only compiled in when the library is built
+/// with ACAI_TRACING defined (see acaiSup/Makefile), and then only record when
+/// enabled at run time. Without ACAI_TRACING, the trace points cost nothing.
+///
+/// All functions are static and thread safe. However, events recorded while
+/// writeChromeTrace or clear is in progress may be garbled or lost, so it is
+/// best to disable tracing first.
+///
+class ACAI_SHARED_CLASS Trace {
+public:
+   /// Returns true if the library was built with ACAI_TRACING defined.
+   ///
+   static bool isCompiledIn ();
+
+   /// Enables or disables recording at run time. The default is disabled.
+   ///
+   static void setEnabled (const bool enabled);
+   static bool isEnabled ();
+
+   /// Sets the number of events held per thread ring buffer, default 16384.
+   /// Only applies to rings created subsequently, i.e. for threads that have
+   /// not yet recorded an event. Constrained to >= 64.
+   ///
+   static void setRingCapacity (const int capacity);
+   static int ringCapacity ();
+
+   /// Records an event - intended to be called via the ACAI_TRACE macro.
+   /// The start and finish times are monotonic times in nano seconds as per
+   /// epicsMonotonicGet; for instantaneous events, finish may be zero.
+   /// The id is typically the channel id, and size is the data size if any.
+   ///
+   static void record (const ACAI::TraceKinds kind, const void* id,
+                       const epicsUInt64 start, const epicsUInt64 finish,
+                       const size_t size);
+
+   /// Returns the number of events currently held, over all threads.
+   ///
+   static size_t eventCount ();
+
+   /// Discards all recorded events.
+   ///
+   static void clear ();
+
+   /// Writes the recorded events, in the Chrome trace event JSON format, to the
+   /// specified file. Returns true if successful.
+   ///
+   static bool writeChromeTrace (const char* filename);
+
+   /// Returns the name of the trace kind.
+   ///
+   static const char* kindImage (const ACAI::TraceKinds kind);
+
+private:
+   Trace () {}   // static only - no instances
+};
+
+}
+
+// Trace point macro. Arguments are only evaluated when tracing is compiled in
+// and enabled.
+//
+#ifdef ACAI_TRACING
+#define ACAI_TRACE(kind, id, start, finish, size) do {               \
+   if (ACAI::Trace::isEnabled ()) {                                  \
+      ACAI::Trace::record (kind, id, start, finish, size);           \
+   }                                                                 \
+} while (0)
+#else
+#define ACAI_TRACE(kind, id, start, finish, size)
+#endif
+
+#endif  // ACAI_TRACE_H_
@@ -42,6 +42,7 @@
  */
 
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -49,7 +50,9 @@
 #include <cadef.h>
 #include <caerr.h>
 #include <ellLib.h>
+#include <epicsAtomic.h>
 #include <epicsMutex.h>
+#include <epicsTime.h>
 
 #include "buffered_callbacks.h"
 
@@ -89,17 +92,91 @@ typedef struct Callback_Items {
    struct connection_handler_args cargs;
    struct event_handler_args eargs;
    char *formatted_text;
+
+   /* The channel's user data, captured when the callback is buffered, as the
+    * channel may have been cleared by the time the callback is processed.
+    */
+   void *puser;
+
+   /* Monotonic time, nano seconds, when the callback was queued.
+    */
+   epicsUInt64 enqueue_time;
+
+   /* Size of the dbr copy or formatted text, for the bytes buffered statistic.
+    */
+   size_t data_size;
+
+   /* Number, and total dbr size, of earlier updates for the same subscription
+    * superseded by this update whilst queued - see load_element.
+    */
+   size_t coalesced_count;
+   size_t coalesced_bytes;
 } Callback_Items;
 
 
+/* Update filter actions
+ */
+typedef enum Filter_Actions {
+   FILTER_PASS,
+   FILTER_DROP,
+   FILTER_HOLD
+} Filter_Actions;
+
+
+/* Per subscription update filter - see set_buffered_update_filter.
+ * Filters are held in a small hash table keyed by the subscription's usr.
+ */
+typedef struct Update_Filters {
+   struct Update_Filters *next;
+   void *usr;
+   double absolute_deadband;
+   double relative_deadband;
+   epicsUInt64 minimum_interval;        /* nano seconds */
+   epicsUInt64 next_time;               /* monotonic time, nano seconds */
+   int has_last_value;
+   double last_value;                   /* last value passed */
+   dbr_short_t last_severity;
+   dbr_short_t last_status;
+   Callback_Items *held;                /* latest update held back, or NULL */
+   unsigned int filtered_count;
+} Update_Filters;
+
+#define FILTER_TABLE_SIZE  256
+
+
 /*------------------------------------------------------------------------------
  * Module data
  */
 static epicsMutexId linked_list_mutex = NULL;
 static ELLLIST linked_list = ELLLIST_INIT;
-static unsigned int allocate_fail_count = 0;
+static size_t allocate_fail_count = 0;
 static unsigned int multiple_check_limit = 1000;
-static unsigned int discard_count = 0;
+static size_t discard_count = 0;
+
+/* Returns the channel's user data - NULL means use ca_puser.
+ */
+static Buffered_Puser_Function puser_function = NULL;
+
+/* Operational statistics - see get_buffered_callback_statistics.
+ * The counters are maintained using atomics. The dispatch durations, and the
+ * queue high water mark, are protected by the linked_list_mutex.
+ */
+static Buffered_Callback_Statistics statistics;
+static epicsUInt64 statistics_start_time = 0;
+
+#define STATISTIC_INCR(field)       epicsAtomicIncrSizeT (&statistics.field)
+#define STATISTIC_ADD(field, n)     epicsAtomicAddSizeT (&statistics.field, n)
+#define STATISTIC_SUB(field, n)     epicsAtomicSubSizeT (&statistics.field, n)
+#define STATISTIC_GET(field)        epicsAtomicGetSizeT (&statistics.field)
+
+/* The filter table is also protected by the linked_list_mutex. The filter and
+ * held counts are only modified while holding the mutex, but are also checked
+ * without it, so all accesses are atomic.
+ */
+static Update_Filters *filter_table[FILTER_TABLE_SIZE];
+static int filter_count = 0;
+static int held_count = 0;
+static unsigned int filtered_update_count = 0;
 
 
 /*------------------------------------------------------------------------------
@@ -116,11 +193,14 @@ static Callback_Items *allocate_element (const Callback_Kinds kind)
        */
       pci->eargs.dbr = NULL;
       pci->formatted_text = NULL;
+      pci->puser = NULL;
+      pci->enqueue_time = epicsMonotonicGet ();
+      pci->data_size = 0;
+      pci->coalesced_count = 0;
+      pci->coalesced_bytes = 0;
    } else {
-      /* Technically we should protect this with a mutex, but only used
-       * as diagnostic so do not have to be that strict.
-       */
-      allocate_fail_count++;
+      epicsAtomicIncrSizeT (&allocate_fail_count);
+      STATISTIC_INCR (allocate_fail_count);
    }
 
    return pci;
@@ -132,6 +212,10 @@ static Callback_Items *allocate_element (const Callback_Kinds kind)
  */
 static void free_element (Callback_Items * pci)
 {
+   if (pci->data_size > 0) {
+      STATISTIC_SUB (bytes_buffered, pci->data_size);
+   }
+
    switch (pci->kind) {
 
       case CONNECTION:
@@ -162,6 +246,20 @@ static void free_element (Callback_Items * pci)
 }                               /* free_element */
 
 
+/*------------------------------------------------------------------------------
+ * Updates the queue length high water mark. The caller must hold the
+ * linked_list_mutex.
+ */
+static void note_queue_length ()
+{
+   const size_t length = (size_t) ellCount (&linked_list);
+
+   if (length > statistics.queue_high_water_mark) {
+      epicsAtomicSetSizeT (&statistics.queue_high_water_mark, length);
+   }
+}                               /* note_queue_length */
+
+
 /*------------------------------------------------------------------------------
  */
 static void load_element (Callback_Items* pci)
@@ -184,11 +282,15 @@ static void load_element (Callback_Items* pci)
              (ci->eargs.type == pci->eargs.type) &&
              (ci->eargs.usr == pci->eargs.usr))
          {
-            /* we have a match - remove the earliest previous update
+            /* we have a match - remove the earliest previous update,
+             * but carry forward its accounting.
              */
+            pci->coalesced_count += ci->coalesced_count + 1;
+            pci->coalesced_bytes += ci->coalesced_bytes + ci->data_size;
             ellDelete (&linked_list, check);
             free_element (ci);
-            discard_count++;
+            epicsAtomicIncrSizeT (&discard_count);
+            STATISTIC_INCR (coalesced_count);
 
             break;  /* we need only search for one. */
          }
@@ -197,6 +299,7 @@ static void load_element (Callback_Items* pci)
    }
 
    ellAdd (&linked_list, (ELLNODE *) pci);
+   note_queue_length ();
 
    /* Release exclusive access to linked list
     */
@@ -225,6 +328,259 @@ static Callback_Items *unload_element ()
 }                               /* unload_element */
 
 
+/*------------------------------------------------------------------------------
+ * Update filter support. The caller must hold the linked_list_mutex.
+ */
+static unsigned int filter_hash (const void *usr)
+{
+   const size_t key = (size_t) usr;
+   return (unsigned int) ((key ^ (key >> 8) ^ (key >> 16)) % FILTER_TABLE_SIZE);
+}                               /* filter_hash */
+
+
+/*------------------------------------------------------------------------------
+ */
+static Update_Filters *find_filter (const void *usr)
+{
+   Update_Filters *filter;
+
+   filter = filter_table[filter_hash (usr)];
+   while (filter && (filter->usr != usr)) {
+      filter = filter->next;
+   }
+   return filter;
+}                               /* find_filter */
+
+
+/*------------------------------------------------------------------------------
+ * Discards any update held by the filter.
+ */
+static void discard_held (Update_Filters * filter)
+{
+   if (filter->held) {
+      free_element (filter->held);
+      filter->held = NULL;
+      epicsAtomicDecrIntT (&held_count);
+      filter->filtered_count++;
+      filtered_update_count++;
+      STATISTIC_INCR (filtered_count);
+   }
+}                               /* discard_held */
+
+
+/*------------------------------------------------------------------------------
+ * Extracts the value of a scalar numeric update. Returns 1 if successful,
+ * else 0, e.g. for strings and arrays to which the deadbands do not apply.
+ */
+static int scalar_value (const struct event_handler_args *args, double *value)
+{
+   const void *ptr;
+
+   if (args->count != 1) return 0;
+
+   ptr = dbr_value_ptr (args->dbr, args->type);
+   switch (args->type) {
+      case DBR_TIME_SHORT:  *value = *(const dbr_short_t *) ptr;  break;
+      case DBR_TIME_FLOAT:  *value = *(const dbr_float_t *) ptr;  break;
+      case DBR_TIME_ENUM:   *value = *(const dbr_enum_t *) ptr;   break;
+      case DBR_TIME_CHAR:   *value = *(const dbr_char_t *) ptr;   break;
+      case DBR_TIME_LONG:   *value = *(const dbr_long_t *) ptr;   break;
+      case DBR_TIME_DOUBLE: *value = *(const dbr_double_t *) ptr; break;
+      default:
+         return 0;
+   }
+   return 1;
+}                               /* scalar_value */
+
+
+/*------------------------------------------------------------------------------
+ * Returns 1 if the value change exceeds the filter's deadband(s), else 0.
+ */
+static int exceeds_deadband (const Update_Filters * filter, const double value)
+{
+   double delta;
+
+   if ((filter->absolute_deadband <= 0.0) && (filter->relative_deadband <= 0.0)) {
+      return 1;
+   }
+
+   delta = value - filter->last_value;
+   if (delta < 0.0) delta = -delta;
+
+   if ((filter->absolute_deadband > 0.0) && (delta <= filter->absolute_deadband)) {
+      return 0;
+   }
+
+   if (filter->relative_deadband > 0.0) {
+      const double magnitude = filter->last_value >= 0.0 ?
+            filter->last_value : -filter->last_value;
+      if (delta <= filter->relative_deadband * magnitude) {
+         return 0;
+      }
+   }
+
+   return 1;
+}                               /* exceeds_deadband */
+
+
+/*------------------------------------------------------------------------------
+ * Decides what to do with an event. This is called prior to copying the event,
+ * so that filtered events cost no allocation, copy or dispatch.
+ */
+static Filter_Actions apply_filter (const struct event_handler_args *args)
+{
+   Update_Filters *filter;
+   const struct dbr_time_string *header;
+   int alarm_changed;
+   int is_scalar;
+   double value = 0.0;
+   epicsUInt64 now;
+
+   filter = find_filter (args->usr);
+   if (!filter) return FILTER_PASS;
+
+   /* Only successful time stamped updates are filtered.
+    */
+   if ((args->status != ECA_NORMAL) || !args->dbr ||
+       (args->type < DBR_TIME_STRING) || (args->type > DBR_TIME_DOUBLE)) {
+      return FILTER_PASS;
+   }
+
+   /* All DBR_TIME_xxx structures have the same alarm header layout.
+    */
+   header = (const struct dbr_time_string *) args->dbr;
+   alarm_changed = !filter->has_last_value ||
+         (header->severity != filter->last_severity) ||
+         (header->status != filter->last_status);
+
+   is_scalar = scalar_value (args, &value);
+
+   if (!alarm_changed && is_scalar && !exceeds_deadband (filter, value)) {
+      filter->filtered_count++;
+      filtered_update_count++;
+      STATISTIC_INCR (filtered_count);
+      return FILTER_DROP;
+   }
+
+   filter->has_last_value = 1;
+   filter->last_value = value;
+   filter->last_severity = header->severity;
+   filter->last_status = header->status;
+
+   if (filter->minimum_interval == 0) return FILTER_PASS;
+
+   now = epicsMonotonicGet ();
+
+   /* Alarm changes are never delayed - and supersede any held update.
+    */
+   if (alarm_changed || ((now >= filter->next_time) && !filter->held)) {
+      discard_held (filter);
+      filter->next_time = now + filter->minimum_interval;
+      return FILTER_PASS;
+   }
+
+   return FILTER_HOLD;
+}                               /* apply_filter */
+
+
+/*------------------------------------------------------------------------------
+ * Holds back the update, replacing any previously held update. If the filter
+ * has since been cleared, the update is queued as normal.
+ */
+static void hold_element (Callback_Items * pci)
+{
+   Update_Filters *filter;
+
+   epicsMutexLock (linked_list_mutex);
+
+   filter = find_filter (pci->eargs.usr);
+   if (filter) {
+      if (filter->held) {
+         discard_held (filter);
+      }
+      filter->held = pci;
+      epicsAtomicIncrIntT (&held_count);
+   } else {
+      ellAdd (&linked_list, (ELLNODE *) pci);
+      note_queue_length ();
+   }
+
+   epicsMutexUnlock (linked_list_mutex);
+}                               /* hold_element */
+
+
+/*------------------------------------------------------------------------------
+ * Queues held updates whose minimum interval has elapsed.
+ */
+static void release_held_elements ()
+{
+   Update_Filters *filter;
+   epicsUInt64 now;
+   int j;
+
+   epicsMutexLock (linked_list_mutex);
+
+   now = epicsMonotonicGet ();
+   for (j = 0; (j < FILTER_TABLE_SIZE) && (epicsAtomicGetIntT (&held_count) > 0); j++) {
+      for (filter = filter_table[j]; filter; filter = filter->next) {
+         if (filter->held && (now >= filter->next_time)) {
+            /* Queue latency is measured from the release, not from the
+             * (deliberately delayed) arrival.
+             */
+            filter->held->enqueue_time = now;
+            ellAdd (&linked_list, (ELLNODE *) filter->held);
+            filter->held = NULL;
+            epicsAtomicDecrIntT (&held_count);
+            filter->next_time = now + filter->minimum_interval;
+         }
+      }
+   }
+   note_queue_length ();
+
+   epicsMutexUnlock (linked_list_mutex);
+}                               /* release_held_elements */
+
+
+/*------------------------------------------------------------------------------
+ * Discards updates held for the given channel, e.g. on disconnect, so that
+ * stale data is not delivered after the disconnection.
+ */
+static void discard_held_for_channel (const chid channel)
+{
+   Update_Filters *filter;
+   int j;
+
+   epicsMutexLock (linked_list_mutex);
+
+   for (j = 0; (j < FILTER_TABLE_SIZE) && (epicsAtomicGetIntT (&held_count) > 0); j++) {
+      for (filter = filter_table[j]; filter; filter = filter->next) {
+         if (filter->held && (filter->held->eargs.chid == channel)) {
+            discard_held (filter);
+         }
+      }
+   }
+
+   epicsMutexUnlock (linked_list_mutex);
+}                               /* discard_held_for_channel */
+
+
+/*------------------------------------------------------------------------------
+ */
+static void *channel_puser (chid channel)
+{
+   Buffered_Puser_Function func = puser_function;
+   return func ? func (channel) : ca_puser (channel);
+}                               /* channel_puser */
+
+
+/*------------------------------------------------------------------------------
+ */
+void set_buffered_puser_function (Buffered_Puser_Function func)
+{
+   puser_function = func;
+}                               /* set_buffered_puser_function */
+
+
 /*------------------------------------------------------------------------------
  * Connection handler
  */
@@ -237,6 +593,21 @@ void buffered_connection_handler (struct connection_handler_args args)
 
       /* Copy all fields. */
       pci->cargs = args;
+      pci->puser = args.chid ? channel_puser (args.chid) : NULL;
+
+      STATISTIC_INCR (enqueue_count);
+      STATISTIC_INCR (connection_count);
+      if (args.op == CA_OP_CONN_UP) {
+         STATISTIC_INCR (connection_up_count);
+      } else {
+         STATISTIC_INCR (connection_down_count);
+      }
+
+      /* Atomic check without the mutex - discard_held_for_channel takes it.
+       */
+      if ((args.op == CA_OP_CONN_DOWN) && (epicsAtomicGetIntT (&held_count) > 0)) {
+         discard_held_for_channel (args.chid);
+      }
 
       load_element (pci);
    }
@@ -250,12 +621,25 @@ void buffered_event_handler (struct event_handler_args args)
 {
    Callback_Items *pci;
    size_t size;
+   Filter_Actions action = FILTER_PASS;
+
+   /* Apply any update filter before copying the event. The filter_count check
+    * is deliberately made without the mutex (but atomically) - it avoids taking
+    * the mutex twice when, as is typical, there are no filters.
+    */
+   if (epicsAtomicGetIntT (&filter_count) > 0) {
+      epicsMutexLock (linked_list_mutex);
+      action = apply_filter (&args);
+      epicsMutexUnlock (linked_list_mutex);
+      if (action == FILTER_DROP) return;
+   }
 
    pci = allocate_element (EVENT);
    if (pci) {
 
       /* Copy all fields. */
       pci->eargs = args;
+      pci->puser = args.chid ? channel_puser (args.chid) : NULL;
 
       /* Calculate size of dbr field, and alloc memory for copy iff required
        */
@@ -263,9 +647,19 @@ void buffered_event_handler (struct event_handler_args args)
          size = dbr_size_n (args.type, args.count);
          pci->eargs.dbr = malloc (size);
          memcpy ((void *) pci->eargs.dbr, args.dbr, size);
+         pci->data_size = size;
+         STATISTIC_ADD (bytes_buffered, size);
+         STATISTIC_ADD (total_bytes_buffered, size);
       }
 
-      load_element (pci);
+      STATISTIC_INCR (enqueue_count);
+      STATISTIC_INCR (event_count);
+
+      if (action == FILTER_HOLD) {
+         hold_element (pci);
+      } else {
+         load_element (pci);
+      }
    }
 }                               /* buffered_event_handler */
 
@@ -298,6 +692,12 @@ int buffered_printf_handler (const char *pformat, va_list args)
       /* Copy expanded string
        */
       memcpy ((void *) pci->formatted_text, &expanded, size);
+      pci->data_size = size;
+      STATISTIC_ADD (bytes_buffered, size);
+      STATISTIC_ADD (total_bytes_buffered, size);
+
+      STATISTIC_INCR (enqueue_count);
+      STATISTIC_INCR (printf_count);
 
       load_element (pci);
 
@@ -313,6 +713,8 @@ void initialise_buffered_callbacks ()
    linked_list_mutex = epicsMutexCreate ();
    ellInit (&linked_list);
    allocate_fail_count = 0;
+   memset (&statistics, 0, sizeof (statistics));
+   statistics_start_time = epicsMonotonicGet ();
 }                               /* initialise_buffered_callbacks */
 
 
@@ -351,16 +753,264 @@ int  get_multiple_check_limit ()
  */
 int number_of_discarded_updates ()
 {
-   int n;
+   size_t n;
 
-   /* Essentially a diagnostic, so no mutex here.
+   /* Subtract what we read, as opposed to setting zero, so that no discard
+    * made concurrently with this read is lost.
     */
-   n = discard_count;
-   discard_count = 0;
-   return n;
+   n = epicsAtomicGetSizeT (&discard_count);
+   epicsAtomicSubSizeT (&discard_count, n);
+   return (int) n;
 }                               /* number_of_discarded_updates */
 
 
+/*------------------------------------------------------------------------------
+ */
+void get_buffered_callback_statistics (Buffered_Callback_Statistics *stats)
+{
+   if (!stats) return;
+
+   memset (stats, 0, sizeof (Buffered_Callback_Statistics));
+   if (!linked_list_mutex) return;
+
+   epicsMutexLock (linked_list_mutex);
+
+   stats->queue_length = (size_t) ellCount (&linked_list);
+   stats->queue_high_water_mark = STATISTIC_GET (queue_high_water_mark);
+   stats->held_count = (size_t) epicsAtomicGetIntT (&held_count);
+   stats->enqueue_count = STATISTIC_GET (enqueue_count);
+   stats->dequeue_count = STATISTIC_GET (dequeue_count);
+   stats->connection_count = STATISTIC_GET (connection_count);
+   stats->connection_up_count = STATISTIC_GET (connection_up_count);
+   stats->connection_down_count = STATISTIC_GET (connection_down_count);
+   stats->event_count = STATISTIC_GET (event_count);
+   stats->printf_count = STATISTIC_GET (printf_count);
+   stats->bytes_buffered = STATISTIC_GET (bytes_buffered);
+   stats->total_bytes_buffered = STATISTIC_GET (total_bytes_buffered);
+   stats->coalesced_count = STATISTIC_GET (coalesced_count);
+   stats->filtered_count = STATISTIC_GET (filtered_count);
+   stats->allocate_fail_count = STATISTIC_GET (allocate_fail_count);
+   stats->dispatch_count = STATISTIC_GET (dispatch_count);
+   stats->last_dispatch_duration = statistics.last_dispatch_duration;
+   stats->maximum_dispatch_duration = statistics.maximum_dispatch_duration;
+   stats->total_dispatch_duration = statistics.total_dispatch_duration;
+   stats->elapsed_time = (double) (epicsMonotonicGet () - statistics_start_time) * 1.0e-9;
+
+   epicsMutexUnlock (linked_list_mutex);
+}                               /* get_buffered_callback_statistics */
+
+
+/*------------------------------------------------------------------------------
+ * Note: bytes_buffered reflects current content and is not reset.
+ */
+void reset_buffered_callback_statistics ()
+{
+   if (!linked_list_mutex) return;
+
+   epicsMutexLock (linked_list_mutex);
+
+   epicsAtomicSetSizeT (&statistics.queue_high_water_mark, (size_t) ellCount (&linked_list));
+   epicsAtomicSetSizeT (&statistics.enqueue_count, 0);
+   epicsAtomicSetSizeT (&statistics.dequeue_count, 0);
+   epicsAtomicSetSizeT (&statistics.connection_count, 0);
+   epicsAtomicSetSizeT (&statistics.connection_up_count, 0);
+   epicsAtomicSetSizeT (&statistics.connection_down_count, 0);
+   epicsAtomicSetSizeT (&statistics.event_count, 0);
+   epicsAtomicSetSizeT (&statistics.printf_count, 0);
+   epicsAtomicSetSizeT (&statistics.total_bytes_buffered, 0);
+   epicsAtomicSetSizeT (&statistics.coalesced_count, 0);
+   epicsAtomicSetSizeT (&statistics.filtered_count, 0);
+   epicsAtomicSetSizeT (&statistics.allocate_fail_count, 0);
+   epicsAtomicSetSizeT (&statistics.dispatch_count, 0);
+   statistics.last_dispatch_duration = 0.0;
+   statistics.maximum_dispatch_duration = 0.0;
+   statistics.total_dispatch_duration = 0.0;
+   statistics_start_time = epicsMonotonicGet ();
+
+   epicsMutexUnlock (linked_list_mutex);
+}                               /* reset_buffered_callback_statistics */
+
+
+/*------------------------------------------------------------------------------
+ */
+int set_buffered_update_filter (void *usr,
+                                const double absolute_deadband,
+                                const double relative_deadband,
+                                const double minimum_interval)
+{
+   Update_Filters *filter;
+   unsigned int hash;
+
+   if (!linked_list_mutex || !usr) return -1;
+
+   if ((absolute_deadband <= 0.0) && (relative_deadband <= 0.0) &&
+       (minimum_interval <= 0.0)) {
+      clear_buffered_update_filter (usr);
+      return 0;
+   }
+
+   epicsMutexLock (linked_list_mutex);
+
+   filter = find_filter (usr);
+   if (!filter) {
+      filter = (Update_Filters *) calloc (1, sizeof (Update_Filters));
+      if (!filter) {
+         epicsMutexUnlock (linked_list_mutex);
+         return -1;
+      }
+      filter->usr = usr;
+      hash = filter_hash (usr);
+      filter->next = filter_table[hash];
+      filter_table[hash] = filter;
+      epicsAtomicIncrIntT (&filter_count);
+   }
+
+   filter->absolute_deadband = absolute_deadband > 0.0 ? absolute_deadband : 0.0;
+   filter->relative_deadband = relative_deadband > 0.0 ? relative_deadband : 0.0;
+   filter->minimum_interval = minimum_interval > 0.0 ?
+         (epicsUInt64) (minimum_interval * 1.0e9) : 0;
+
+   /* Ensure no update is held indefinitely.
+    */
+   if ((filter->minimum_interval == 0) && filter->held) {
+      ellAdd (&linked_list, (ELLNODE *) filter->held);
+      filter->held = NULL;
+      epicsAtomicDecrIntT (&held_count);
+      note_queue_length ();
+   }
+
+   epicsMutexUnlock (linked_list_mutex);
+   return 0;
+}                               /* set_buffered_update_filter */
+
+
+/*------------------------------------------------------------------------------
+ */
+void clear_buffered_update_filter (void *usr)
+{
+   Update_Filters **link;
+   Update_Filters *filter;
+
+   if (!linked_list_mutex || !usr) return;
+
+   epicsMutexLock (linked_list_mutex);
+
+   link = &filter_table[filter_hash (usr)];
+   while (*link && ((*link)->usr != usr)) {
+      link = &(*link)->next;
+   }
+
+   filter = *link;
+   if (filter) {
+      *link = filter->next;
+      discard_held (filter);
+      free (filter);
+      epicsAtomicDecrIntT (&filter_count);
+   }
+
+   epicsMutexUnlock (linked_list_mutex);
+}                               /* clear_buffered_update_filter */
+
+
+/*------------------------------------------------------------------------------
+ */
+int buffered_update_filter_count (void *usr)
+{
+   Update_Filters *filter;
+   int n = 0;
+
+   if (!linked_list_mutex || !usr) return 0;
+
+   epicsMutexLock (linked_list_mutex);
+   filter = find_filter (usr);
+   if (filter) n = (int) filter->filtered_count;
+   epicsMutexUnlock (linked_list_mutex);
+
+   return n;
+}                               /* buffered_update_filter_count */
+
+
+/*------------------------------------------------------------------------------
+ */
+int number_of_filtered_updates ()
+{
+   int n;
+
+   if (!linked_list_mutex) return 0;
+
+   epicsMutexLock (linked_list_mutex);
+   n = filtered_update_count;
+   filtered_update_count = 0;
+   epicsMutexUnlock (linked_list_mutex);
+
+   return n;
+}                               /* number_of_filtered_updates */
+
+
+/*------------------------------------------------------------------------------
+ * The args pointers passed to the application handlers always reference the
+ * cargs/eargs fields embedded within a Callback_Items structure.
+ */
+void *buffered_connection_puser (const struct connection_handler_args *args)
+{
+   const Callback_Items *pci;
+
+   if (!args) return NULL;
+   pci = (const Callback_Items *) ((const char *) args - offsetof (Callback_Items, cargs));
+   return pci->puser;
+}                               /* buffered_connection_puser */
+
+
+/*------------------------------------------------------------------------------
+ */
+void *buffered_event_puser (const struct event_handler_args *args)
+{
+   const Callback_Items *pci;
+
+   if (!args) return NULL;
+   pci = (const Callback_Items *) ((const char *) args - offsetof (Callback_Items, eargs));
+   return pci->puser;
+}                               /* buffered_event_puser */
+
+
+/*------------------------------------------------------------------------------
+ */
+epicsUInt64 buffered_connection_enqueue_time (const struct connection_handler_args *args)
+{
+   const Callback_Items *pci;
+
+   if (!args) return 0;
+   pci = (const Callback_Items *) ((const char *) args - offsetof (Callback_Items, cargs));
+   return pci->enqueue_time;
+}                               /* buffered_connection_enqueue_time */
+
+
+/*------------------------------------------------------------------------------
+ */
+epicsUInt64 buffered_event_enqueue_time (const struct event_handler_args *args)
+{
+   const Callback_Items *pci;
+
+   if (!args) return 0;
+   pci = (const Callback_Items *) ((const char *) args - offsetof (Callback_Items, eargs));
+   return pci->enqueue_time;
+}                               /* buffered_event_enqueue_time */
+
+
+/*------------------------------------------------------------------------------
+ */
+size_t buffered_event_coalesced (const struct event_handler_args *args, size_t *bytes)
+{
+   const Callback_Items *pci;
+
+   if (bytes) *bytes = 0;
+   if (!args) return 0;
+   pci = (const Callback_Items *) ((const char *) args - offsetof (Callback_Items, eargs));
+   if (bytes) *bytes = pci->coalesced_bytes;
+   return pci->coalesced_count;
+}                               /* buffered_event_coalesced */
+
+
 /*------------------------------------------------------------------------------
  * Process callbacks - called from application thread.
  */
@@ -372,11 +1022,23 @@ int process_buffered_callbacks (const int max)
 
    Callback_Items *pci = NULL;
    int n;
+   size_t fails;
+   epicsUInt64 start;
+   double duration;
+
+   start = epicsMonotonicGet ();
 
-   if (allocate_fail_count > 0) {
-      fprintf (stderr, "*** %s: Allocation failures (%d) \n",
-               __FUNCTION__, allocate_fail_count);
-      allocate_fail_count = 0;
+   fails = epicsAtomicGetSizeT (&allocate_fail_count);
+   if (fails > 0) {
+      epicsAtomicSubSizeT (&allocate_fail_count, fails);
+      fprintf (stderr, "*** %s: Allocation failures (%lu) \n",
+               __FUNCTION__, (unsigned long) fails);
+   }
+
+   /* Queue any held back updates now due.
+    */
+   if (epicsAtomicGetIntT (&held_count) > 0) {
+      release_held_elements ();
    }
 
    n = 0;
@@ -410,6 +1072,7 @@ int process_buffered_callbacks (const int max)
       /* Free element
        */
       free_element (pci);
+      STATISTIC_INCR (dequeue_count);
 
       /* Increment counter and test. Test at end of loop in order to process
        * at least one item (if available) regardless of the value of max.
@@ -420,6 +1083,18 @@ int process_buffered_callbacks (const int max)
       }
    }                            /* end loop */
 
+   /* Record the dispatch duration for this call.
+    */
+   duration = (double) (epicsMonotonicGet () - start) * 1.0e-9;
+   epicsMutexLock (linked_list_mutex);
+   statistics.last_dispatch_duration = duration;
+   if (duration > statistics.maximum_dispatch_duration) {
+      statistics.maximum_dispatch_duration = duration;
+   }
+   statistics.total_dispatch_duration += duration;
+   epicsMutexUnlock (linked_list_mutex);
+   STATISTIC_INCR (dispatch_count);
+
    return n;
 }                               /* process_buffered_callbacks */
 
@@ -434,11 +1109,28 @@ void clear_all_buffered_callbacks ()
 
    Callback_Items *pci;
 
+   Update_Filters *filter;
+   int j;
+
    pci = unload_element ();      /* Get first if it exists */
    while (pci != NULL) {
       free_element (pci);        /* Free element */
       pci = unload_element ();   /* Get next if exists */
    }
+
+   /* Discard all update filters and any held updates.
+    */
+   epicsMutexLock (linked_list_mutex);
+   for (j = 0; j < FILTER_TABLE_SIZE; j++) {
+      while (filter_table[j]) {
+         filter = filter_table[j];
+         filter_table[j] = filter->next;
+         discard_held (filter);
+         free (filter);
+      }
+   }
+   epicsAtomicSetIntT (&filter_count, 0);
+   epicsMutexUnlock (linked_list_mutex);
 }
 
 /* end */
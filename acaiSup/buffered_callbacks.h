@@ -109,6 +109,7 @@
 #define _BUFFERED_CALLBACKS_H_
 
 #include <cadef.h>
+#include <epicsTypes.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -153,6 +154,129 @@ int  get_multiple_check_limit ();
  */
 int number_of_discarded_updates ();
 
+/* Operational statistics. These are cumulative since initialisation or the
+ * last reset, and are cheap enough to be always collected.
+ *
+ * queue_length           - current number of queued callbacks
+ * queue_high_water_mark  - maximum queue length
+ * held_count             - updates currently held back by update filters
+ * enqueue_count          - callbacks buffered, of all kinds
+ * dequeue_count          - callbacks dispatched by process_buffered_callbacks
+ * connection_count       - connection callbacks buffered, split into
+ * connection_up_count      connection up and
+ * connection_down_count    connection down callbacks
+ * event_count            - event callbacks buffered (after filtering)
+ * printf_count           - printf callbacks buffered
+ * bytes_buffered         - current size of buffered event data and text
+ * total_bytes_buffered   - cumulative size of buffered event data and text
+ * coalesced_count        - updates superseded by a later update for the same
+ *                          subscription, see set_multiple_check_limit
+ * filtered_count         - updates removed by update filters
+ * allocate_fail_count    - failed callback allocations
+ * dispatch_count         - calls to process_buffered_callbacks
+ * xxx_dispatch_duration  - last, maximum and total duration, in seconds, of
+ *                          process_buffered_callbacks calls
+ * elapsed_time           - seconds since statistics initialised/reset, from
+ *                          which rates may be calculated
+ */
+typedef struct Buffered_Callback_Statistics {
+   size_t queue_length;
+   size_t queue_high_water_mark;
+   size_t held_count;
+   size_t enqueue_count;
+   size_t dequeue_count;
+   size_t connection_count;
+   size_t connection_up_count;
+   size_t connection_down_count;
+   size_t event_count;
+   size_t printf_count;
+   size_t bytes_buffered;
+   size_t total_bytes_buffered;
+   size_t coalesced_count;
+   size_t filtered_count;
+   size_t allocate_fail_count;
+   size_t dispatch_count;
+   double last_dispatch_duration;
+   double maximum_dispatch_duration;
+   double total_dispatch_duration;
+   double elapsed_time;
+} Buffered_Callback_Statistics;
+
+/* get_buffered_callback_statistics takes a consistent snapshot of the
+ * statistics. All values are zero if initialise_buffered_callbacks has not
+ * been called. Unlike number_of_discarded_updates, this is not destructive.
+ * reset_buffered_callback_statistics resets the cumulative statistics, and the
+ * high water mark to the current queue length.
+ */
+void get_buffered_callback_statistics (Buffered_Callback_Statistics *stats);
+void reset_buffered_callback_statistics ();
+
+/* Update filters. These allow the updates for a subscription, identified by its
+ * user argument, usr, to be filtered as they are buffered, so that filtered
+ * updates cost no copy, queueing or dispatch. Only successful DBR_TIME_xxx
+ * updates are filtered; an update whose alarm severity or status differs from
+ * the last update passed always passes, immediately.
+ *
+ * absolute_deadband/relative_deadband: a scalar numeric update passes only if
+ *    its change from the last value passed exceeds absolute_deadband and
+ *    relative_deadband times the magnitude of the last value passed. These do
+ *    not apply to strings or arrays. Values <= 0 disable the deadband.
+ * minimum_interval: minimum time, in seconds, between updates. An update that
+ *    arrives early is held back, replacing any previously held update, and the
+ *    latest such update is queued by process_buffered_callbacks once the interval
+ *    has elapsed, i.e. the last value is always delivered. Any held update is
+ *    discarded if the channel disconnects. A value <= 0 disables the interval.
+ *
+ * set_buffered_update_filter creates or updates the filter for usr, or clears
+ * it if all parameters are <= 0. It returns 0 on success, else -1.
+ * clear_buffered_update_filter removes the filter for usr, if any, together
+ * with any held update.
+ * buffered_update_filter_count returns the number of updates filtered out for
+ * usr, including held updates superseded or discarded.
+ * number_of_filtered_updates returns the total number of updates filtered out.
+ * This is a destructive read - i.e. resets the count to zero.
+ */
+int  set_buffered_update_filter (void *usr,
+                                 const double absolute_deadband,
+                                 const double relative_deadband,
+                                 const double minimum_interval);
+void clear_buffered_update_filter (void *usr);
+int  buffered_update_filter_count (void *usr);
+int  number_of_filtered_updates ();
+
+/* These functions return the channel's user data, i.e. ca_puser (chid), as it
+ * was when the callback was buffered. Unlike ca_puser, these are safe to call
+ * even if the channel has since been cleared. The args parameter MUST be the
+ * pointer passed to application_connection_handler/application_event_handler
+ * respectively, and these functions may only be called during that handler.
+ */
+void *buffered_connection_puser (const struct connection_handler_args *args);
+void *buffered_event_puser (const struct event_handler_args *args);
+
+/* These functions return the monotonic time, in nano seconds as per
+ * epicsMonotonicGet, at which the callback was queued. For updates held back
+ * by an update filter, this is the time the update was released. The same
+ * restrictions on the args parameter apply as above.
+ */
+epicsUInt64 buffered_connection_enqueue_time (const struct connection_handler_args *args);
+epicsUInt64 buffered_event_enqueue_time (const struct event_handler_args *args);
+
+/* Returns the number of earlier updates for the same subscription that were
+ * coalesced into, i.e. superseded by, this update whilst queued, and sets
+ * *bytes (if not NULL) to their total dbr size. Such updates are never
+ * dispatched. The same restrictions on the args parameter apply as above.
+ */
+size_t buffered_event_coalesced (const struct event_handler_args *args, size_t *bytes);
+
+/* By default, the channel's user data is obtained by calling ca_puser when a
+ * callback is buffered. An alternative function may be set, e.g. when the
+ * callbacks originate from a simulated channel access backend, whose channel
+ * ids are not known to the ca library. A NULL func restores ca_puser.
+ * This should only be changed while no channels exist.
+ */
+typedef void *(*Buffered_Puser_Function) (chid channel);
+void set_buffered_puser_function (Buffered_Puser_Function func);
+
 /* This function should be called regularly - say every 10-50 mSeconds.
  * It process a maximum of max buffered items. It returns the actual number of
  * callbacks processed (<= max).
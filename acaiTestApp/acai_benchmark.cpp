@@ -0,0 +1,429 @@
+// acai_benchmark.cpp
+//
+// Benchmark suite for the ACAI library. Results are written to standard output
+// as JSON lines, i.e. one JSON object per benchmark, so that results may be
+// collected and compared across builds in order to track regressions.
+//
+// Usage: acai_benchmark [number_of_clients [number_of_users]]
+// The number of clients defaults to 1000 and the number of users to 4.
+//
+// All benchmarks use the in-process simulated backend, see ACAI::Simulation,
+// and updates are generated by explicit calls to advance, so that no IOC is
+// required and the results are comparable from machine to machine. The
+// connect storm, dispatch and string formatting benchmarks use the clients,
+// spread over four scalar PVs. The array conversion benchmark uses a single
+// array PV.
+//
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_client_set.h>
+#include <acai_abstract_client_user.h>
+#include <acai_statistics.h>
+#include <acai_simulation.h>
+#include <acai_version.h>
+#include <epicsTime.h>
+
+#define DISPATCH_CYCLES       500
+#define DISPATCH_INTERVAL     0.01    // simulated seconds per cycle
+#define DISPATCH_RATE         100.0   // updates per second per PV
+#define STORM_POLL_LIMIT      100000
+#define QUEUE_CLIENTS         10
+#define QUEUE_BATCH           50      // updates per batch, i.e. 500 callbacks
+#define QUEUE_BATCHES         200
+#define FORMAT_ITERATIONS     200000
+#define ARRAY_ITERATIONS      2000
+#define ARRAY_ELEMENTS        4096
+
+static const char* const scalarPvNames [] = {
+   "BENCH:DOUBLE", "BENCH:FLOAT", "BENCH:LONG", "BENCH:STRING"
+};
+static const ACAI::ClientFieldType scalarPvTypes [] = {
+   ACAI::ClientFieldDOUBLE, ACAI::ClientFieldFLOAT, ACAI::ClientFieldLONG,
+   ACAI::ClientFieldSTRING
+};
+static const int numberScalarPvs = int (sizeof (scalarPvNames) / sizeof (scalarPvNames [0]));
+static const char* const arrayPvName = "BENCH:ARRAY";
+
+typedef std::vector<ACAI::Client*> Client_Lists;
+
+//==============================================================================
+// Counts data updates.
+//
+class Counting_User : public ACAI::Abstract_Client_User {
+public:
+   explicit Counting_User () : ACAI::Abstract_Client_User (), count (0) { }
+   ~Counting_User () { }
+   unsigned long count;
+
+protected:
+   void dataUpdate (ACAI::Client*, const bool) { this->count++; }
+};
+
+//------------------------------------------------------------------------------
+// Monotonic time in seconds.
+//
+static double now ()
+{
+   return double (epicsMonotonicGet ()) * 1.0e-9;
+}
+
+//------------------------------------------------------------------------------
+// Outputs a result line. Extra is either empty or a list of additional
+// comma separated "name":value pairs.
+//
+static void result (const char* name, const double operations,
+                    const double seconds, const ACAI::ClientString& extra = "")
+{
+   const double rate = seconds > 0.0 ? operations / seconds : 0.0;
+   const double each = operations > 0.0 ? 1.0e9 * seconds / operations : 0.0;
+
+   std::cout << ACAI::csnprintf (400,
+                                 "{\"benchmark\":\"%s\",\"operations\":%.0f,"
+                                 "\"seconds\":%.6f,\"rate\":%.1f,\"ns_per_op\":%.1f%s%s}",
+                                 name, operations, seconds, rate, each,
+                                 extra.empty () ? "" : ",", extra.c_str ())
+             << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// Outputs a skipped benchmark line.
+//
+static void skipped (const char* name, const char* reason)
+{
+   std::cout << "{\"benchmark\":\"" << name << "\",\"skipped\":\""
+             << reason << "\"}" << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// Queue throughput. Updates are posted by the simulated backend to a number of
+// clients subscribed to the same PV, so this measures the buffered callback
+// queue, i.e. allocation, copy, locking and dispatch, independently of any IOC.
+// The enqueue time also includes the simulated backend's own overhead. Updates
+// are posted in batches small enough to avoid queue coalescing.
+//
+static void queueThroughput ()
+{
+   static const char* pvName = "BENCH:QUEUE";
+
+   ACAI::Simulation::definePv (pvName, ACAI::ClientFieldDOUBLE);
+
+   Counting_User user;
+   Client_Lists clients;
+   for (int j = 0; j < QUEUE_CLIENTS; j++) {
+      ACAI::Client* client = new ACAI::Client (pvName);
+      user.registerClient (client);
+      client->openChannel ();
+      clients.push_back (client);
+   }
+   for (int j = 0; j < 5; j++) {
+      ACAI::Client::poll ();
+   }
+
+   user.count = 0;
+   ACAI::Client::resetStatistics ();
+
+   double enqueueTime = 0.0;
+   double dispatchTime = 0.0;
+   for (int b = 0; b < QUEUE_BATCHES; b++) {
+      const double start = now ();
+      for (int j = 0; j < QUEUE_BATCH; j++) {
+         ACAI::Simulation::postUpdate (pvName);
+      }
+      const double middle = now ();
+      ACAI::Client::poll (QUEUE_BATCH * QUEUE_CLIENTS);
+      const double finish = now ();
+
+      enqueueTime += middle - start;
+      dispatchTime += finish - middle;
+   }
+
+   ACAI::Client_Statistics statistics;
+   ACAI::Client::getStatistics (statistics);
+
+   const double callbacks = double (QUEUE_BATCHES) * QUEUE_BATCH * QUEUE_CLIENTS;
+   result ("queue_enqueue", callbacks, enqueueTime,
+           ACAI::csnprintf (80, "\"queue_high_water_mark\":%lu",
+                            (unsigned long) statistics.queueHighWaterMark));
+   result ("queue_dispatch", callbacks, dispatchTime,
+           ACAI::csnprintf (80, "\"updates\":%lu,\"coalesced\":%lu", user.count,
+                            (unsigned long) statistics.coalescedCount));
+
+   for (int j = 0; j < QUEUE_CLIENTS; j++) {
+      clients [j]->closeChannel ();
+      delete clients [j];
+   }
+   ACAI::Client::poll ();
+   ACAI::Simulation::removeAllPvs ();
+}
+
+//------------------------------------------------------------------------------
+// Client_Set insert, contains, topClients and remove operations.
+//
+static void clientSetOperations (const int number)
+{
+   Client_Lists clients;
+   for (int j = 0; j < number; j++) {
+      clients.push_back (new ACAI::Client (ACAI::csnprintf (40, "BENCH:PV:%06d", j)));
+   }
+
+   ACAI::Client_Set set;
+   double start = now ();
+   for (int j = 0; j < number; j++) {
+      set.insert (clients [j]);
+   }
+   result ("client_set_insert", number, now () - start);
+
+   int found = 0;
+   start = now ();
+   for (int r = 0; r < 10; r++) {
+      for (int j = 0; j < number; j++) {
+         if (set.contains (clients [j])) found++;
+      }
+   }
+   result ("client_set_contains", 10.0 * number, now () - start,
+           ACAI::csnprintf (80, "\"found\":%d", found));
+
+   start = now ();
+   for (int r = 0; r < 100; r++) {
+      set.topClients (10, ACAI::RankByUpdatesReceived);
+   }
+   result ("client_set_top_clients", 100.0, now () - start,
+           ACAI::csnprintf (80, "\"set_size\":%d", number));
+
+   start = now ();
+   for (int j = 0; j < number; j++) {
+      set.remove (clients [j]);
+   }
+   result ("client_set_remove", number, now () - start);
+
+   for (int j = 0; j < number; j++) {
+      delete clients [j];
+   }
+}
+
+//------------------------------------------------------------------------------
+// Connection storm, i.e. the time taken to connect and receive the first
+// update for all clients, with and without a connection budget. The simulated
+// PVs connect immediately, so this measures the client side connection
+// processing. Poll is called back to back, i.e. without any sleep.
+//
+static bool connectStorm (ACAI::Client_Set* set, const int number, const int budget)
+{
+   ACAI::Client::setConnectionBudget (budget);
+   ACAI::Client::resetStatistics ();
+
+   const double start = now ();
+   set->openAllChannels ();
+   int polls = 0;
+   while (!set->areAllChannelsReady () && (polls < STORM_POLL_LIMIT)) {
+      ACAI::Client::poll ();
+      polls++;
+   }
+   const bool ok = set->areAllChannelsReady ();
+   const double finish = now ();
+
+   ACAI::Client_Statistics statistics;
+   ACAI::Client::getStatistics (statistics);
+
+   result (budget > 0 ? "connect_storm_budget" : "connect_storm", number, finish - start,
+           ACAI::csnprintf (200, "\"budget\":%d,\"all_ready\":%s,\"polls\":%d,"
+                            "\"max_poll_us\":%.1f,\"queue_high_water_mark\":%lu",
+                            budget, ok ? "true" : "false", polls,
+                            statistics.maximumPollDuration * 1.0e6,
+                            (unsigned long) statistics.queueHighWaterMark));
+
+   ACAI::Client::setConnectionBudget (0);
+   return ok;
+}
+
+//------------------------------------------------------------------------------
+// Dispatch latency through callDataUpdate with the given number of registered
+// users per client. Each cycle advances simulated time, generating one update
+// per PV, and then polls. Only the poll time is measured.
+//
+static void dispatchLatency (ACAI::Client_Set* set, const int users)
+{
+   std::vector<Counting_User*> userList;
+   for (int u = 0; u < users; u++) {
+      Counting_User* user = new Counting_User ();
+      user->registerAllClients (set);
+      userList.push_back (user);
+   }
+
+   for (int j = 0; j < numberScalarPvs; j++) {
+      ACAI::Simulation::setUpdateRate (scalarPvNames [j], DISPATCH_RATE);
+   }
+
+   ACAI::Client::resetStatistics ();
+   const size_t postedBefore = ACAI::Simulation::updatesPosted ();
+
+   double seconds = 0.0;
+   for (int c = 0; c < DISPATCH_CYCLES; c++) {
+      ACAI::Simulation::advance (DISPATCH_INTERVAL);
+      const double start = now ();
+      ACAI::Client::poll (set->count () + 1);
+      seconds += now () - start;
+   }
+
+   for (int j = 0; j < numberScalarPvs; j++) {
+      ACAI::Simulation::setUpdateRate (scalarPvNames [j], 0.0);
+   }
+   const size_t posted = ACAI::Simulation::updatesPosted () - postedBefore;
+
+   ACAI::Client_Statistics statistics;
+   ACAI::Client::getStatistics (statistics);
+   const ACAI::Latency_Histogram& duration = ACAI::globalHandlerDurationHistogram ();
+   const ACAI::Latency_Histogram& latency = ACAI::globalQueueLatencyHistogram ();
+
+   unsigned long notified = 0;
+   for (int u = 0; u < users; u++) {
+      notified += userList [u]->count;
+      delete userList [u];
+   }
+
+   result ("dispatch", double (statistics.dequeueCount), seconds,
+           ACAI::csnprintf (400, "\"users\":%d,\"updates\":%lu,\"notifications\":%lu,"
+                            "\"handler_p50_us\":%.2f,\"handler_p99_us\":%.2f,"
+                            "\"handler_max_us\":%.2f,\"queue_p50_us\":%.2f,"
+                            "\"queue_p99_us\":%.2f,\"coalesced\":%lu",
+                            users, (unsigned long) posted, notified,
+                            duration.percentile (50.0) * 1.0e6,
+                            duration.percentile (99.0) * 1.0e6,
+                            duration.maximum () * 1.0e6,
+                            latency.percentile (50.0) * 1.0e6,
+                            latency.percentile (99.0) * 1.0e6,
+                            (unsigned long) statistics.coalescedCount));
+}
+
+//------------------------------------------------------------------------------
+// getString formatting, with and without units.
+//
+static void stringFormatting (ACAI::Client* client)
+{
+   size_t total = 0;
+
+   client->setIncludeUnits (false);
+   double start = now ();
+   for (int j = 0; j < FORMAT_ITERATIONS; j++) {
+      total += client->getString ().size ();
+   }
+   result ("get_string", FORMAT_ITERATIONS, now () - start,
+           ACAI::csnprintf (80, "\"characters\":%lu", (unsigned long) total));
+
+   client->setIncludeUnits (true);
+   start = now ();
+   for (int j = 0; j < FORMAT_ITERATIONS; j++) {
+      total += client->getString ().size ();
+   }
+   result ("get_string_units", FORMAT_ITERATIONS, now () - start);
+   client->setIncludeUnits (false);
+}
+
+//------------------------------------------------------------------------------
+// Array conversions.
+//
+static void arrayConversions (ACAI::Client* client)
+{
+   const unsigned int count = client->dataElementCount ();
+   double sum = 0.0;
+
+   double start = now ();
+   for (int j = 0; j < ARRAY_ITERATIONS; j++) {
+      ACAI::ClientFloatingArray data = client->getFloatingArray ();
+      if (!data.empty ()) sum += data [0];
+   }
+   result ("get_floating_array", ARRAY_ITERATIONS, now () - start,
+           ACAI::csnprintf (80, "\"elements\":%u", count));
+
+   start = now ();
+   for (int j = 0; j < ARRAY_ITERATIONS; j++) {
+      ACAI::ClientIntegerArray data = client->getIntegerArray ();
+      if (!data.empty ()) sum += data [0];
+   }
+   result ("get_integer_array", ARRAY_ITERATIONS, now () - start,
+           ACAI::csnprintf (80, "\"elements\":%u,\"checksum\":%.1f", count, sum));
+}
+
+
+//==============================================================================
+//
+int main (int argc, char* argv []) {
+   int number = 1000;
+   if (argc >= 2) {
+      number = atoi (argv [1]);
+      if (number < 1) number = 1;
+   }
+
+   int users = 4;
+   if (argc >= 3) {
+      users = atoi (argv [2]);
+      if (users < 0) users = 0;
+   }
+
+   std::cout << "{\"version\":\"" << ACAI_VERSION_STRING << "\",\"clients\":"
+             << number << ",\"users\":" << users << "}" << std::endl;
+
+   ACAI::Simulation::enable ();
+   ACAI::Client::initialise ();
+
+   queueThroughput ();
+   clientSetOperations (number);
+
+   // Client benchmarks.
+   //
+   for (int j = 0; j < numberScalarPvs; j++) {
+      ACAI::Simulation::definePv (scalarPvNames [j], scalarPvTypes [j]);
+   }
+   ACAI::Simulation::definePv (arrayPvName, ACAI::ClientFieldDOUBLE, ARRAY_ELEMENTS);
+
+   ACAI::Client_Set* set = new ACAI::Client_Set (true);   // deep destruction
+   ACAI::Client* scalar = NULL;
+   for (int j = 0; j < number; j++) {
+      ACAI::Client* client = new ACAI::Client (scalarPvNames [j % numberScalarPvs]);
+      if (!scalar) scalar = client;
+      set->insert (client);
+   }
+
+   bool ok = connectStorm (set, number, 0);
+   if (ok) {
+      set->closeAllChannels ();
+      ACAI::Client::poll ();
+      ok = connectStorm (set, number, 50);
+   }
+
+   if (ok) {
+      dispatchLatency (set, users);
+      stringFormatting (scalar);
+   } else {
+      skipped ("dispatch", "clients not connected");
+   }
+
+   set->closeAllChannels ();
+   ACAI::Client::poll ();
+   delete set;
+
+   ACAI::Client* array = new ACAI::Client (arrayPvName);
+   array->openChannel ();
+   for (int j = 0; j < 5; j++) {
+      ACAI::Client::poll ();
+   }
+   if (array->dataElementCount () == ARRAY_ELEMENTS) {
+      arrayConversions (array);
+   } else {
+      skipped ("get_floating_array", "array not connected");
+   }
+   array->closeChannel ();
+   delete array;
+
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+   ACAI::Simulation::disable ();
+   return 0;
+}
+
+// end
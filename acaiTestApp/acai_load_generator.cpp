@@ -0,0 +1,442 @@
+// acai_load_generator.cpp
+//
+// Load generator for ACAI soak and scaling tests. Creates a configurable number
+// of clients and users, optionally drives a put load, and periodically reports
+// the dispatch latency percentiles, memory use, callback queue depth and CPU
+// time per update. Each report is written to standard output as a JSON line,
+// so that the behaviour over time may be plotted.
+//
+// The clients are spread over the given PVs, which default to T1 .. T4, and
+// are expected to be served by a local soft IOC. Alternatively, the simulated
+// backend may be used, in which case no IOC is required and the update load
+// is specified by the number of simulated PVs and their update rate.
+//
+// Use acai_load_generator -h for usage.
+//
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#if !defined (_WIN32)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_client_set.h>
+#include <acai_abstract_client_user.h>
+#include <acai_simulation.h>
+#include <acai_statistics.h>
+#include <acai_version.h>
+#include <epicsTime.h>
+#include <epicsThread.h>
+
+#define POLL_PERIOD    0.01     // seconds
+
+#define MAX(a, b)      ((a) >= (b) ? (a) : (b))
+
+// Configuration, with defaults.
+//
+static int numberOfClients = 1000;
+static int numberOfUsers = 2;
+static double putRate = 0.0;            // puts/second, over all clients
+static double duration = 60.0;          // seconds
+static double reportInterval = 5.0;     // seconds
+static int pollMaximum = 100000;
+static int simulatedPvs = 0;            // 0 => use channel access
+static double simulatedRate = 10.0;     // updates/second per simulated PV
+static int simulatedElements = 1;
+
+//==============================================================================
+// Counts data updates.
+//
+class Counting_User : public ACAI::Abstract_Client_User {
+public:
+   explicit Counting_User () : ACAI::Abstract_Client_User (), count (0) { }
+   ~Counting_User () { }
+   unsigned long count;
+
+protected:
+   void dataUpdate (ACAI::Client*, const bool) { this->count++; }
+};
+
+//------------------------------------------------------------------------------
+// Monotonic time in seconds.
+//
+static double now ()
+{
+   return double (epicsMonotonicGet ()) * 1.0e-9;
+}
+
+//------------------------------------------------------------------------------
+// Process CPU time, user plus system, in seconds, or 0.0 if unavailable.
+//
+static double cpuTime ()
+{
+#if !defined (_WIN32)
+   struct rusage usage;
+   if (getrusage (RUSAGE_SELF, &usage) == 0) {
+      return double (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+             double (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1.0e-6;
+   }
+#endif
+   return 0.0;
+}
+
+//------------------------------------------------------------------------------
+// Resident memory in Mbytes, or 0.0 if unavailable. Where the current resident
+// size is not available, the maximum resident size is used instead.
+//
+static double residentMemory ()
+{
+#if defined (__linux__)
+   FILE* statm = fopen ("/proc/self/statm", "r");
+   if (statm) {
+      unsigned long size = 0;
+      unsigned long resident = 0;
+      const int n = fscanf (statm, "%lu %lu", &size, &resident);
+      fclose (statm);
+      if (n == 2) {
+         return double (resident) * double (sysconf (_SC_PAGESIZE)) / 1048576.0;
+      }
+   }
+#endif
+
+#if !defined (_WIN32)
+   struct rusage usage;
+   if (getrusage (RUSAGE_SELF, &usage) == 0) {
+#if defined (__APPLE__)
+      return double (usage.ru_maxrss) / 1048576.0;    // bytes
+#else
+      return double (usage.ru_maxrss) / 1024.0;       // kilo bytes
+#endif
+   }
+#endif
+   return 0.0;
+}
+
+//------------------------------------------------------------------------------
+// Output help information.
+//
+static void help ()
+{
+   std::cout
+         << "acai_load_generator creates a configurable load for ACAI soak and scaling" << std::endl
+         << "tests, and periodically reports latency, memory, queue and CPU statistics" << std::endl
+         << "as JSON lines." << std::endl
+         << "" << std::endl
+         << "usage: acai_load_generator [OPTIONS] [PV_NAMES...]" << std::endl
+         << "       acai_load_generator -h | --help" << std::endl
+         << "" << std::endl
+         << "The clients are spread over the PV names, which default to T1 .. T4." << std::endl
+         << "" << std::endl
+         << "Options:" << std::endl
+         << "" << std::endl
+         << "-c,--clients n    number of clients, default 1000." << std::endl
+         << "" << std::endl
+         << "-u,--users n      number of users, each registered with all clients, default 2." << std::endl
+         << "" << std::endl
+         << "-p,--puts rate    total puts per second, spread over all clients, default 0." << std::endl
+         << "" << std::endl
+         << "-d,--duration s   run duration in seconds, default 60." << std::endl
+         << "" << std::endl
+         << "-i,--interval s   report interval in seconds, default 5." << std::endl
+         << "" << std::endl
+         << "-m,--maximum n    maximum callbacks processed per poll, default 100000." << std::endl
+         << "" << std::endl
+         << "-s,--simulate n   use the simulated backend with n simulated PVs, named" << std::endl
+         << "                  LOAD:0 .. LOAD:n-1, instead of channel access. Any PV" << std::endl
+         << "                  names are ignored." << std::endl
+         << "" << std::endl
+         << "-r,--rate r       simulated updates per second per PV, default 10." << std::endl
+         << "" << std::endl
+         << "-e,--elements n   simulated PV element count, default 1." << std::endl
+         << "" << std::endl
+         << "-h,--help         show this help message and exit." << std::endl
+         << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// Reports one interval. The updates are the data updates received, including
+// any subsequently coalesced, and the dispatched callbacks are all callbacks
+// dequeued, i.e. also including connection and printf callbacks.
+//
+static void report (const double elapsed, const double interval,
+                    const size_t updates, const size_t dispatched,
+                    const unsigned long notifications,
+                    const unsigned long puts, const double cpu,
+                    const ACAI::Client_Statistics& statistics)
+{
+   const ACAI::Latency_Histogram& latency = ACAI::globalQueueLatencyHistogram ();
+   const ACAI::Latency_Histogram& duration = ACAI::globalHandlerDurationHistogram ();
+
+   const double rate = interval > 0.0 ? double (updates) / interval : 0.0;
+   const double cpuPerUpdate = updates > 0 ? 1.0e6 * cpu / double (updates) : 0.0;
+
+   std::cout << ACAI::csnprintf (800,
+                                 "{\"time\":%.1f,\"updates\":%lu,\"update_rate\":%.1f,"
+                                 "\"dispatched\":%lu,\"notifications\":%lu,\"puts\":%lu,"
+                                 "\"latency_p50_us\":%.2f,\"latency_p99_us\":%.2f,"
+                                 "\"latency_p999_us\":%.2f,\"latency_max_us\":%.2f,"
+                                 "\"handler_p99_us\":%.2f,\"queue_length\":%lu,"
+                                 "\"queue_high_water\":%lu,\"coalesced\":%lu,"
+                                 "\"allocation_failures\":%lu,\"open_channels\":%d,"
+                                 "\"resident_mb\":%.1f,\"cpu_us_per_update\":%.3f,"
+                                 "\"cpu_percent\":%.1f}",
+                                 elapsed, (unsigned long) updates, rate,
+                                 (unsigned long) dispatched, notifications, puts,
+                                 latency.percentile (50.0) * 1.0e6,
+                                 latency.percentile (99.0) * 1.0e6,
+                                 latency.percentile (99.9) * 1.0e6,
+                                 latency.maximum () * 1.0e6,
+                                 duration.percentile (99.0) * 1.0e6,
+                                 (unsigned long) statistics.queueLength,
+                                 (unsigned long) statistics.queueHighWaterMark,
+                                 (unsigned long) statistics.coalescedCount,
+                                 (unsigned long) statistics.allocationFailures,
+                                 statistics.openChannels,
+                                 residentMemory (), cpuPerUpdate,
+                                 interval > 0.0 ? 100.0 * cpu / interval : 0.0)
+             << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// Parses a numeric option value. Returns false if missing.
+//
+static bool optionValue (int& argc, char**& argv, double& value)
+{
+   if (argc < 3) {
+      std::cerr << "acai_load_generator: missing value for option " << argv[1] << std::endl;
+      return false;
+   }
+   value = atof (argv[2]);
+   argc -= 2;
+   argv += 2;
+   return true;
+}
+
+
+//==============================================================================
+//
+int main (int argc, char* argv [])
+{
+   // Process options
+   //
+   while (argc >= 2) {
+      char* p1 = argv[1];
+      double value;
+
+      if ((strcmp (p1, "--help") == 0) || (strcmp (p1, "-h") == 0)) {
+         help ();
+         return 0;
+
+      } else if ((strcmp (p1, "--clients") == 0) || (strcmp (p1, "-c") == 0)) {
+         if (!optionValue (argc, argv, value)) return 1;
+         numberOfClients = MAX (int (value), 1);
+
+      } else if ((strcmp (p1, "--users") == 0) || (strcmp (p1, "-u") == 0)) {
+         if (!optionValue (argc, argv, value)) return 1;
+         numberOfUsers = MAX (int (value), 0);
+
+      } else if ((strcmp (p1, "--puts") == 0) || (strcmp (p1, "-p") == 0)) {
+         if (!optionValue (argc, argv, value)) return 1;
+         putRate = MAX (value, 0.0);
+
+      } else if ((strcmp (p1, "--duration") == 0) || (strcmp (p1, "-d") == 0)) {
+         if (!optionValue (argc, argv, value)) return 1;
+         duration = MAX (value, 0.0);
+
+      } else if ((strcmp (p1, "--interval") == 0) || (strcmp (p1, "-i") == 0)) {
+         if (!optionValue (argc, argv, value)) return 1;
+         reportInterval = MAX (value, 0.1);
+
+      } else if ((strcmp (p1, "--maximum") == 0) || (strcmp (p1, "-m") == 0)) {
+         if (!optionValue (argc, argv, value)) return 1;
+         pollMaximum = MAX (int (value), 1);
+
+      } else if ((strcmp (p1, "--simulate") == 0) || (strcmp (p1, "-s") == 0)) {
+         if (!optionValue (argc, argv, value)) return 1;
+         simulatedPvs = MAX (int (value), 1);
+
+      } else if ((strcmp (p1, "--rate") == 0) || (strcmp (p1, "-r") == 0)) {
+         if (!optionValue (argc, argv, value)) return 1;
+         simulatedRate = MAX (value, 0.0);
+
+      } else if ((strcmp (p1, "--elements") == 0) || (strcmp (p1, "-e") == 0)) {
+         if (!optionValue (argc, argv, value)) return 1;
+         simulatedElements = MAX (int (value), 1);
+
+      } else if (p1[0] == '-') {
+         std::cerr << "acai_load_generator: error: no such option: " << p1 << std::endl;
+         return 1;
+
+      } else {
+         // not an option, so must be 1st PV name
+         //
+         break;
+      }
+   }
+
+   std::vector<ACAI::ClientString> pvNames;
+   if (simulatedPvs > 0) {
+      if (!ACAI::Simulation::enable ()) {
+         std::cerr << "acai_load_generator: cannot enable simulation" << std::endl;
+         return 2;
+      }
+      for (int j = 0; j < simulatedPvs; j++) {
+         const ACAI::ClientString name = ACAI::csnprintf (40, "LOAD:%d", j);
+         ACAI::Simulation::definePv (name, ACAI::ClientFieldDOUBLE,
+                                     simulatedElements, simulatedRate);
+         pvNames.push_back (name);
+      }
+   } else {
+      for (int j = 1; j < argc; j++) {
+         pvNames.push_back (argv [j]);
+      }
+      if (pvNames.empty ()) {
+         pvNames.push_back ("T1");
+         pvNames.push_back ("T2");
+         pvNames.push_back ("T3");
+         pvNames.push_back ("T4");
+      }
+   }
+
+   std::cout << ACAI::csnprintf (400,
+                                 "{\"version\":\"%s\",\"backend\":\"%s\",\"clients\":%d,"
+                                 "\"users\":%d,\"pvs\":%d,\"put_rate\":%.1f}",
+                                 ACAI_VERSION_STRING,
+                                 simulatedPvs > 0 ? "simulation" : "channel access",
+                                 numberOfClients, numberOfUsers,
+                                 int (pvNames.size ()), putRate)
+             << std::endl;
+
+   if (!ACAI::Client::initialise ()) {
+      std::cerr << "ACAI::Client::initialise failed." <<  std::endl;
+      return 2;
+   }
+
+   const double setupStart = now ();
+
+   ACAI::Client_Set* set = new ACAI::Client_Set (true);   // deep destruction
+   std::vector<ACAI::Client*> clients;
+   for (int j = 0; j < numberOfClients; j++) {
+      ACAI::Client* client = new ACAI::Client (pvNames [j % pvNames.size ()]);
+      clients.push_back (client);
+      set->insert (client);
+   }
+
+   std::vector<Counting_User*> users;
+   for (int u = 0; u < numberOfUsers; u++) {
+      Counting_User* user = new Counting_User ();
+      user->registerAllClients (set);
+      users.push_back (user);
+   }
+
+   set->openAllChannels ();
+   const bool ready = set->waitAllChannelsReady (30.0, POLL_PERIOD);
+   std::cout << ACAI::csnprintf (200, "{\"setup_seconds\":%.3f,\"all_ready\":%s,"
+                                 "\"resident_mb\":%.1f}",
+                                 now () - setupStart, ready ? "true" : "false",
+                                 residentMemory ())
+             << std::endl;
+
+   if (simulatedPvs > 0) ACAI::Simulation::startThread (POLL_PERIOD);
+
+   ACAI::Client::resetStatistics ();
+
+   const double start = now ();
+   double lastReport = start;
+   double lastCpu = cpuTime ();
+   size_t lastDequeued = 0;
+   size_t lastUpdates = 0;
+   const size_t postedStart = simulatedPvs > 0 ? ACAI::Simulation::updatesPosted () : 0;
+   unsigned long lastNotified = 0;
+   unsigned long puts = 0;
+   unsigned long lastPuts = 0;
+   double putCredit = 0.0;
+   size_t nextPutClient = 0;
+
+   for (;;) {
+      epicsThreadSleep (POLL_PERIOD);
+      ACAI::Client::poll (pollMaximum);
+
+      const double time = now ();
+
+      // Puts, spread round robin over all clients.
+      //
+      if (putRate > 0.0) {
+         putCredit += putRate * POLL_PERIOD;
+         while (putCredit >= 1.0) {
+            ACAI::Client* client = clients [nextPutClient];
+            nextPutClient = (nextPutClient + 1) % clients.size ();
+            if (client->isConnected ()) {
+               client->putFloating (double (puts % 1000));
+               puts++;
+            }
+            putCredit -= 1.0;
+         }
+         ACAI::Client::flush ();
+      }
+
+      if (time - lastReport >= reportInterval || time - start >= duration) {
+         ACAI::Client_Statistics statistics;
+         ACAI::Client::getStatistics (statistics);
+
+         unsigned long notified = 0;
+         for (size_t u = 0; u < users.size (); u++) {
+            notified += users [u]->count;
+         }
+
+         // With the simulated backend, the updates are known exactly. Note: the
+         // event callback count is noted on enqueue, and so already includes
+         // any coalesced updates.
+         //
+         const size_t updates = simulatedPvs > 0
+                              ? ACAI::Simulation::updatesPosted () - postedStart
+                              : statistics.eventCallbackCount;
+
+         const double cpu = cpuTime ();
+         report (time - start, time - lastReport,
+                 updates - lastUpdates,
+                 statistics.dequeueCount - lastDequeued,
+                 notified - lastNotified, puts - lastPuts,
+                 cpu - lastCpu, statistics);
+
+         // The histograms are per interval, the statistics cumulative.
+         //
+         ACAI::globalQueueLatencyHistogram ().reset ();
+         ACAI::globalHandlerDurationHistogram ().reset ();
+
+         lastReport = time;
+         lastCpu = cpu;
+         lastDequeued = statistics.dequeueCount;
+         lastUpdates = updates;
+         lastNotified = notified;
+         lastPuts = puts;
+      }
+
+      if (time - start >= duration) break;
+   }
+
+   if (simulatedPvs > 0) ACAI::Simulation::stopThread ();
+
+   for (size_t u = 0; u < users.size (); u++) {
+      delete users [u];
+   }
+
+   set->closeAllChannels ();
+   ACAI::Client::poll ();
+   delete set;
+
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+
+   if (simulatedPvs > 0) ACAI::Simulation::disable ();
+   return 0;
+}
+
+// end
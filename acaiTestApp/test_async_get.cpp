@@ -0,0 +1,128 @@
+// test_async_get.cpp
+//
+// Exercises getAsync against the in-process simulated backend. Checks that
+// each token holds its own copy of the payload, unaffected by subsequent
+// channel updates, and that the copy remains valid after the channel is
+// closed and after the client is deleted. No IOC is required.
+// See test_async_get.out.
+//
+
+#include <iostream>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_client_completion.h>
+#include <acai_simulation.h>
+#include <acai_version.h>
+
+#define SCALAR_PV   "SIM:ASYNC:SCALAR"
+#define ARRAY_PV    "SIM:ASYNC:ARRAY"
+#define STRING_PV   "SIM:ASYNC:STRING"
+
+//------------------------------------------------------------------------------
+//
+static void settle ()
+{
+   for (int j = 0; j < 5; j++) {
+      ACAI::Client::poll ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+static void report (const char* title, ACAI::Client_Get_Completion* token)
+{
+   std::cout << "  " << title << ": "
+             << ACAI::Client_Completion::stateImage (token->state ())
+             << ", type " << int (token->dataFieldType ())
+             << ", count " << token->dataElementCount ()
+             << ", severity " << int (token->alarmSeverity ())
+             << ", values";
+   for (unsigned int j = 0; j < token->dataElementCount (); j++) {
+      std::cout << " " << token->getString (j);
+   }
+   std::cout << "\n";
+}
+
+
+//==============================================================================
+//
+int main () {
+   std::cout << "test async get starting (" << ACAI_VERSION_STRING << ")\n\n";
+
+   ACAI::Simulation::enable ();
+   ACAI::Simulation::definePv (SCALAR_PV, ACAI::ClientFieldDOUBLE);
+   ACAI::Simulation::definePv (ARRAY_PV, ACAI::ClientFieldLONG, 4);
+   ACAI::Simulation::definePv (STRING_PV, ACAI::ClientFieldSTRING);
+
+   ACAI::Client::initialise ();
+
+   ACAI::Client* scalar = new ACAI::Client (SCALAR_PV);
+   ACAI::Client* array = new ACAI::Client (ARRAY_PV);
+   ACAI::Client* text = new ACAI::Client (STRING_PV);
+   scalar->openChannel ();
+   array->openChannel ();
+   text->openChannel ();
+   settle ();
+
+   std::cout << "payload copy\n";
+   ACAI::Simulation::setAlarm (SCALAR_PV, ACAI::ClientSevMajor, ACAI::ClientAlarmHiHi);
+   ACAI::Client_Get_Completion* scalarToken = scalar->getAsync ();
+   ACAI::Client_Get_Completion* arrayToken = array->getAsync (5.0, 2);
+   ACAI::Client_Get_Completion* textToken = text->getAsync ();
+   report ("before poll", scalarToken);
+   settle ();
+   report ("scalar", scalarToken);
+   report ("array", arrayToken);
+   report ("string", textToken);
+
+   // Subsequent updates change the client's value, but not the tokens'.
+   //
+   ACAI::Simulation::setAlarm (SCALAR_PV, ACAI::ClientSevNone, ACAI::ClientAlarmNone);
+   ACAI::Simulation::postUpdate (SCALAR_PV);
+   ACAI::Simulation::postUpdate (ARRAY_PV);
+   ACAI::Simulation::postUpdate (STRING_PV);
+   settle ();
+   std::cout << "  client values: " << scalar->getFloating ()
+             << " " << array->getInteger (0) << " " << text->getString () << "\n";
+   report ("scalar after updates", scalarToken);
+   report ("array after updates", arrayToken);
+   report ("string after updates", textToken);
+   std::cout << "\n";
+
+   std::cout << "channel closed\n";
+   array->closeChannel ();
+   report ("array", arrayToken);
+   std::cout << "\n";
+
+   std::cout << "client deleted\n";
+   delete scalar;
+   delete text;
+   report ("scalar", scalarToken);
+   report ("string", textToken);
+   delete scalarToken;
+   delete arrayToken;
+   delete textToken;
+   std::cout << "\n";
+
+   // A get still pending when the channel is closed is cancelled, and has no
+   // payload.
+   //
+   std::cout << "pending get\n";
+   array->openChannel ();
+   settle ();
+   arrayToken = array->getAsync ();
+   array->closeChannel ();
+   report ("channel closed", arrayToken);
+   std::cout << "  raw dbr: " << (arrayToken->rawDbr () ? "yes" : "no") << "\n";
+   delete arrayToken;
+   delete array;
+
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+   ACAI::Simulation::disable ();
+
+   std::cout << "\ntest async get complete\n";
+   return 0;
+}
+
+// end
@@ -0,0 +1,134 @@
+// test_async_put.cpp
+//
+// Exercises the asynchronous put functions, and hence putDataAsync, against
+// the in-process simulated backend. Checks completion, failure, the (lazy)
+// time out and cancellation of the returned tokens. No IOC is required.
+// See test_async_put.out.
+//
+
+#include <iostream>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_client_completion.h>
+#include <acai_simulation.h>
+#include <acai_version.h>
+
+#define PV_NAME   "SIM:ASYNC:PUT"
+
+//------------------------------------------------------------------------------
+//
+static void settle ()
+{
+   for (int j = 0; j < 5; j++) {
+      ACAI::Client::poll ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+static void report (const char* title, ACAI::Client_Completion* token,
+                    ACAI::Client* client)
+{
+   std::cout << "  " << title << ": "
+             << ACAI::Client_Completion::stateImage (token->state ())
+             << ", pending " << client->pendingCompletionCount () << "\n";
+}
+
+
+//==============================================================================
+//
+int main () {
+   std::cout << "test async put starting (" << ACAI_VERSION_STRING << ")\n\n";
+
+   ACAI::Simulation::enable ();
+   ACAI::Simulation::definePv (PV_NAME, ACAI::ClientFieldDOUBLE);
+
+   ACAI::Client::initialise ();
+
+   ACAI::Client* client = new ACAI::Client (PV_NAME);
+   client->openChannel ();
+   settle ();
+
+   std::cout << "completion\n";
+   ACAI::Client_Put_Completion* token = client->putFloatingAsync (1.5);
+   std::cout << "  pending before poll: " << client->pendingCompletionCount () << "\n";
+   settle ();
+   report ("after poll", token, client);
+   std::cout << "  value " << client->getFloating () << "\n";
+   delete token;
+
+   token = client->putIntegerAsync (7);
+   std::cout << "  wait: " << (token->wait (1.0, 0.01) ? "yes" : "no") << "\n";
+   delete token;
+
+   ACAI::Client_Completion::Lists list;
+   for (int j = 0; j < 3; j++) {
+      list.push_back (client->putFloatingAsync (10.0 + j));
+   }
+   std::cout << "  wait all: "
+             << (ACAI::Client_Completion::waitAll (list, 1.0, 0.01) ? "yes" : "no") << "\n";
+   settle ();
+   std::cout << "  value " << client->getFloating () << "\n";
+   for (size_t j = 0; j < list.size (); j++) delete list [j];
+   std::cout << "\n";
+
+   std::cout << "failure\n";
+   token = client->putFloatingArrayAsync (ACAI::ClientFloatingArray ());
+   report ("empty array", token, client);
+   delete token;
+
+   ACAI::Simulation::setConnected (PV_NAME, false);
+   settle ();
+   token = client->putFloatingAsync (2.5);
+   report ("disconnected", token, client);
+   delete token;
+   ACAI::Simulation::setConnected (PV_NAME, true);
+   settle ();
+   std::cout << "\n";
+
+   // A zero time out expires immediately, but only when the state is queried.
+   //
+   std::cout << "time out\n";
+   token = client->putFloatingAsync (3.5, 0.0);
+   std::cout << "  pending before query: " << client->pendingCompletionCount () << "\n";
+   report ("queried", token, client);
+   settle ();
+   report ("after poll", token, client);
+   delete token;
+
+   token = client->putFloatingAsync (4.5, 0.0);
+   settle ();
+   report ("not queried before poll", token, client);
+   delete token;
+   std::cout << "\n";
+
+   std::cout << "cancellation\n";
+   token = client->putFloatingAsync (5.5);
+   token->cancel ();
+   report ("cancel", token, client);
+   settle ();
+   report ("after poll", token, client);
+   delete token;
+
+   token = client->putFloatingAsync (6.5);
+   client->closeChannel ();
+   report ("channel closed", token, client);
+   delete token;
+
+   client->openChannel ();
+   settle ();
+   token = client->putFloatingAsync (7.5);
+   delete client;
+   std::cout << "  client deleted: "
+             << ACAI::Client_Completion::stateImage (token->state ()) << "\n";
+   delete token;
+
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+   ACAI::Simulation::disable ();
+
+   std::cout << "\ntest async put complete\n";
+   return 0;
+}
+
+// end
@@ -0,0 +1,342 @@
+// test_binary_recorder.cpp
+//
+// Records updates from simulated PVs using ACAI::Binary_Recorder, and then
+// reads back and dumps the recording. Also checks buffer rollover into multiple
+// segments, the sync policies and the writer wait path. No IOC is required,
+// and the output excludes time stamps so is deterministic, see
+// test_binary_recorder.out.
+//
+
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_binary_recorder.h>
+#include <acai_simulation.h>
+#include <acai_version.h>
+
+#define NUMBER_OF_CLIENTS  3
+
+typedef ACAI::Binary_Recorder Recorder;
+
+static const char* filename = "test_binary_recorder.dat";
+
+//------------------------------------------------------------------------------
+//
+static void settle ()
+{
+   for (int j = 0; j < 5; j++) {
+      ACAI::Client::poll ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+static void dumpRecord (const Recorder::Record_Header& header, const char* payload)
+{
+   switch (header.kind) {
+      case Recorder::RecordDefineChannel:
+         std::cout << "  define     channel " << header.channel << ": "
+                   << ACAI::ClientString (payload, header.size) << "\n";
+         break;
+
+      case Recorder::RecordConnection:
+         std::cout << "  connection channel " << header.channel << ": "
+                   << (header.status ? "connected" : "disconnected") << "\n";
+         break;
+
+      case Recorder::RecordUpdate:
+         std::cout << "  update     channel " << header.channel << ": type "
+                   << header.fieldType << ", count " << header.count
+                   << ", size " << header.size << ":";
+
+         for (unsigned int k = 0; k < header.count; k++) {
+            switch (header.fieldType) {
+               case ACAI::ClientFieldSTRING:
+                  std::cout << " " << ACAI::limitedAssign (payload + 40 * k, 40);
+                  break;
+               case ACAI::ClientFieldLONG:
+                  {
+                     epicsInt32 value;
+                     memcpy (&value, payload + 4 * k, 4);
+                     std::cout << " " << value;
+                  }
+                  break;
+               case ACAI::ClientFieldDOUBLE:
+                  {
+                     double value;
+                     memcpy (&value, payload + 8 * k, 8);
+                     std::cout << " " << value;
+                  }
+                  break;
+               default:
+                  std::cout << " ?";
+                  break;
+            }
+         }
+         std::cout << "\n";
+         break;
+
+      default:
+         std::cout << "  unexpected record kind " << header.kind << "\n";
+         break;
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+static void dumpFile ()
+{
+   FILE* file = fopen (filename, "rb");
+   if (!file) {
+      std::cout << "cannot open " << filename << "\n";
+      return;
+   }
+
+   Recorder::File_Header fileHeader;
+   if ((fread (&fileHeader, sizeof (fileHeader), 1, file) != 1) ||
+       (fileHeader.magic != Recorder::FileMagic)) {
+      std::cout << "bad file header\n";
+      fclose (file);
+      return;
+   }
+   std::cout << "file header: version " << fileHeader.version << ", byte order "
+             << (fileHeader.byteOrder == 0x0102 ? "okay" : "swapped") << "\n";
+
+   Recorder::Segment_Header segmentHeader;
+   while (fread (&segmentHeader, sizeof (segmentHeader), 1, file) == 1) {
+      if (segmentHeader.magic != Recorder::SegmentMagic) {
+         std::cout << "bad segment header\n";
+         break;
+      }
+      std::cout << "segment " << segmentHeader.sequence << ": "
+                << segmentHeader.records << " records, "
+                << segmentHeader.size << " bytes\n";
+
+      std::vector<char> records (segmentHeader.size);
+      if (segmentHeader.size > 0 &&
+          fread (&records [0], segmentHeader.size, 1, file) != 1) {
+         std::cout << "truncated segment\n";
+         break;
+      }
+
+      size_t offset = 0;
+      for (epicsUInt32 r = 0; r < segmentHeader.records; r++) {
+         Recorder::Record_Header header;
+         memcpy (&header, &records [offset], sizeof (header));
+         dumpRecord (header, &records [offset + sizeof (header)]);
+         offset += (sizeof (header) + header.size + 7) & ~size_t (7);
+      }
+   }
+   fclose (file);
+}
+
+
+//------------------------------------------------------------------------------
+//
+static void reportStatistics (const Recorder* recorder)
+{
+   std::cout << "records written:  " << recorder->recordsWritten () << "\n";
+   std::cout << "segments written: " << recorder->segmentsWritten () << "\n";
+   std::cout << "bytes written:    " << recorder->bytesWritten () << "\n";
+   std::cout << "write failures:   " << recorder->writeFailures () << "\n";
+}
+
+//------------------------------------------------------------------------------
+// Reads back the file, optionally listing each segment, and checks that the
+// first element of successive (double) updates increases by one.
+//
+static void scanFile (const bool listSegments)
+{
+   FILE* file = fopen (filename, "rb");
+   if (!file) {
+      std::cout << "cannot open " << filename << "\n";
+      return;
+   }
+
+   Recorder::File_Header fileHeader;
+   if (fread (&fileHeader, sizeof (fileHeader), 1, file) != 1) {
+      std::cout << "bad file header\n";
+      fclose (file);
+      return;
+   }
+
+   int segments = 0;
+   size_t records = 0;
+   bool consecutive = true;
+   bool havePrevious = false;
+   double previous = 0.0;
+
+   Recorder::Segment_Header segmentHeader;
+   while (fread (&segmentHeader, sizeof (segmentHeader), 1, file) == 1) {
+      std::vector<char> data (segmentHeader.size);
+      if ((segmentHeader.magic != Recorder::SegmentMagic) ||
+          (segmentHeader.size > 0 &&
+           fread (&data [0], segmentHeader.size, 1, file) != 1)) {
+         std::cout << "bad or truncated segment\n";
+         break;
+      }
+      if (listSegments) {
+         std::cout << "segment " << segmentHeader.sequence << ": "
+                   << segmentHeader.records << " records, "
+                   << segmentHeader.size << " bytes\n";
+      }
+      segments++;
+
+      size_t offset = 0;
+      for (epicsUInt32 r = 0; r < segmentHeader.records; r++) {
+         Recorder::Record_Header header;
+         memcpy (&header, &data [offset], sizeof (header));
+         if ((header.kind == Recorder::RecordUpdate) &&
+             (header.fieldType == ACAI::ClientFieldDOUBLE)) {
+            double value;
+            memcpy (&value, &data [offset + sizeof (header)], 8);
+            if (havePrevious && (value != previous + 1.0)) consecutive = false;
+            previous = value;
+            havePrevious = true;
+         }
+         offset += (sizeof (header) + header.size + 7) & ~size_t (7);
+         records++;
+      }
+   }
+   fclose (file);
+
+   std::cout << "segments " << segments << ", records " << records
+             << ", values consecutive " << (consecutive ? "yes" : "no") << "\n";
+}
+
+//------------------------------------------------------------------------------
+// With the minimum buffer size, 250 scalar updates roll over into three
+// segments, the last being written on close.
+//
+static void testRollover (ACAI::Client* client)
+{
+   std::cout << "rollover\n";
+
+   remove (filename);
+   Recorder* recorder = new Recorder (4096);
+   recorder->setFlushInterval (60.0);
+   recorder->setSyncPolicy (Recorder::SyncOnClose);
+   recorder->registerClient (client);
+   std::cout << "open: " << (recorder->open (filename) ? "okay" : "failed") << "\n";
+
+   for (int j = 0; j < 250; j++) {
+      ACAI::Simulation::postUpdate (client->pvName ());
+   }
+   settle ();
+
+   recorder->close ();
+   reportStatistics (recorder);
+   scanFile (true);
+   remove (filename);
+   delete recorder;
+   std::cout << "\n";
+}
+
+//------------------------------------------------------------------------------
+// Each waveform update fills a buffer, so every update hands a segment to the
+// writer. As the updates are dispatched back to back, and each segment write
+// is synced, recording must wait for the writer.
+//
+static void testWriterWaits ()
+{
+   std::cout << "writer waits\n";
+
+   ACAI::Simulation::definePv ("REC:WAVEFORM", ACAI::ClientFieldDOUBLE, 500);
+   ACAI::Client* client = new ACAI::Client ("REC:WAVEFORM");
+   client->openChannel ();
+   settle ();
+
+   remove (filename);
+   Recorder* recorder = new Recorder (4096);
+   recorder->setFlushInterval (60.0);
+   recorder->setSyncPolicy (Recorder::SyncEachSegment);
+   recorder->registerClient (client);
+   std::cout << "open: " << (recorder->open (filename) ? "okay" : "failed") << "\n";
+
+   for (int j = 0; j < 20; j++) {
+      ACAI::Simulation::postUpdate ("REC:WAVEFORM");
+   }
+   settle ();
+
+   recorder->close ();
+   reportStatistics (recorder);
+   std::cout << "writer waited:    " << (recorder->writerWaits () > 0 ? "yes" : "no") << "\n";
+   scanFile (false);
+   remove (filename);
+   delete recorder;
+
+   client->closeChannel ();
+   delete client;
+   std::cout << "\n";
+}
+
+
+//==============================================================================
+//
+int main () {
+   std::cout << "test binary recorder starting (" << ACAI_VERSION_STRING << ")\n\n";
+
+   ACAI::Simulation::enable ();
+   ACAI::Simulation::definePv ("REC:DOUBLE", ACAI::ClientFieldDOUBLE);
+   ACAI::Simulation::definePv ("REC:LONG",   ACAI::ClientFieldLONG, 3);
+   ACAI::Simulation::definePv ("REC:STRING", ACAI::ClientFieldSTRING);
+
+   ACAI::Client::initialise ();
+
+   ACAI::Client* clients [NUMBER_OF_CLIENTS];
+   clients [0] = new ACAI::Client ("REC:DOUBLE");
+   clients [1] = new ACAI::Client ("REC:LONG");
+   clients [2] = new ACAI::Client ("REC:STRING");
+   for (int j = 0; j < NUMBER_OF_CLIENTS; j++) {
+      clients [j]->openChannel ();
+   }
+   settle ();
+
+   // Record from here, i.e. after the initial updates. A long flush interval
+   // ensures all the records are written as a single segment on close.
+   //
+   remove (filename);
+   Recorder* recorder = new Recorder ();
+   recorder->setFlushInterval (60.0);
+   for (int j = 0; j < NUMBER_OF_CLIENTS; j++) {
+      recorder->registerClient (clients [j]);
+   }
+   std::cout << "open: " << (recorder->open (filename) ? "okay" : "failed") << "\n";
+
+   ACAI::Simulation::postUpdate ("REC:DOUBLE");
+   ACAI::Simulation::postUpdate ("REC:DOUBLE");
+   ACAI::Simulation::postUpdate ("REC:LONG");
+   ACAI::Simulation::postUpdate ("REC:STRING");
+   settle ();
+
+   ACAI::Simulation::setConnected ("REC:LONG", false);
+   settle ();
+
+   recorder->close ();
+   reportStatistics (recorder);
+   std::cout << "\n";
+
+   dumpFile ();
+   remove (filename);
+   delete recorder;
+   std::cout << "\n";
+
+   testRollover (clients [0]);
+   testWriterWaits ();
+
+   for (int j = 0; j < NUMBER_OF_CLIENTS; j++) {
+      clients [j]->closeChannel ();
+      delete clients [j];
+   }
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+   ACAI::Simulation::disable ();
+
+   std::cout << "test binary recorder complete\n";
+   return 0;
+}
+
+// end
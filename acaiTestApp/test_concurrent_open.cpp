@@ -0,0 +1,193 @@
+// test_concurrent_open.cpp
+//
+// Stress test: opens, closes and deletes channels concurrently from a number
+// of worker threads, each attached to the ACAI context, and then checks that
+// the surviving channels connect and that callbacks queued for the deleted
+// channels are quietly discarded, i.e. never reach a client.
+//
+// The channels are served by the in-process simulated backend, so no IOC is
+// required and the counts are deterministic. See test_concurrent_open.out.
+//
+
+#include <iostream>
+#include <vector>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_client_set.h>
+#include <acai_simulation.h>
+#include <acai_statistics.h>
+#include <acai_version.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+
+#define NUMBER_OF_WORKERS     8
+#define NUMBER_OF_ITERATIONS  200
+#define NUMBER_OF_PVS         4
+
+typedef std::vector<ACAI::ClientString> PV_Name_Lists;
+typedef std::vector<ACAI::Client*> Client_Lists;
+
+// Counts the callbacks that actually reach a client. These are only called
+// from the poll thread.
+//
+static int connectionUpdates = 0;
+static int dataUpdates = 0;
+
+class Counting_Client : public ACAI::Client {
+public:
+   explicit Counting_Client (const ACAI::ClientString& pvName) :
+      ACAI::Client (pvName) { }
+
+protected:
+   void connectionUpdate (const bool isConnected) { connectionUpdates++; }
+   void dataUpdate (const bool firstUpdate) { dataUpdates++; }
+};
+
+struct Worker {
+   int index;
+   const PV_Name_Lists* pvNames;
+   Client_Lists survivors;
+   int opened;
+   int deleted;
+   bool attached;
+   epicsEventId done;
+};
+
+//------------------------------------------------------------------------------
+// Each worker opens a channel per iteration, and deletes every other channel
+// it has opened shortly after opening it.
+//
+static void workerThread (void* parm)
+{
+   Worker* worker = (Worker*) parm;
+
+   worker->attached = ACAI::Client::attach ();
+   if (worker->attached) {
+      const PV_Name_Lists& names = *worker->pvNames;
+
+      for (int j = 0; j < NUMBER_OF_ITERATIONS; j++) {
+         const ACAI::ClientString& name = names [(worker->index + j) % names.size ()];
+         ACAI::Client* client = new Counting_Client (name);
+         if (client->openChannel ()) worker->opened++;
+
+         if (j % 2) {
+            client->closeChannel ();
+            delete client;
+            worker->deleted++;
+         } else {
+            worker->survivors.push_back (client);
+         }
+
+         if (j % 16 == 0) epicsThreadSleep (0.001);
+      }
+   }
+
+   epicsEventSignal (worker->done);
+}
+
+
+//==============================================================================
+//
+int main () {
+   std::cout << "test concurrent open starting ("
+             << ACAI_VERSION_STRING << ")\n\n";
+
+   ACAI::Simulation::enable ();
+
+   PV_Name_Lists pvNames;
+   for (int j = 1; j <= NUMBER_OF_PVS; j++) {
+      const ACAI::ClientString name = ACAI::csnprintf (40, "SIM:OPEN:%d", j);
+      ACAI::Simulation::definePv (name, ACAI::ClientFieldDOUBLE);
+      pvNames.push_back (name);
+   }
+
+   ACAI::Client::initialise ();
+   ACAI::Client::resetStatistics ();
+
+   Worker workers [NUMBER_OF_WORKERS];
+
+   for (int w = 0; w < NUMBER_OF_WORKERS; w++) {
+      Worker& worker = workers [w];
+      worker.index = w;
+      worker.pvNames = &pvNames;
+      worker.opened = 0;
+      worker.deleted = 0;
+      worker.attached = false;
+      worker.done = epicsEventCreate (epicsEventEmpty);
+
+      epicsThreadCreate ("acai_worker", epicsThreadPriorityMedium,
+                         epicsThreadGetStackSize (epicsThreadStackMedium),
+                         workerThread, &worker);
+   }
+
+   // Wait for all the workers to complete. We do not poll in the meantime, so
+   // the callbacks for deleted clients accumulate in the callback queue.
+   //
+   ACAI::Client_Set* survivors = new ACAI::Client_Set (true);   // deep destruction
+   int opened = 0;
+   int deleted = 0;
+   int failed = 0;
+
+   for (int w = 0; w < NUMBER_OF_WORKERS; w++) {
+      Worker& worker = workers [w];
+      epicsEventWait (worker.done);
+      epicsEventDestroy (worker.done);
+
+      if (!worker.attached) failed++;
+      opened += worker.opened;
+      deleted += worker.deleted;
+      for (size_t j = 0; j < worker.survivors.size (); j++) {
+         survivors->insert (worker.survivors [j]);
+      }
+   }
+
+   ACAI::Client_Statistics statistics;
+   ACAI::Client::getStatistics (statistics);
+
+   std::cout << "workers failed to attach: " << failed << "\n";
+   std::cout << "channels opened:  " << opened << "\n";
+   std::cout << "channels deleted: " << deleted << "\n";
+   std::cout << "channels remaining: " << survivors->count () << "\n";
+   std::cout << "connection callbacks queued: "
+             << statistics.connectionCallbackCount << "\n";
+
+   const bool ok = survivors->waitAllChannelsReady (5.0, 0.02);
+   std::cout << "all remaining channels ready " << (ok ? "yes" : "no") << "\n";
+
+   // Ensure all queued callbacks have been dispatched.
+   //
+   for (int t = 0; t < 10; t++) {
+      ACAI::Client::poll ();
+   }
+
+   // Each survivor receives a connection update, and the initial read and
+   // first subscription updates. Anything else dispatched was for a deleted
+   // client, and must have been dropped.
+   //
+   ACAI::Client::getStatistics (statistics);
+   const int dispatched = (int) statistics.dequeueCount;
+   const int dropped = dispatched - connectionUpdates - dataUpdates;
+
+   std::cout << "connection updates: " << connectionUpdates << "\n";
+   std::cout << "data updates: " << dataUpdates << "\n";
+   std::cout << "callbacks dispatched: " << dispatched << "\n";
+   std::cout << "callbacks dropped: " << dropped << "\n";
+
+   const int remaining = survivors->count ();
+   delete survivors;
+
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+   ACAI::Simulation::disable ();
+
+   const bool pass = (failed == 0) && ok &&
+                     (opened == NUMBER_OF_WORKERS * NUMBER_OF_ITERATIONS) &&
+                     (connectionUpdates == remaining) &&
+                     (dataUpdates == 2 * remaining) &&
+                     (dropped == deleted);
+
+   std::cout << "\ntest concurrent open " << (pass ? "passed" : "FAILED") << "\n";
+   return pass ? 0 : 1;
+}
+
+// end
@@ -0,0 +1,177 @@
+// test_concurrent_read.cpp
+//
+// Stress test: a number of reader threads repeatedly take snapshots of a set
+// of clients while the main thread continues to poll and dispatch updates.
+// Each reader checks that the snapshots it observes are self consistent and
+// are never older than a snapshot previously observed.
+//
+// The PVs are served by the in-process simulated backend, updating at a high
+// rate, so no IOC is required. Each simulated update n has the value n + 0.25,
+// so the floating, integer and string values of a snapshot are all derived
+// from the one update number and can be compared exactly - a torn snapshot
+// would mix values from different updates. This test is also intended to be
+// built and run with -fsanitize=thread. See test_concurrent_read.out.
+//
+
+#include <iostream>
+#include <string.h>
+#include <vector>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_client_set.h>
+#include <acai_simulation.h>
+#include <acai_version.h>
+#include <epicsAtomic.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+
+#define NUMBER_OF_READERS   4
+#define NUMBER_OF_PVS       4
+#define UPDATE_RATE         2000.0  // per PV, updates per second
+#define TEST_DURATION       5.0     // seconds
+
+typedef std::vector<ACAI::Client*> Client_Lists;
+
+struct Reader {
+   const Client_Lists* clients;
+   int stop;
+   unsigned long snapshots;
+   unsigned long changes;
+   unsigned long errors;
+   epicsEventId done;
+};
+
+//------------------------------------------------------------------------------
+// Checks that the floating, integer and string values are those of the one
+// simulated update, i.e. n + 0.25, n and "n.250" (the precision is 3).
+//
+static bool isConsistent (const ACAI::ClientSnapshot& item)
+{
+   if (!item.dataIsAvailable) return true;
+   if (!item.isConnected) return false;
+
+   const ACAI::ClientInteger n = item.integerValue;
+   if (item.floatingValue != double (n) + 0.25) return false;
+
+   const ACAI::ClientString expected = ACAI::csnprintf (40, "%d.250", n);
+   return strcmp (item.stringValue, expected.c_str ()) == 0;
+}
+
+//------------------------------------------------------------------------------
+//
+static void readerThread (void* parm)
+{
+   Reader* reader = (Reader*) parm;
+   const Client_Lists& clients = *reader->clients;
+   std::vector<ACAI::ClientUInt32> lastCount (clients.size (), 0);
+   std::vector<ACAI::ClientInteger> lastValue (clients.size (), 0);
+
+   while (!epicsAtomicGetIntT (&reader->stop)) {
+      for (size_t j = 0; j < clients.size (); j++) {
+         ACAI::ClientSnapshot item;
+         if (!clients [j]->getSnapshot (item)) {
+            reader->errors++;
+            continue;
+         }
+         reader->snapshots++;
+
+         // Neither the update count nor the update number may go backwards.
+         //
+         if ((item.updateCount < lastCount [j]) ||
+             (item.integerValue < lastValue [j]) || !isConsistent (item)) {
+            reader->errors++;
+         }
+         if (item.integerValue != lastValue [j]) reader->changes++;
+         lastCount [j] = item.updateCount;
+         lastValue [j] = item.integerValue;
+      }
+   }
+
+   epicsEventSignal (reader->done);
+}
+
+
+//==============================================================================
+//
+int main () {
+   std::cout << "test concurrent read starting ("
+             << ACAI_VERSION_STRING << ")\n\n";
+
+   ACAI::Simulation::enable ();
+
+   ACAI::Client::initialise ();
+
+   ACAI::Client_Set* set = new ACAI::Client_Set (true);   // deep destruction
+   Client_Lists clients;
+
+   for (int j = 1; j <= NUMBER_OF_PVS; j++) {
+      const ACAI::ClientString name = ACAI::csnprintf (40, "SIM:READ:%d", j);
+      ACAI::Simulation::definePv (name, ACAI::ClientFieldDOUBLE, 1, UPDATE_RATE);
+      clients.push_back (new ACAI::Client (name));
+   }
+
+   for (size_t j = 0; j < clients.size (); j++) {
+      clients [j]->setSnapshotEnabled (true);
+      set->insert (clients [j]);
+   }
+
+   set->openAllChannels ();
+   const bool ok = set->waitAllChannelsReady (5.0, 0.02);
+   std::cout << "all channels ready " << (ok ? "yes" : "no") << "\n";
+
+   Reader readers [NUMBER_OF_READERS];
+   for (int r = 0; r < NUMBER_OF_READERS; r++) {
+      Reader& reader = readers [r];
+      reader.clients = &clients;
+      reader.stop = 0;
+      reader.snapshots = 0;
+      reader.changes = 0;
+      reader.errors = 0;
+      reader.done = epicsEventCreate (epicsEventEmpty);
+
+      epicsThreadCreate ("acai_reader", epicsThreadPriorityMedium,
+                         epicsThreadGetStackSize (epicsThreadStackMedium),
+                         readerThread, &reader);
+   }
+
+   // Keep dispatching updates while the readers run.
+   //
+   ACAI::Simulation::startThread (0.001);
+   for (double t = 0.0; t < TEST_DURATION; t += 0.005) {
+      epicsThreadSleep (0.005);
+      ACAI::Client::poll ();
+   }
+   ACAI::Simulation::stopThread ();
+
+   unsigned long snapshots = 0;
+   unsigned long changes = 0;
+   unsigned long errors = 0;
+   for (int r = 0; r < NUMBER_OF_READERS; r++) {
+      Reader& reader = readers [r];
+      epicsAtomicSetIntT (&reader.stop, 1);
+      epicsEventWait (reader.done);
+      epicsEventDestroy (reader.done);
+      snapshots += reader.snapshots;
+      changes += reader.changes;
+      errors += reader.errors;
+   }
+
+   // The numbers of snapshots and changes vary from run to run.
+   //
+   std::cout << "snapshots taken: " << (snapshots > 0 ? "yes" : "no") << "\n";
+   std::cout << "value changes observed: " << (changes > 0 ? "yes" : "no") << "\n";
+   std::cout << "errors: " << errors << "\n";
+
+   set->closeAllChannels ();
+   delete set;
+
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+   ACAI::Simulation::disable ();
+
+   const bool pass = ok && (snapshots > 0) && (changes > 0) && (errors == 0);
+   std::cout << "\ntest concurrent read " << (pass ? "passed" : "FAILED") << "\n";
+   return pass ? 0 : 1;
+}
+
+// end
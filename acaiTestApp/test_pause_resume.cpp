@@ -0,0 +1,143 @@
+// test_pause_resume.cpp
+//
+// Compares the cost of a GUI panel switch, i.e. stop and then restart updates
+// for a set of clients, using pauseSubscription/resumeSubscription against
+// that of closeAllChannels/openAllChannels.
+//
+// Usage: test_pause_resume [number_of_clients [pv_name ...]]
+// The number of clients defaults to 400. The clients are spread over the
+// given PVs, which default to T1 .. T4, and are expected to be served by a
+// local soft IOC.
+//
+
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_client_set.h>
+#include <acai_version.h>
+#include <epicsTime.h>
+#include <epicsThread.h>
+
+#define NUMBER_OF_CYCLES   20
+
+typedef std::vector<ACAI::Client*> Client_Lists;
+
+static int updateCount = 0;
+
+//------------------------------------------------------------------------------
+//
+static void dataUpdate (ACAI::Client*, const bool)
+{
+   updateCount++;
+}
+
+//------------------------------------------------------------------------------
+// Polls until at least the expected number of updates have been received.
+//
+static bool waitUpdates (const int expected, const double timeOut)
+{
+   double total = 0.0;
+   while ((updateCount < expected) && (total < timeOut)) {
+      epicsThreadSleep (0.002);
+      total += 0.002;
+      ACAI::Client::poll ();
+   }
+   return updateCount >= expected;
+}
+
+
+//==============================================================================
+//
+int main (int argc, char* argv []) {
+   std::cout << "test pause resume starting ("
+             << ACAI_VERSION_STRING << ")\n\n";
+
+   int number = 400;
+   if (argc >= 2) {
+      number = atoi (argv [1]);
+      if (number < 1) number = 1;
+   }
+
+   std::vector<ACAI::ClientString> pvNames;
+   for (int j = 2; j < argc; j++) {
+      pvNames.push_back (argv [j]);
+   }
+   if (pvNames.empty ()) {
+      pvNames.push_back ("T1");
+      pvNames.push_back ("T2");
+      pvNames.push_back ("T3");
+      pvNames.push_back ("T4");
+   }
+
+   ACAI::Client::initialise ();
+
+   ACAI::Client_Set* set = new ACAI::Client_Set (true);   // deep destruction
+   Client_Lists clients;
+   for (int j = 0; j < number; j++) {
+      ACAI::Client* client = new ACAI::Client (pvNames [j % pvNames.size ()]);
+      client->setUpdateHandler (dataUpdate);
+      clients.push_back (client);
+      set->insert (client);
+   }
+
+   set->openAllChannels ();
+   bool ok = set->waitAllChannelsReady (5.0, 0.02);
+   std::cout << "clients: " << number << ", all channels ready "
+             << (ok ? "yes" : "no") << "\n";
+
+   // Pause/resume panel switches.
+   //
+   ok = true;
+   epicsTime start = epicsTime::getCurrent ();
+   for (int cycle = 0; cycle < NUMBER_OF_CYCLES; cycle++) {
+      for (int j = 0; j < number; j++) {
+         clients [j]->pauseSubscription ();
+      }
+      ACAI::Client::poll ();
+
+      updateCount = 0;
+      for (int j = 0; j < number; j++) {
+         clients [j]->resumeSubscription ();
+      }
+      ACAI::Client::flush ();
+      ok &= waitUpdates (number, 5.0);
+   }
+   epicsTime finish = epicsTime::getCurrent ();
+   const double pauseResumeTime = (finish - start) / NUMBER_OF_CYCLES;
+   std::cout << "pause/resume: " << (ok ? "okay" : "timed out") << ", "
+             << 1000.0 * pauseResumeTime << " mS per switch\n";
+
+   // Close/open panel switches.
+   //
+   ok = true;
+   start = epicsTime::getCurrent ();
+   for (int cycle = 0; cycle < NUMBER_OF_CYCLES; cycle++) {
+      set->closeAllChannels ();
+      ACAI::Client::poll ();
+
+      set->openAllChannels ();
+      ok &= set->waitAllChannelsReady (5.0, 0.002);
+   }
+   finish = epicsTime::getCurrent ();
+   const double closeOpenTime = (finish - start) / NUMBER_OF_CYCLES;
+   std::cout << "close/open:   " << (ok ? "okay" : "timed out") << ", "
+             << 1000.0 * closeOpenTime << " mS per switch\n";
+
+   if (pauseResumeTime > 0.0) {
+      std::cout << "speed up:     " << closeOpenTime / pauseResumeTime << "\n";
+   }
+
+   ACAI::Client::poll ();
+   set->closeAllChannels ();
+   delete set;
+
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+
+   std::cout << "\ntest pause resume complete\n";
+   return 0;
+}
+
+// end
@@ -0,0 +1,127 @@
+// test_put_batch.cpp
+//
+// Compares the setpoint write rate of individual puts, with a single flush per
+// cycle, against that of a put batch, also with a single flush per cycle.
+// See test_put_batch_results for a check of the per-put results.
+//
+// Usage: test_put_batch [number_of_clients [pv_name ...]]
+// The number of clients defaults to 400. The clients are spread over the
+// given PVs, which default to T1 .. T4, and are expected to be served by a
+// local soft IOC.
+//
+
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_client_set.h>
+#include <acai_client_put_batch.h>
+#include <acai_version.h>
+#include <epicsTime.h>
+#include <epicsThread.h>
+
+#define NUMBER_OF_CYCLES   100
+
+typedef std::vector<ACAI::Client*> Client_Lists;
+
+//------------------------------------------------------------------------------
+//
+static double rate (const int puts, const epicsTime& start, const epicsTime& finish)
+{
+   const double duration = finish - start;
+   return duration > 0.0 ? puts / duration : 0.0;
+}
+
+
+//==============================================================================
+//
+int main (int argc, char* argv []) {
+   std::cout << "test put batch starting ("
+             << ACAI_VERSION_STRING << ")\n\n";
+
+   int number = 400;
+   if (argc >= 2) {
+      number = atoi (argv [1]);
+      if (number < 1) number = 1;
+   }
+
+   std::vector<ACAI::ClientString> pvNames;
+   for (int j = 2; j < argc; j++) {
+      pvNames.push_back (argv [j]);
+   }
+   if (pvNames.empty ()) {
+      pvNames.push_back ("T1");
+      pvNames.push_back ("T2");
+      pvNames.push_back ("T3");
+      pvNames.push_back ("T4");
+   }
+
+   ACAI::Client::initialise ();
+
+   ACAI::Client_Set* set = new ACAI::Client_Set (true);   // deep destruction
+   Client_Lists clients;
+   for (int j = 0; j < number; j++) {
+      ACAI::Client* client = new ACAI::Client (pvNames [j % pvNames.size ()]);
+      client->setReadMode (ACAI::NoRead);
+      clients.push_back (client);
+      set->insert (client);
+   }
+
+   set->openAllChannels ();
+   const bool ok = set->waitAllChannelsReady (5.0, 0.02);
+   std::cout << "clients: " << number << ", all channels ready "
+             << (ok ? "yes" : "no") << "\n";
+
+   // Individual puts.
+   //
+   int individualSuccesses = 0;
+   epicsTime start = epicsTime::getCurrent ();
+   for (int cycle = 0; cycle < NUMBER_OF_CYCLES; cycle++) {
+      for (int j = 0; j < number; j++) {
+         if (clients [j]->putFloating (cycle + 0.001 * j)) individualSuccesses++;
+      }
+      ACAI::Client::flush ();
+   }
+   epicsTime finish = epicsTime::getCurrent ();
+   const double individualRate = rate (number * NUMBER_OF_CYCLES, start, finish);
+
+   ACAI::Client::poll ();
+
+   // Batched puts - the batch is re-used each cycle.
+   //
+   ACAI::Client_Put_Batch batch;
+   batch.reserve (number);
+
+   int batchSuccesses = 0;
+   start = epicsTime::getCurrent ();
+   for (int cycle = 0; cycle < NUMBER_OF_CYCLES; cycle++) {
+      batch.clear ();
+      for (int j = 0; j < number; j++) {
+         batch.addFloating (clients [j], cycle + 0.001 * j);
+      }
+      batchSuccesses += batch.execute ();
+   }
+   finish = epicsTime::getCurrent ();
+   const double batchRate = rate (number * NUMBER_OF_CYCLES, start, finish);
+
+   std::cout << "individual: " << individualSuccesses << " puts, "
+             << individualRate << " setpoints/sec\n";
+   std::cout << "batch:      " << batchSuccesses << " puts, "
+             << batchRate << " setpoints/sec\n";
+   if (individualRate > 0.0) {
+      std::cout << "speed up:   " << batchRate / individualRate << "\n";
+   }
+
+   ACAI::Client::poll ();
+   set->closeAllChannels ();
+   delete set;
+
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+
+   std::cout << "\ntest put batch complete\n";
+   return 0;
+}
+
+// end
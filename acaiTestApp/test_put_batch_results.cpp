@@ -0,0 +1,131 @@
+// test_put_batch_results.cpp
+//
+// Checks the per-put results, i.e. execute's return value, putResult and
+// failureCount, of a put batch against the in-process simulated backend.
+// The batch includes a disconnected client, a client whose PV does not exist
+// and a client with a pending put callback. No IOC is required.
+// See test_put_batch_results.out.
+//
+
+#include <iostream>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_client_put_batch.h>
+#include <acai_simulation.h>
+#include <acai_version.h>
+
+#define NUMBER_OF_CLIENTS   6
+
+static const char* pvNames [NUMBER_OF_CLIENTS] = {
+   "SIM:BATCH:FLOAT",
+   "SIM:BATCH:INT",
+   "SIM:BATCH:STRING",
+   "SIM:BATCH:DISCONNECT",
+   "SIM:BATCH:CALLBACK",
+   "SIM:BATCH:UNDEFINED"       // not defined, never connects
+};
+
+//------------------------------------------------------------------------------
+//
+static void settle ()
+{
+   for (int j = 0; j < 5; j++) {
+      ACAI::Client::poll ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+static void execute (const char* title, ACAI::Client_Put_Batch& batch)
+{
+   const int successes = batch.execute ();
+   settle ();
+
+   std::cout << title << "\n";
+   std::cout << "  puts " << batch.count () << ", successes " << successes
+             << ", failures " << batch.failureCount () << "\n";
+
+   for (int j = 0; j < batch.count (); j++) {
+      ACAI::Client* client = batch.client (j);
+      std::cout << "  " << j << " " << client->pvName () << ": "
+                << (batch.putResult (j) ? "ok  " : "fail") << "  value ";
+      if (!client->dataIsAvailable ()) {
+         std::cout << "n/a\n";
+      } else if (client->dataFieldType () == ACAI::ClientFieldSTRING) {
+         std::cout << client->getString () << "\n";
+      } else {
+         std::cout << client->getFloating () << "\n";
+      }
+   }
+
+   std::cout << "  out of range: "
+             << (batch.putResult (-1) || batch.putResult (batch.count ()) ? "ok" : "fail")
+             << "\n\n";
+}
+
+
+//==============================================================================
+//
+int main () {
+   std::cout << "test put batch results starting (" << ACAI_VERSION_STRING << ")\n\n";
+
+   ACAI::Simulation::enable ();
+   ACAI::Simulation::definePv (pvNames [0], ACAI::ClientFieldDOUBLE);
+   ACAI::Simulation::definePv (pvNames [1], ACAI::ClientFieldLONG);
+   ACAI::Simulation::definePv (pvNames [2], ACAI::ClientFieldSTRING);
+   ACAI::Simulation::definePv (pvNames [3], ACAI::ClientFieldDOUBLE);
+   ACAI::Simulation::definePv (pvNames [4], ACAI::ClientFieldDOUBLE);
+
+   ACAI::Client::initialise ();
+
+   ACAI::Client* clients [NUMBER_OF_CLIENTS];
+   for (int j = 0; j < NUMBER_OF_CLIENTS; j++) {
+      clients [j] = new ACAI::Client (pvNames [j]);
+      clients [j]->openChannel ();
+   }
+   settle ();
+
+   ACAI::Simulation::setConnected (pvNames [3], false);
+   settle ();
+
+   // Leave a put callback pending, without coalescing, on the callback client.
+   // The simulated put callback completes on the next poll.
+   //
+   clients [4]->setUsePutCallback (true);
+   clients [4]->putFloating (5.0);
+
+   ACAI::Client_Put_Batch batch;
+   batch.addFloating (clients [0], 1.5);
+   batch.addInteger  (clients [1], 42);
+   batch.addString   (clients [2], "batch");
+   batch.addFloating (clients [3], 3.5);
+   batch.addFloating (clients [4], 4.5);
+   batch.addFloating (clients [5], 6.5);
+   std::cout << "null client index: " << batch.addFloating (NULL, 0.0) << "\n\n";
+
+   execute ("first execute", batch);
+
+   // Re-connect, and the put callback has now completed.
+   //
+   ACAI::Simulation::setConnected (pvNames [3], true);
+   settle ();
+
+   execute ("second execute", batch);
+
+   batch.clear ();
+   std::cout << "after clear: puts " << batch.count ()
+             << ", failures " << batch.failureCount () << "\n";
+
+   for (int j = 0; j < NUMBER_OF_CLIENTS; j++) {
+      clients [j]->closeChannel ();
+      delete clients [j];
+   }
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+   ACAI::Simulation::disable ();
+
+   std::cout << "\ntest put batch results complete\n";
+   return 0;
+}
+
+// end
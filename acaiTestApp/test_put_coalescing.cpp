@@ -0,0 +1,176 @@
+// test_put_coalescing.cpp
+//
+// Exercises setPutCoalescing against the in-process simulated backend, i.e.
+// that the last value put while a put callback is pending wins, and that the
+// deferred put is discarded when superseded by a put issued by the put
+// callback notification, as triggered here by clearPendingPutCallback.
+// No IOC is required. See test_put_coalescing.out.
+//
+
+#include <iostream>
+#include <sstream>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_simulation.h>
+#include <acai_version.h>
+
+#define PV_NAME   "SIM:COALESCE"
+
+//------------------------------------------------------------------------------
+// Records each value written to the PV, as seen by the client's subscription,
+// and counts put callback notifications. Optionally issues a put from within
+// the next put callback notification.
+//
+class Coalescing_Client : public ACAI::Client {
+public:
+   explicit Coalescing_Client (const ACAI::ClientString& pvName) :
+      ACAI::Client (pvName), successes (0), failures (0),
+      putInNotification (false), notificationValue (0.0) { }
+
+   std::ostringstream written;
+   int successes;
+   int failures;
+   bool putInNotification;
+   double notificationValue;
+
+protected:
+   void dataUpdate (const bool firstUpdate)
+   {
+      this->written << " " << this->getFloating ();
+   }
+
+   void putCallbackNotifcation (const bool isSuccessful)
+   {
+      if (isSuccessful) {
+         this->successes++;
+      } else {
+         this->failures++;
+      }
+
+      if (this->putInNotification) {
+         this->putInNotification = false;
+         this->putFloating (this->notificationValue);
+      }
+   }
+};
+
+//------------------------------------------------------------------------------
+//
+static void settle ()
+{
+   for (int j = 0; j < 5; j++) {
+      ACAI::Client::poll ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+static const char* yesNo (const bool value)
+{
+   return value ? "yes" : "no";
+}
+
+//------------------------------------------------------------------------------
+//
+static void report (const char* title, Coalescing_Client* client)
+{
+   std::cout << "  " << title << ": pending " << yesNo (client->isPendingPutCallback ())
+             << ", deferred " << yesNo (client->hasDeferredPut ()) << "\n";
+}
+
+//------------------------------------------------------------------------------
+//
+static void reportWritten (Coalescing_Client* client)
+{
+   settle ();
+
+   std::cout << "  written:" << client->written.str ()
+             << ", value " << client->getFloating ()
+             << ", notifications " << client->successes
+             << " succeeded " << client->failures << " failed\n";
+
+   client->written.str ("");
+   client->successes = 0;
+   client->failures = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+static void put (Coalescing_Client* client, const double value)
+{
+   const bool status = client->putFloating (value);
+   std::cout << "  put " << value << ": " << (status ? "accepted" : "rejected") << "\n";
+}
+
+
+//==============================================================================
+//
+int main () {
+   std::cout << "test put coalescing starting (" << ACAI_VERSION_STRING << ")\n\n";
+
+   ACAI::Simulation::enable ();
+   ACAI::Simulation::definePv (PV_NAME, ACAI::ClientFieldDOUBLE);
+
+   ACAI::Client::initialise ();
+
+   Coalescing_Client* client = new Coalescing_Client (PV_NAME);
+   client->setUsePutCallback (true);
+   client->openChannel ();
+   settle ();
+   client->written.str ("");
+
+   // The simulated put callback completes on the next poll, so all but the
+   // first put are made while the put callback is pending.
+   //
+   std::cout << "put coalescing enabled\n";
+   client->setPutCoalescing (true);
+   put (client, 1.0);
+   put (client, 2.0);
+   put (client, 3.0);
+   put (client, 4.0);
+   report ("before poll", client);
+   reportWritten (client);
+   report ("after poll", client);
+   std::cout << "\n";
+
+   std::cout << "put coalescing disabled\n";
+   client->setPutCoalescing (false);
+   put (client, 5.0);
+   put (client, 6.0);
+   report ("before poll", client);
+   reportWritten (client);
+   std::cout << "\n";
+
+   // With no put from the notification, the deferred put is issued.
+   //
+   std::cout << "clear pending put callback\n";
+   client->setPutCoalescing (true);
+   put (client, 7.0);
+   put (client, 8.0);
+   client->clearPendingPutCallback ();
+   report ("after clear", client);
+   reportWritten (client);
+   std::cout << "\n";
+
+   // A put issued by the notification supersedes the deferred put.
+   //
+   std::cout << "clear pending put callback, put from notification\n";
+   client->putInNotification = true;
+   client->notificationValue = 20.0;
+   put (client, 9.0);
+   put (client, 10.0);
+   client->clearPendingPutCallback ();
+   report ("after clear", client);
+   reportWritten (client);
+
+   client->closeChannel ();
+   delete client;
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+   ACAI::Simulation::disable ();
+
+   std::cout << "\ntest put coalescing complete\n";
+   return 0;
+}
+
+// end
@@ -0,0 +1,104 @@
+// test_put_throttle.cpp
+//
+// Exercises the outbound put throttles, i.e. setPutMinimumInterval and
+// setPutDeadband, against the in-process simulated backend. No IOC is
+// required. The minimum interval is real time, so the test sleeps for longer
+// than the interval where needed. See test_put_throttle.out.
+//
+
+#include <iostream>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_simulation.h>
+#include <acai_version.h>
+#include <epicsThread.h>
+
+#define INTERVAL   0.2
+
+//------------------------------------------------------------------------------
+//
+static void settle ()
+{
+   for (int j = 0; j < 5; j++) {
+      ACAI::Client::poll ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+static void report (const char* title, ACAI::Client* client)
+{
+   settle ();
+
+   std::cout << "  " << title << ": value " << client->getFloating ()
+             << ", deferred " << (client->hasDeferredPut () ? "yes" : "no")
+             << ", suppressed " << client->suppressedPutCount ()
+             << ", deferred puts " << client->deferredPutCount () << "\n";
+}
+
+
+//==============================================================================
+//
+int main () {
+   std::cout << "test put throttle starting (" << ACAI_VERSION_STRING << ")\n\n";
+
+   ACAI::Simulation::enable ();
+   ACAI::Simulation::definePv ("SIM:THROTTLE", ACAI::ClientFieldDOUBLE);
+
+   ACAI::Client::initialise ();
+
+   ACAI::Client* client = new ACAI::Client ("SIM:THROTTLE");
+   client->openChannel ();
+   settle ();
+
+   std::cout << "minimum interval\n";
+   client->setPutMinimumInterval (INTERVAL);
+   client->putFloating (1.0);
+   report ("after first put", client);
+
+   client->putFloating (2.0);
+   client->putFloating (3.0);
+   report ("within interval", client);
+
+   epicsThreadSleep (1.5 * INTERVAL);
+   report ("after interval", client);
+   std::cout << "\n";
+
+   std::cout << "deadband\n";
+   client->setPutMinimumInterval (0.0);
+   client->setPutDeadband (0.5);
+   client->resetPutThrottleCounts ();
+   client->putFloating (3.2);
+   client->putFloating (3.6);
+   client->putInteger (4);
+   report ("after puts", client);
+   std::cout << "\n";
+
+   // The deferred value becomes due while a put callback is still pending.
+   // It must be held until the put callback completes, not lost.
+   //
+   std::cout << "minimum interval with put callback\n";
+   client->setPutDeadband (0.0);
+   client->setPutMinimumInterval (INTERVAL);
+   client->setUsePutCallback (true);
+   client->resetPutThrottleCounts ();
+   epicsThreadSleep (1.5 * INTERVAL);
+
+   client->putFloating (10.0);
+   client->putFloating (11.0);
+   epicsThreadSleep (1.5 * INTERVAL);
+   report ("after interval", client);
+   std::cout << "  pending put callback: "
+             << (client->isPendingPutCallback () ? "yes" : "no") << "\n";
+
+   client->closeChannel ();
+   delete client;
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+   ACAI::Simulation::disable ();
+
+   std::cout << "\ntest put throttle complete\n";
+   return 0;
+}
+
+// end
@@ -0,0 +1,358 @@
+// test_simulation.cpp
+//
+// Exercises ACAI::Client against the in-process simulated backend. No IOC is
+// required, and as updates are only generated by explicit calls to advance,
+// postUpdate etc., the output is deterministic, see test_simulation.out.
+//
+
+#include <iostream>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_simulation.h>
+#include <acai_version.h>
+
+#define NUMBER_OF_CLIENTS  5
+
+static ACAI::Client* clients [NUMBER_OF_CLIENTS];
+
+//------------------------------------------------------------------------------
+// All simulated callbacks are queued immediately, so a few polls suffice for
+// connection, the initial meta data read and the subsequent subscription.
+//
+static void settle ()
+{
+   for (int j = 0; j < 5; j++) {
+      ACAI::Client::poll ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+static void dump (const char* title)
+{
+   settle ();
+
+   std::cout << title << "\n";
+   for (int j = 0; j < NUMBER_OF_CLIENTS; j++) {
+      ACAI::Client* client = clients [j];
+      std::cout << "  " << client->pvName () << " "
+                << (client->isConnected () ? "connected" : "disconnected");
+
+      const unsigned int count = client->dataElementCount ();
+      for (unsigned int k = 0; k < count && client->isConnected (); k++) {
+         std::cout << (k == 0 ? ": " : ", ") << client->getString (k);
+      }
+      std::cout << "\n";
+   }
+   std::cout << "\n";
+}
+
+//------------------------------------------------------------------------------
+//
+static void dumpAdaptive (const char* title, ACAI::Client* client)
+{
+   settle ();
+
+   std::cout << title << "\n"
+             << "  elements " << client->dataElementCount ()
+             << ", adaptive count " << client->adaptiveCount ()
+             << ", resubscribes " << client->adaptiveResubscribeCount ()
+             << ", bytes saved " << client->adaptiveBytesSaved () << "\n\n";
+}
+
+//------------------------------------------------------------------------------
+// A waveform whose number of elements in use, as per its NORD field, changes.
+//
+static void testAdaptive ()
+{
+   ACAI::Simulation::definePv ("SIM:WF",      ACAI::ClientFieldDOUBLE, 1024);
+   ACAI::Simulation::definePv ("SIM:WF.NORD", ACAI::ClientFieldLONG);
+
+   ACAI::Client* waveform = new ACAI::Client ("SIM:WF");
+   ACAI::Client* nord = new ACAI::Client ("SIM:WF.NORD");
+   waveform->setAdaptiveRequestCount (true);
+   waveform->openChannel ();
+   nord->openChannel ();
+   dumpAdaptive ("adaptive initial", waveform);
+
+   ACAI::Simulation::postUpdate ("SIM:WF");
+   ACAI::Simulation::postUpdate ("SIM:WF");
+   dumpAdaptive ("adaptive after two updates", waveform);
+
+   nord->putInteger (200);
+   dumpAdaptive ("adaptive after grow", waveform);
+
+   nord->putInteger (40);
+   dumpAdaptive ("adaptive after shrink", waveform);
+
+   waveform->setAdaptiveRequestCount (false);
+   dumpAdaptive ("adaptive after disable", waveform);
+
+   waveform->closeChannel ();
+   nord->closeChannel ();
+   delete waveform;
+   delete nord;
+   ACAI::Simulation::removeAllPvs ();
+}
+
+//------------------------------------------------------------------------------
+// With lazy meta data, there is no DBR_CTRL read on connection. The meta data
+// is only requested when first needed.
+//
+static void testLazyMetaData ()
+{
+   ACAI::Simulation::definePv ("SIM:LAZY", ACAI::ClientFieldDOUBLE);
+
+   std::cout << "lazy meta data\n";
+
+   size_t base = ACAI::Simulation::metaDataRequests ();
+   ACAI::Client* lazy = new ACAI::Client ("SIM:LAZY");
+   lazy->setLazyMetaData (true);
+   lazy->openChannel ();
+   settle ();
+
+   double value = lazy->getFloating ();
+   size_t requests = ACAI::Simulation::metaDataRequests () - base;
+   std::cout << "  lazy connected: " << value << ", meta data requests " << requests << "\n";
+
+   int precision = lazy->precision ();      // requests the meta data
+   requests = ACAI::Simulation::metaDataRequests () - base;
+   std::cout << "  lazy precision " << precision << ", meta data requests " << requests << "\n";
+
+   settle ();
+   precision = lazy->precision ();
+   std::cout << "  lazy precision " << precision << ", units " << lazy->units () << "\n";
+
+   base = ACAI::Simulation::metaDataRequests ();
+   ACAI::Client* eager = new ACAI::Client ("SIM:LAZY");
+   eager->openChannel ();
+   settle ();
+
+   value = eager->getFloating ();
+   requests = ACAI::Simulation::metaDataRequests () - base;
+   precision = eager->precision ();
+   std::cout << "  eager connected: " << value << ", meta data requests " << requests
+             << ", precision " << precision << "\n\n";
+
+   lazy->closeChannel ();
+   eager->closeChannel ();
+   delete lazy;
+   delete eager;
+   ACAI::Simulation::removeAllPvs ();
+}
+
+//------------------------------------------------------------------------------
+//
+static void dumpRetained (const char* title, ACAI::Client* client, const size_t base)
+{
+   settle ();
+
+   std::cout << "  " << title << " " << (client->isConnected () ? "connected" : "disconnected");
+   const unsigned int count = client->dataElementCount ();
+   for (unsigned int k = 0; k < count && client->isConnected (); k++) {
+      std::cout << (k == 0 ? ": " : ", ") << client->getString (k);
+   }
+   std::cout << ", retained " << client->retainedSubscriptionCount ()
+             << ", meta data requests " << ACAI::Simulation::metaDataRequests () - base
+             << "\n";
+}
+
+//------------------------------------------------------------------------------
+// A retained subscription is not re-made on reconnection, unless the channel's
+// type or element count has changed.
+//
+static void testRetainSubscription ()
+{
+   ACAI::Simulation::definePv ("SIM:RETAIN", ACAI::ClientFieldLONG, 2);
+
+   std::cout << "retain subscription\n";
+
+   size_t base = ACAI::Simulation::metaDataRequests ();
+   ACAI::Client* client = new ACAI::Client ("SIM:RETAIN");
+   client->setRetainSubscription (true);
+   client->openChannel ();
+   dumpRetained ("initial", client, base);
+
+   base = ACAI::Simulation::metaDataRequests ();
+   ACAI::Simulation::setConnected ("SIM:RETAIN", false);
+   dumpRetained ("after disconnect", client, base);
+
+   ACAI::Simulation::setConnected ("SIM:RETAIN", true);
+   dumpRetained ("after reconnect", client, base);
+
+   ACAI::Simulation::definePv ("SIM:RETAIN", ACAI::ClientFieldDOUBLE, 2);
+   dumpRetained ("after type change", client, base);
+   std::cout << "\n";
+
+   client->closeChannel ();
+   delete client;
+   ACAI::Simulation::removeAllPvs ();
+}
+
+//------------------------------------------------------------------------------
+// Connections in excess of the budget are deferred to subsequent polls.
+//
+static void testConnectionBudget ()
+{
+   static const int number = 5;
+   ACAI::Client* budgeted [number];
+
+   std::cout << "connection budget\n";
+
+   ACAI::Client::setConnectionBudget (2);
+   for (int j = 0; j < number; j++) {
+      const ACAI::ClientString pvName = ACAI::csnprintf (40, "SIM:BUDGET:%d", j);
+      ACAI::Simulation::definePv (pvName, ACAI::ClientFieldLONG);
+      budgeted [j] = new ACAI::Client (pvName);
+      budgeted [j]->openChannel ();
+   }
+
+   for (int p = 1; p <= 3; p++) {
+      ACAI::Client::poll ();
+
+      int connected = 0;
+      for (int j = 0; j < number; j++) {
+         if (budgeted [j]->isConnected ()) connected++;
+      }
+      std::cout << "  poll " << p << ": connected " << connected
+                << ", pending " << ACAI::Client::pendingConnections () << "\n";
+   }
+   ACAI::Client::setConnectionBudget (0);
+   std::cout << "\n";
+
+   for (int j = 0; j < number; j++) {
+      budgeted [j]->closeChannel ();
+      delete budgeted [j];
+   }
+   ACAI::Simulation::removeAllPvs ();
+}
+
+//------------------------------------------------------------------------------
+// Counts connection changes of the disconnect cycle client.
+//
+static int cycleConnectionChanges = 0;
+
+static void cycleConnectionHandler (ACAI::Client*, const bool)
+{
+   cycleConnectionChanges++;
+}
+
+//------------------------------------------------------------------------------
+//
+static void advanceCycle (ACAI::Client* client, const double interval)
+{
+   const int updates = ACAI::Simulation::advance (interval);
+   settle ();
+
+   std::cout << "  advance " << interval << " S: " << updates << " updates, "
+             << cycleConnectionChanges << " connection changes, "
+             << (client->isConnected () ? "connected: " + client->getString () : "disconnected")
+             << "\n";
+   cycleConnectionChanges = 0;
+}
+
+//------------------------------------------------------------------------------
+// A PV that is disconnected for 0.25 S every 1.0 S. The long advance spans a
+// complete disconnection.
+//
+static void testDisconnectCycle ()
+{
+   std::cout << "disconnect cycle\n";
+
+   ACAI::Simulation::definePv ("SIM:CYCLE", ACAI::ClientFieldDOUBLE, 1, 10.0);
+   ACAI::Client* client = new ACAI::Client ("SIM:CYCLE");
+   client->openChannel ();
+   settle ();
+   client->setConnectionHandler (cycleConnectionHandler);
+
+   ACAI::Simulation::setDisconnectCycle ("SIM:CYCLE", 1.0, 0.25);
+   for (int j = 0; j < 5; j++) {
+      advanceCycle (client, 0.25);
+   }
+   advanceCycle (client, 1.5);
+
+   ACAI::Simulation::setDisconnectCycle ("SIM:CYCLE", 0.0, 0.0);
+   advanceCycle (client, 1.0);
+   std::cout << "\n";
+
+   client->closeChannel ();
+   delete client;
+   ACAI::Simulation::removeAllPvs ();
+}
+
+
+//==============================================================================
+//
+int main () {
+   std::cout << "test simulation starting (" << ACAI_VERSION_STRING << ")\n\n";
+
+   std::cout << "enable: " << (ACAI::Simulation::enable () ? "okay" : "failed") << "\n\n";
+
+   ACAI::Simulation::definePv ("SIM:DOUBLE", ACAI::ClientFieldDOUBLE, 1, 10.0);
+   ACAI::Simulation::definePv ("SIM:LONG",   ACAI::ClientFieldLONG, 4);
+   ACAI::Simulation::definePv ("SIM:STRING", ACAI::ClientFieldSTRING);
+   ACAI::Simulation::definePv ("SIM:ENUM",   ACAI::ClientFieldENUM);
+
+   ACAI::Client::initialise ();
+
+   clients [0] = new ACAI::Client ("SIM:DOUBLE");
+   clients [1] = new ACAI::Client ("SIM:LONG");
+   clients [2] = new ACAI::Client ("SIM:STRING");
+   clients [3] = new ACAI::Client ("SIM:ENUM");
+   clients [4] = new ACAI::Client ("SIM:UNDEFINED");
+
+   for (int j = 0; j < NUMBER_OF_CLIENTS; j++) {
+      clients [j]->openChannel ();
+   }
+   dump ("initial values");
+
+   std::cout << "re-enable whilst open: "
+             << (ACAI::Simulation::enable () ? "okay" : "refused") << "\n";
+   std::cout << "advance 0.25 S: " << ACAI::Simulation::advance (0.25) << " updates\n";
+   std::cout << "advance 0.05 S: " << ACAI::Simulation::advance (0.05) << " updates\n";
+   ACAI::Simulation::postUpdate ("SIM:LONG");
+   ACAI::Simulation::postUpdate ("SIM:STRING");
+   ACAI::Simulation::postUpdate ("SIM:ENUM");
+   dump ("after advance and post update");
+
+   clients [0]->putFloating (7.5);
+   clients [1]->putInteger (42);
+   clients [2]->putString ("hello");
+   clients [3]->putInteger (3);
+   dump ("after puts");
+
+   ACAI::Simulation::setConnected ("SIM:DOUBLE", false);
+   std::cout << "advance 1.0 S: " << ACAI::Simulation::advance (1.0) << " updates\n";
+   dump ("after disconnect");
+
+   ACAI::Simulation::setConnected ("SIM:DOUBLE", true);
+   ACAI::Simulation::definePv ("SIM:UNDEFINED", ACAI::ClientFieldSHORT, 2);
+   dump ("after reconnect and late definition");
+
+   std::cout << "advance 0.125 S: " << ACAI::Simulation::advance (0.125) << " updates\n";
+   dump ("after advance");
+
+   ACAI::Simulation::removeAllPvs ();
+   dump ("after remove all");
+
+   for (int j = 0; j < NUMBER_OF_CLIENTS; j++) {
+      clients [j]->closeChannel ();
+      delete clients [j];
+   }
+
+   testAdaptive ();
+   testLazyMetaData ();
+   testRetainSubscription ();
+   testConnectionBudget ();
+   testDisconnectCycle ();
+
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+
+   std::cout << "disable: " << (ACAI::Simulation::disable () ? "okay" : "failed") << "\n";
+
+   std::cout << "\ntest simulation complete\n";
+   return 0;
+}
+
+// end
@@ -0,0 +1,116 @@
+// test_statistics.cpp
+//
+// Checks the callback queue and connection counts reported by
+// ACAI::Client::getStatistics, and the semantics of resetStatistics, against
+// the in-process simulated backend. No IOC is required.
+// See test_statistics.out.
+//
+
+#include <iostream>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_simulation.h>
+#include <acai_statistics.h>
+#include <acai_version.h>
+
+#define PV_A             "SIM:STATS:A"
+#define PV_B             "SIM:STATS:B"
+#define FLOOD_UPDATES    1200     // exceeds the queue's coalescing threshold
+
+//------------------------------------------------------------------------------
+//
+static void settle ()
+{
+   for (int j = 0; j < 5; j++) {
+      ACAI::Client::poll ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+static void report (const char* title)
+{
+   ACAI::Client_Statistics s;
+   ACAI::Client::getStatistics (s);
+
+   std::cout << title << "\n"
+             << "  enqueued " << s.enqueueCount
+             << ", dequeued " << s.dequeueCount
+             << ", connections " << s.connectionCallbackCount
+             << ", events " << s.eventCallbackCount
+             << ", coalesced " << s.coalescedCount << "\n"
+             << "  queue length " << s.queueLength
+             << ", high water mark " << s.queueHighWaterMark
+             << ", polls " << s.pollCount << "\n"
+             << "  connection up " << s.connectionUpCount
+             << ", down " << s.connectionDownCount
+             << ", open channels " << s.openChannels << "\n";
+}
+
+
+//==============================================================================
+//
+int main () {
+   std::cout << "test statistics starting (" << ACAI_VERSION_STRING << ")\n\n";
+
+   ACAI::Simulation::enable ();
+   ACAI::Simulation::definePv (PV_A, ACAI::ClientFieldDOUBLE);
+   ACAI::Simulation::definePv (PV_B, ACAI::ClientFieldDOUBLE);
+
+   ACAI::Client::initialise ();
+   ACAI::Client::resetStatistics ();
+   report ("initial");
+
+   ACAI::Client* clientA = new ACAI::Client (PV_A);
+   ACAI::Client* clientB = new ACAI::Client (PV_B);
+   clientA->openChannel ();
+   clientB->openChannel ();
+   report ("channels opened, not polled");
+
+   // Each connection results in an initial read and a subscription update.
+   //
+   settle ();
+   report ("after poll");
+
+   for (int k = 0; k < FLOOD_UPDATES; k++) {
+      ACAI::Simulation::postUpdate (PV_A);
+   }
+   report ("flood, not polled");
+   settle ();
+   report ("flood, after poll");
+
+   ACAI::Simulation::setConnected (PV_B, false);
+   settle ();
+   ACAI::Simulation::setConnected (PV_B, true);
+   settle ();
+   report ("disconnect and reconnect");
+
+   // Reset does not drain the queue: the high water mark restarts from the
+   // current queue length, and queued callbacks are dequeued after the reset.
+   //
+   ACAI::Client::resetStatistics ();
+   report ("reset");
+
+   for (int k = 0; k < 3; k++) {
+      ACAI::Simulation::postUpdate (PV_A);
+   }
+   ACAI::Client::resetStatistics ();
+   report ("three updates queued, then reset");
+   settle ();
+   report ("after poll");
+
+   clientA->closeChannel ();
+   clientB->closeChannel ();
+   delete clientA;
+   delete clientB;
+   report ("channels closed");
+
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+   ACAI::Simulation::disable ();
+
+   std::cout << "\ntest statistics complete\n";
+   return 0;
+}
+
+// end
@@ -0,0 +1,121 @@
+// test_top_clients.cpp
+//
+// Checks Client_Set::topClients ranking order, including ties and n greater
+// than the number of clients, and that updatesReceived includes updates
+// coalesced in the callback queue. Uses the in-process simulated backend with
+// a known number of updates per PV, so no IOC is required.
+// See test_top_clients.out.
+//
+
+#include <iostream>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_client_set.h>
+#include <acai_simulation.h>
+#include <acai_statistics.h>
+#include <acai_version.h>
+
+#define NUMBER_OF_PVS    5
+#define FLOOD_UPDATES    1200     // exceeds the queue's coalescing threshold
+
+static const char* pvNames [NUMBER_OF_PVS] = {
+   "SIM:TOP:A", "SIM:TOP:B", "SIM:TOP:C", "SIM:TOP:D", "SIM:TOP:E"
+};
+
+// C and D deliberately tie.
+//
+static const int numberOfUpdates [NUMBER_OF_PVS] = { 5, 20, 10, 10, 0 };
+
+//------------------------------------------------------------------------------
+//
+static void settle ()
+{
+   for (int j = 0; j < 5; j++) {
+      ACAI::Client::poll ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+static void report (const char* title, const ACAI::ClientLists& list)
+{
+   std::cout << "  " << title << ":";
+   for (size_t j = 0; j < list.size (); j++) {
+      std::cout << " " << list [j]->pvName () << " (" << list [j]->updatesReceived () << ")";
+   }
+   std::cout << "\n";
+}
+
+
+//==============================================================================
+//
+int main () {
+   std::cout << "test top clients starting (" << ACAI_VERSION_STRING << ")\n\n";
+
+   ACAI::Simulation::enable ();
+   for (int j = 0; j < NUMBER_OF_PVS; j++) {
+      ACAI::Simulation::definePv (pvNames [j], ACAI::ClientFieldDOUBLE);
+   }
+
+   ACAI::Client::initialise ();
+
+   ACAI::Client_Set* set = new ACAI::Client_Set (true);   // deep destruction
+   ACAI::Client* clients [NUMBER_OF_PVS];
+   for (int j = 0; j < NUMBER_OF_PVS; j++) {
+      clients [j] = new ACAI::Client (pvNames [j]);
+      set->insert (clients [j]);
+   }
+
+   // Insertion order is irrelevant to the ranking.
+   //
+   set->openAllChannels ();
+   settle ();
+   for (int j = 0; j < NUMBER_OF_PVS; j++) {
+      clients [j]->resetUpdateCounters ();
+   }
+
+   for (int j = 0; j < NUMBER_OF_PVS; j++) {
+      for (int k = 0; k < numberOfUpdates [j]; k++) {
+         ACAI::Simulation::postUpdate (pvNames [j]);
+      }
+   }
+   settle ();
+
+   std::cout << "ranking by updates received\n";
+   report ("top 3", set->topClients (3, ACAI::RankByUpdatesReceived));
+   report ("top 1", set->topClients (1, ACAI::RankByUpdatesReceived));
+   report ("top 10", set->topClients (10, ACAI::RankByUpdatesReceived));
+   report ("top 0", set->topClients (0, ACAI::RankByUpdatesReceived));
+   std::cout << "\n";
+
+   // Flood one PV without polling, so that the queue coalesces the excess
+   // updates. All are still counted as received.
+   //
+   std::cout << "coalesced updates\n";
+   ACAI::Client* flood = clients [0];
+   flood->resetUpdateCounters ();
+   ACAI::Client::resetStatistics ();
+   for (int k = 0; k < FLOOD_UPDATES; k++) {
+      ACAI::Simulation::postUpdate (pvNames [0]);
+   }
+   settle ();
+
+   ACAI::Client_Statistics statistics;
+   ACAI::Client::getStatistics (statistics);
+   std::cout << "  updates posted:     " << FLOOD_UPDATES << "\n";
+   std::cout << "  coalesced:          " << statistics.coalescedCount << "\n";
+   std::cout << "  updates dispatched: " << flood->updatesDispatched () << "\n";
+   std::cout << "  updates received:   " << flood->updatesReceived () << "\n";
+   report ("top 2", set->topClients (2, ACAI::RankByUpdatesReceived));
+
+   set->closeAllChannels ();
+   delete set;
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+   ACAI::Simulation::disable ();
+
+   std::cout << "\ntest top clients complete\n";
+   return 0;
+}
+
+// end
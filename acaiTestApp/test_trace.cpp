@@ -0,0 +1,109 @@
+// test_trace.cpp
+//
+// Exercises ACAI::Trace by calling Trace::record directly, so the library need
+// not be built with ACAI_TRACING. Checks ring wrap-around, the re-use of an
+// exited thread's ring, and the Chrome trace JSON output, which is written to
+// a temporary file and then copied to standard output. Event times are
+// synthetic, so the output is deterministic. See test_trace.out.
+//
+
+#include <iostream>
+#include <stdio.h>
+#include <acai_trace.h>
+#include <acai_version.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+
+#define RING_CAPACITY   64
+#define MAIN_EVENTS     70      // exceeds capacity, so wraps around
+#define TRACE_FILE      "test_trace.json"
+
+struct Worker {
+   epicsUInt64 origin;
+   int number;
+   epicsEventId done;
+};
+
+//------------------------------------------------------------------------------
+// Records number synthetic events, starting at origin nS, 1 uS apart. Odd events
+// have a duration of 0.5 uS, even events are instantaneous.
+//
+static void recordEvents (const epicsUInt64 origin, const int number)
+{
+   for (int k = 0; k < number; k++) {
+      const epicsUInt64 start = origin + epicsUInt64 (k) * 1000;
+      const epicsUInt64 finish = (k % 2) ? start + 500 : 0;
+      ACAI::Trace::record (ACAI::TraceKinds (k % ACAI::NUMBER_OF_TRACE_KINDS),
+                           (const void*) size_t (0x100 + k), start, finish, size_t (k));
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+static void workerThread (void* parm)
+{
+   Worker* worker = (Worker*) parm;
+   recordEvents (worker->origin, worker->number);
+   epicsEventSignal (worker->done);
+}
+
+//------------------------------------------------------------------------------
+// Runs a worker thread to completion, including its thread exit processing.
+//
+static void runWorker (const char* name, const epicsUInt64 origin, const int number)
+{
+   Worker worker;
+   worker.origin = origin;
+   worker.number = number;
+   worker.done = epicsEventCreate (epicsEventEmpty);
+
+   epicsThreadCreate (name, epicsThreadPriorityMedium,
+                      epicsThreadGetStackSize (epicsThreadStackSmall),
+                      workerThread, &worker);
+   epicsEventWait (worker.done);
+   epicsEventDestroy (worker.done);
+   epicsThreadSleep (0.2);     // allow the thread to exit
+}
+
+
+//==============================================================================
+//
+int main () {
+   std::cout << "test trace starting (" << ACAI_VERSION_STRING << ")\n\n";
+
+   ACAI::Trace::setRingCapacity (RING_CAPACITY);
+   std::cout << "ring capacity: " << ACAI::Trace::ringCapacity () << "\n";
+
+   recordEvents (1000000, MAIN_EVENTS);
+   std::cout << "main events recorded: " << MAIN_EVENTS
+             << ", held: " << ACAI::Trace::eventCount () << "\n";
+
+   // The first worker's ring, and its events, outlive the worker. The second
+   // worker then re-uses that ring.
+   //
+   runWorker ("trace_a", 2000000, 3);
+   std::cout << "after first worker, held: " << ACAI::Trace::eventCount () << "\n";
+
+   runWorker ("trace_b", 3000000, 2);
+   std::cout << "after second worker, held: " << ACAI::Trace::eventCount () << "\n";
+
+   std::cout << "write: " << (ACAI::Trace::writeChromeTrace (TRACE_FILE) ? "ok" : "failed") << "\n\n";
+
+   FILE* file = fopen (TRACE_FILE, "r");
+   if (file) {
+      char line [256];
+      while (fgets (line, sizeof (line), file)) {
+         std::cout << line;
+      }
+      fclose (file);
+      remove (TRACE_FILE);
+   }
+
+   ACAI::Trace::clear ();
+   std::cout << "\nafter clear, held: " << ACAI::Trace::eventCount () << "\n";
+
+   std::cout << "\ntest trace complete\n";
+   return 0;
+}
+
+// end
@@ -0,0 +1,142 @@
+// test_update_filter.cpp
+//
+// Exercises the subscription update filters, i.e. setUpdateDeadband,
+// setUpdateMinimumInterval and setUpdateMaximumRate, against the in-process
+// simulated backend. Checks that updates within the deadband are dropped,
+// that early updates are held and later released, and that alarm changes
+// always pass. No IOC is required. The minimum interval is real time, so the
+// test sleeps for longer than the interval where needed.
+// See test_update_filter.out.
+//
+
+#include <iostream>
+#include <acai_client_types.h>
+#include <acai_client.h>
+#include <acai_simulation.h>
+#include <acai_statistics.h>
+#include <acai_version.h>
+#include <epicsThread.h>
+
+#define PV_NAME    "SIM:FILTER"
+#define INTERVAL   0.2
+
+//------------------------------------------------------------------------------
+// Counts the updates actually delivered.
+//
+class Counting_Client : public ACAI::Client {
+public:
+   explicit Counting_Client (const ACAI::ClientString& pvName) :
+      ACAI::Client (pvName), updates (0) { }
+
+   int updates;
+
+protected:
+   void dataUpdate (const bool firstUpdate)
+   {
+      this->updates++;
+   }
+};
+
+//------------------------------------------------------------------------------
+//
+static void settle ()
+{
+   for (int j = 0; j < 5; j++) {
+      ACAI::Client::poll ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+static void report (const char* title, Counting_Client* client)
+{
+   settle ();
+
+   ACAI::Client_Statistics statistics;
+   ACAI::Client::getStatistics (statistics);
+
+   std::cout << "  " << title << ": updates " << client->updates
+             << ", value " << client->getFloating ()
+             << ", severity " << int (client->alarmSeverity ())
+             << ", filtered " << client->filteredUpdateCount ()
+             << ", held " << statistics.heldCount << "\n";
+   client->updates = 0;
+}
+
+
+//==============================================================================
+//
+int main () {
+   std::cout << "test update filter starting (" << ACAI_VERSION_STRING << ")\n\n";
+
+   ACAI::Simulation::enable ();
+   ACAI::Simulation::definePv (PV_NAME, ACAI::ClientFieldDOUBLE);
+
+   ACAI::Client::initialise ();
+
+   Counting_Client* client = new Counting_Client (PV_NAME);
+   ACAI::Client* writer = new ACAI::Client (PV_NAME);
+   writer->setReadMode (ACAI::NoRead);
+   client->openChannel ();
+   writer->openChannel ();
+   report ("initial", client);
+   std::cout << "\n";
+
+   std::cout << "deadband\n";
+   client->setUpdateDeadband (0.5);
+   writer->putFloating (10.0);
+   writer->putFloating (10.3);    // within deadband of 10.0
+   writer->putFloating (10.6);
+   writer->putFloating (10.8);    // within deadband of 10.6
+   report ("after puts", client);
+   std::cout << "\n";
+
+   std::cout << "alarm change\n";
+   ACAI::Simulation::setAlarm (PV_NAME, ACAI::ClientSevMinor, ACAI::ClientAlarmHigh);
+   report ("new alarm", client);
+   ACAI::Simulation::setAlarm (PV_NAME, ACAI::ClientSevMinor, ACAI::ClientAlarmHigh);
+   report ("same alarm", client);
+   std::cout << "\n";
+
+   std::cout << "minimum interval\n";
+   client->setUpdateDeadband (0.0);
+   client->setUpdateMinimumInterval (INTERVAL);
+   writer->putFloating (20.0);
+   writer->putFloating (21.0);    // held
+   writer->putFloating (22.0);    // held, replaces 21
+   report ("within interval", client);
+   epicsThreadSleep (1.5 * INTERVAL);
+   report ("after interval", client);
+
+   // An alarm change is never held, and supersedes any held update.
+   //
+   writer->putFloating (23.0);    // held
+   ACAI::Simulation::setAlarm (PV_NAME, ACAI::ClientSevNone, ACAI::ClientAlarmNone);
+   report ("alarm change", client);
+   std::cout << "\n";
+
+   std::cout << "maximum rate\n";
+   client->setUpdateMaximumRate (1.0 / INTERVAL);
+   std::cout << "  minimum interval: " << client->updateMinimumInterval () << "\n";
+   writer->putFloating (30.0);    // held
+   report ("within interval", client);
+
+   // Disabling the rate limit releases the held update.
+   //
+   client->setUpdateMaximumRate (0.0);
+   std::cout << "  minimum interval: " << client->updateMinimumInterval () << "\n";
+   report ("rate disabled", client);
+
+   client->closeChannel ();
+   writer->closeChannel ();
+   delete client;
+   delete writer;
+   ACAI::Client::poll ();
+   ACAI::Client::finalise ();
+   ACAI::Simulation::disable ();
+
+   std::cout << "\ntest update filter complete\n";
+   return 0;
+}
+
+// end